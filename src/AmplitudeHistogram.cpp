@@ -0,0 +1,196 @@
+/**
+ * \file AmplitudeHistogram.cpp
+ * \brief Accumulates a histogram of the ADC values of every channel
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "AmplitudeHistogram.h"
+#include "ChaosRecord.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Samples of one channel counted by each job
+#define POINTS_PER_JOB 4096
+
+// Size of the partial histograms of one thread
+#define PARTIAL_SIZE (ChaosCapture::NUM_CHANNELS*HISTOGRAM_LANES*HISTOGRAM_BINS)
+
+AmplitudeHistogram::AmplitudeHistogram() {
+    /**
+    *   Constructor for the AmplitudeHistogram class.
+    *
+    *   Counts how often every ADC value occurs on each channel, which
+    *   approximates the invariant density of the attractor as the number of
+    *   captures grows.  The totals are 64 bit so they can keep accumulating
+    *   for as long as the circuit runs.
+    */
+    record_generation = ChaosRecord::getGeneration();
+    record_position = ChaosRecord::getEnd();
+    partials = NULL;
+    thread_used = NULL;
+    num_threads = 0;
+    num_points = 0;
+    jobs_per_channel = 0;
+    clear();
+}
+
+AmplitudeHistogram::~AmplitudeHistogram() {
+    /**
+    *   Destructor for the AmplitudeHistogram class
+    */
+    free(partials);
+    free(thread_used);
+}
+
+void AmplitudeHistogram::update() {
+    /**
+    *   Counts everything recorded since the last call, one run of the
+    *   record at a time.  Each run is split into jobs on the worker pool.
+    *   Each thread counts into its own partial histograms and the partials
+    *   are added into the totals once every run is done.
+    */
+    if(record_generation == ChaosRecord::getGeneration()) {
+        return;
+    }
+    record_generation = ChaosRecord::getGeneration();
+
+    if(record_position < ChaosRecord::getStart()) {
+        record_position = ChaosRecord::getStart();
+    }
+    if(record_position >= ChaosRecord::getEnd()) {
+        return;
+    }
+
+    int threads = ChaosWorkers::getNumThreads();
+    if(threads > num_threads) {
+        partials = (unsigned int*)realloc(partials, threads*PARTIAL_SIZE*sizeof(unsigned int));
+        thread_used = (bool*)realloc(thread_used, threads*sizeof(bool));
+        memset(partials, 0, threads*PARTIAL_SIZE*sizeof(unsigned int));
+        num_threads = threads;
+    }
+    for(int t = 0; t < num_threads; t++) {
+        thread_used[t] = false;
+    }
+
+    bool capture_start;
+    while((num_points = ChaosRecord::getRun(record_position, 0, &run_data[0], &capture_start)) > 0) {
+        for(int c = 1; c < ChaosCapture::NUM_CHANNELS; c++) {
+            ChaosRecord::getRun(record_position, c, &run_data[c], &capture_start);
+        }
+        jobs_per_channel = (num_points + POINTS_PER_JOB - 1)/POINTS_PER_JOB;
+        ChaosWorkers::run(this, jobs_per_channel*ChaosCapture::NUM_CHANNELS);
+        num_samples += num_points;
+        record_position += num_points;
+    }
+
+    mergePartials();
+}
+
+void AmplitudeHistogram::runJob(int job, int thread) {
+    /**
+    *   Counts one block of one channel into the thread's partial histograms.
+    *
+    *   Samples go round robin to the lanes so that runs of equal values,
+    *   which are common on the slow parts of the trajectory, do not make
+    *   each increment wait for the one before it.  Bins come from masking
+    *   the sample, so there are no range checks, and with SSE2 eight
+    *   samples are loaded and masked at once.
+    */
+    int channel = job/jobs_per_channel;
+    int start = (job % jobs_per_channel)*POINTS_PER_JOB;
+    int end = start + POINTS_PER_JOB;
+    if(end > num_points) end = num_points;
+
+    const short* data = run_data[channel];
+    unsigned int* lane0 = partials + (thread*ChaosCapture::NUM_CHANNELS + channel)*HISTOGRAM_LANES*HISTOGRAM_BINS;
+    unsigned int* lane1 = lane0 + HISTOGRAM_BINS;
+    unsigned int* lane2 = lane1 + HISTOGRAM_BINS;
+    unsigned int* lane3 = lane2 + HISTOGRAM_BINS;
+    thread_used[thread] = true;
+
+    int i = start;
+#ifdef __SSE2__
+    __m128i mask = _mm_set1_epi16(HISTOGRAM_BINS - 1);
+    unsigned short bins[8];
+    for(; i + 8 <= end; i += 8) {
+        __m128i x = _mm_and_si128(_mm_loadu_si128((const __m128i*)(data + i)), mask);
+        _mm_storeu_si128((__m128i*)bins, x);
+        lane0[bins[0]]++;
+        lane1[bins[1]]++;
+        lane2[bins[2]]++;
+        lane3[bins[3]]++;
+        lane0[bins[4]]++;
+        lane1[bins[5]]++;
+        lane2[bins[6]]++;
+        lane3[bins[7]]++;
+    }
+#else
+    for(; i + 4 <= end; i += 4) {
+        lane0[data[i] & (HISTOGRAM_BINS - 1)]++;
+        lane1[data[i + 1] & (HISTOGRAM_BINS - 1)]++;
+        lane2[data[i + 2] & (HISTOGRAM_BINS - 1)]++;
+        lane3[data[i + 3] & (HISTOGRAM_BINS - 1)]++;
+    }
+#endif
+    for(; i < end; i++) {
+        lane0[data[i] & (HISTOGRAM_BINS - 1)]++;
+    }
+}
+
+void AmplitudeHistogram::mergePartials() {
+    /**
+    *   Adds the partial histograms of every thread that did work into the
+    *   totals and zeroes them for the next update.
+    */
+    for(int t = 0; t < num_threads; t++) {
+        if(!thread_used[t]) {
+            continue;
+        }
+        unsigned int* partial = partials + t*PARTIAL_SIZE;
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            unsigned int* lanes = partial + c*HISTOGRAM_LANES*HISTOGRAM_BINS;
+            for(int b = 0; b < HISTOGRAM_BINS; b++) {
+                counts[c][b] += (unsigned long long)lanes[b] + lanes[HISTOGRAM_BINS + b] +
+                                lanes[2*HISTOGRAM_BINS + b] + lanes[3*HISTOGRAM_BINS + b];
+            }
+        }
+        memset(partial, 0, PARTIAL_SIZE*sizeof(unsigned int));
+    }
+}
+
+void AmplitudeHistogram::clear() {
+    /**
+    *   Throws away the counts and starts again from the next samples
+    *   recorded
+    */
+    memset(counts, 0, sizeof(counts));
+    num_samples = 0;
+}
+
+unsigned long long AmplitudeHistogram::getNumSamples() {
+    /**
+    *   Returns the number of samples counted on each channel
+    */
+    return num_samples;
+}
+
+const unsigned long long* AmplitudeHistogram::getCounts(int channel) {
+    /**
+    *   Returns the HISTOGRAM_BINS counts of a channel
+    */
+    return counts[channel];
+}
+
+unsigned long long AmplitudeHistogram::getMaxCount(int channel) {
+    /**
+    *   Returns the count of the fullest bin of a channel
+    */
+    unsigned long long maximum = 0;
+    for(int b = 0; b < HISTOGRAM_BINS; b++) {
+        if(counts[channel][b] > maximum) maximum = counts[channel][b];
+    }
+    return maximum;
+}
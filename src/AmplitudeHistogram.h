@@ -0,0 +1,56 @@
+/**
+ * \file AmplitudeHistogram.h
+ * \brief Headers for AmplitudeHistogram.cpp
+ */
+
+#ifndef AMPLITUDEHISTOGRAM_H
+#define AMPLITUDEHISTOGRAM_H
+
+#include "ChaosWorkers.h"
+#include "ChaosCapture.h"
+
+// One bin for every value of the 10-bit ADC
+#define HISTOGRAM_BINS 1024
+
+// Interleaved sub-histograms per thread so that neighbouring samples that
+// fall in the same bin do not wait on each other's increments
+#define HISTOGRAM_LANES 4
+
+class AmplitudeHistogram : public ChaosTask
+{
+    public:
+        // class constructor
+        AmplitudeHistogram();
+        // class destructor
+        ~AmplitudeHistogram();
+        void update();
+        void clear();
+        unsigned long long getNumSamples();
+        const unsigned long long* getCounts(int channel);
+        unsigned long long getMaxCount(int channel);
+
+        void runJob(int job, int thread);
+
+    private:
+        void mergePartials();
+
+        // Position in ChaosRecord up to which the samples have been counted
+        unsigned int record_generation;
+        long long record_position;
+
+        // Totals of every capture since the last clear
+        unsigned long long counts[ChaosCapture::NUM_CHANNELS][HISTOGRAM_BINS];
+        unsigned long long num_samples;
+
+        // Per thread partial histograms, HISTOGRAM_LANES per channel
+        unsigned int* partials;
+        bool* thread_used;
+        int num_threads;
+
+        // Run of the record being counted by the jobs
+        const short* run_data[ChaosCapture::NUM_CHANNELS];
+        int num_points;
+        int jobs_per_channel;
+};
+
+#endif // AMPLITUDEHISTOGRAM_H
@@ -4,6 +4,8 @@
  */
   
 #include "BifurcationPlot.h"
+#include "ChaosCalibration.h"
+#include "ChaosCapture.h"
 
 // class constructor
 BifurcationPlot::BifurcationPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
@@ -22,11 +24,11 @@ BifurcationPlot::BifurcationPlot(wxWindow* parent, wxWindowID id, const wxPoint&
     Connect( wxID_ANY, wxEVT_LEFT_DCLICK,
                     (wxObjectEventFunction) &BifurcationPlot::OnDblClick );
     paused = ChaosSettings::Paused;
+    collecting = true;
     graph_title = wxT("Bifurcation Plot");
     graph_subtitle = wxT("Peaks (V) vs. Mdac value");
     zoomable_graph = true;
     ChaosSettings::BifRedraw = true;
-    bifBmp = NULL;
 }
 
 // class destructor
@@ -40,38 +42,24 @@ void BifurcationPlot::drawPlot() {
     /**
     *   Main drawing function for the plot classes.
     *
-    *   The bifurcation plot is stored in a wxBitmap object so that we don't
-    *   have to recalculate and draw every point every time we refresh the
-    *   screen.  Since all of the ChaosPlots are buffered, this means that
-    *   the Bifurcation drawing functions actually go through two buffers.
-    *   This is not the most efficient way to do this, but it does allow us
-    *   to use the functionality of the ChaosPlot subclass.
-    *
-    *   Steps for drawing:
+    *   The points of the bifurcation plot are kept in the raster from
+    *   frame to frame so that we don't have to recalculate and draw every
+    *   point every time we refresh the screen.
     *
     *   Calculate X & Y axis values and size.
     *
-    *   Store our current size.
-    *
     *   Calls startDraw() to initalize the drawing DC. (Updates size)
     *
-    *   Compare old size with current size to determine if it needs to redraw everything.
-    *
-    *   If so, draw axis on BufferedDC and copy them over to the MemoryDC,
-    *   then redraw all points.
+    *   If everything is to be drawn again, or the graph has moved so the
+    *   raster could not be kept, draw all of the cached points.
     *
     *   If not, collect points for up to 2 MDAC values and only draw 
-    *   the new points on the MemoryDC.
-    *
-    *   Draw the MDAC reference line on the graph.
-    *
-    *   Finally, copy the MemoryDC over to the BufferedDC and draw it to the DC.
+    *   the new points over the raster.
     *
+    *   The MDAC reference line is drawn on top by drawOverlay().
     */
-    float x_min, x_max;
     float y_min, y_max;
     wxString xaxis_title;
-    wxMemoryDC bifMemDC;
     
     // Get information for the X axis
     if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) {
@@ -80,93 +68,55 @@ void BifurcationPlot::drawPlot() {
         xaxis_title = wxString(wxT("Resistance (Ohms)"));
     }
 
-    // Get scaling/label information for the Y axis
-    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-        graph_subtitle = wxString::Format(wxT("Peaks (V) vs. %s"), xaxis_title.c_str());
-        y_min = smallest_y_value*3.3/1024;
-        y_max = largest_y_value*3.3/1024;
-        x_min = smallest_x_value*3.3/1024;
-        x_max = largest_x_value*3.3/1024;
-    } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-        graph_subtitle = wxString::Format(wxT("Peaks (V) vs. %s"), xaxis_title.c_str());
-        y_min = smallest_y_value*3.3/1024 - 1.2;
-        y_max = largest_y_value*3.3/1024 - 1.2;
-        x_min = smallest_x_value*3.3/1024 - 1.2;
-        x_max = largest_x_value*3.3/1024 - 1.2;
-    } else {
+    // Get scaling/label information for the Y axis, the peaks are of X1
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
         graph_subtitle = wxString::Format(wxT("Peaks (ADC) vs. %s"), xaxis_title.c_str());
-        y_min = smallest_y_value;
-        y_max = largest_y_value;
-        x_min = smallest_x_value;
-        x_max = largest_x_value;
+    } else {
+        graph_subtitle = wxString::Format(wxT("Peaks (V) vs. %s"), xaxis_title.c_str());
     }
-    
-    // Store old size information for future comparison
-    int old_width = width;
-    int old_height = height;
+    y_min = ChaosCalibration::toUnits(ChaosCapture::X1, smallest_y_value);
+    y_max = ChaosCalibration::toUnits(ChaosCapture::X1, largest_y_value);
     
     // Update size and draw background & titles
     startDraw();
     
-    // Check and see if the size of the graph has changed
-    // If it has, we need to redraw our cached image
-    if(old_width != width || old_height != height) {
-        ChaosSettings::BifRedraw = true;
-    }
+    // Draw the Y axis on the buffered DC.  The axes are only drawn again
+    // when they change, so they are drawn every frame to keep the layer
+    // they are cached in up to date.
+    drawYAxis(y_min, y_max, (y_max-y_min)/4.0);
     
-    // Do we need to redraw everything that we have cached?
-    if(ChaosSettings::BifRedraw == true) {
-        // Draw the Y axis on the buffered DC
-        drawYAxis(y_min, y_max, (y_max-y_min)/4.0);
-        
-        // Draw the X axis on the buffered DC
-        if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) { 
-            drawXAxis(float(largest_x_value),
-                  float(smallest_x_value),
-                  -1*((largest_x_value-smallest_x_value)/4));
-        } else {
-            float min = libchaos_mdacToResistance(largest_x_value);
-            float max = libchaos_mdacToResistance(smallest_x_value);
-            drawXAxis(min, max, ((max-min)/4));
-        }
-        
-        // If we aren't connected, then we're done
-        if(device_connected == false) {
-            endDraw();
-            return;
-        }
-
-        // if we already have a cached image, delete it
-        if(bifBmp)
-            delete bifBmp;
-            
-        // Create a bitmap to cache our bifurcation drawing to
-        bifBmp = new wxBitmap(width, height);
-        
-        // Select the bitmap to a memory DC so we can draw on it and initialize it with a background
-        bifMemDC.SelectObject(*bifBmp);
-        bifMemDC.SetBrush(dc->GetBackground());
-        bifMemDC.SetPen(*wxTRANSPARENT_PEN);
-        bifMemDC.DrawRectangle(0,0,width,height);
-        
-        // Copy what we have on the buffer so far (title, axis, labels) to the cache
-        bifMemDC.Blit(0, 0, width, height, buffer, 0, 0);
+    // Draw the X axis on the buffered DC
+    if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) { 
+        drawXAxis(float(largest_x_value),
+              float(smallest_x_value),
+              -1*((largest_x_value-smallest_x_value)/4));
     } else {
-        // No need to redraw everything, just select the cache so we can draw more onto it
-        bifMemDC.SelectObject(*bifBmp);
+        float min = ChaosCalibration::mdacToResistance(largest_x_value);
+        float max = ChaosCalibration::mdacToResistance(smallest_x_value);
+        drawXAxis(min, max, ((max-min)/4));
+    }
+    
+    // Do we need to redraw everything that we have cached?  The raster
+    // keeps the points drawn so far unless the graph has moved.
+    bool redraw = ChaosSettings::BifRedraw;
+    if(startRaster(!redraw) == false) {
+        redraw = true;
+    }
+    
+    // If we aren't connected, then we're done
+    if(redraw == true && device_connected == false) {
+        ChaosSettings::BifRedraw = true;
+        endDraw();
+        return;
     }
-
-    //Use blue pen
-    wxPen bluePen(*wxBLUE, 1); // blue pen of width 1
-    wxBrush blueBrush(*wxBLUE_BRUSH);
-    bifMemDC.SetPen(bluePen);
-    bifMemDC.SetBrush(blueBrush);
 
     int* peaks;
     int new_points;
     int step = (int)(float(graph_width) / float(ChaosSettings::BifStepsPerWindow));
     
     if(step == 0) step = 1;
+    wxPoint* points = raster.getPoints((graph_width/step + 1)*ChaosSettings::PeaksPerMdac);
+    int num_points = 0;
     
     // If we are paused, don't collect new data points
     if(paused || ChaosSettings::Paused) {
@@ -193,48 +143,54 @@ void BifurcationPlot::drawPlot() {
         bool cacheHit = libchaos_peaksCacheHit(mdac_value);
 
         if(!cacheHit) new_points--;
-        if((ChaosSettings::BifRedraw && cacheHit) || (!cacheHit && new_points > 0)) {
+        if((redraw && cacheHit) || (!cacheHit && new_points > 0)) {
 
             peaks = libchaos_getPeaks(mdac_value);
             if(cacheHit == false) {
                 miss_mdac = mdac_value;
             }
             
-            bifMemDC.SetPen(bluePen);
+            int x = valueToX(mdac_value);
             for(int j = 0; j < ChaosSettings::PeaksPerMdac; j++) {
                 int y = valueToY(peaks[j]);
                 if(y < graph_height + top_gutter_size && y > top_gutter_size) {
-                    drawPoint(&bifMemDC, valueToX(mdac_value), y);
+                    points[num_points++] = wxPoint(x, y);
                 }
             }
         }
         
     }
     
-    if( new_points > 0 ) libchaos_enableFFT();
+    // Use blue points
+    raster.setColour(*wxBLUE);
+    drawPoints(points, num_points);
+    endRaster();
+    
+    // The library transform stays off while the fixed point one is used
+    if( new_points > 0 && ChaosSettings::SpectrumMode == ChaosSettings::FFT_LIBRARY ) libchaos_enableFFT();
     
     if(miss_mdac != -1) {
         device_mdac_value = miss_mdac;
     }
+    collecting = (miss_mdac != -1);
     
     // We're finished redrawing everything, so don't do it again unless we need to
     if(ChaosSettings::BifRedraw == true) {
         ChaosSettings::BifRedraw = false;
     }
 
-    // Copy our cache onto the buffered DC
-    // (It is redundant to use a MemoryDC and a BufferedDC, it may be more efficient
-    // to not use the BufferedDC for the bifurcation)
-    buffer->Blit(0,0, width, height, &bifMemDC, 0, 0);
-    
-    // Draw the line for the MDAC
-    drawMdacLine(buffer);
-    
     // Flush the buffer and output to the screen.
     endDraw();
 
 }
 
+void BifurcationPlot::drawOverlay() {
+    /**
+    *   Draws the line for the MDAC on top of the points
+    */
+    drawMdacLine(buffer);
+}
+
 void BifurcationPlot::OnMouseUp(wxMouseEvent& evt) {
     /**
     *   Event handler for the mouse up on a plot.
@@ -292,6 +248,7 @@ void BifurcationPlot::OnMouseUp(wxMouseEvent& evt) {
         wxLogMessage(wxT("x_min: %d\nx_max: %d"), smallest_x_value, largest_x_value);
     }
     mouse_dragging = false;
+    invalidate();
 }
 
 void BifurcationPlot::drawMdacLine(wxDC* dc) {
@@ -323,9 +280,9 @@ int BifurcationPlot::valueToX(int mdac_value) {
     if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) {  
         return side_gutter_size + (int)(((largest_x_value - mdac_value)/float(largest_x_value-smallest_x_value))*graph_width);
     } else {
-        float min = libchaos_mdacToResistance(smallest_x_value);
-        float max = libchaos_mdacToResistance(largest_x_value);
-        float mdac = libchaos_mdacToResistance(mdac_value);
+        float min = ChaosCalibration::mdacToResistance(smallest_x_value);
+        float max = ChaosCalibration::mdacToResistance(largest_x_value);
+        float mdac = ChaosCalibration::mdacToResistance(mdac_value);
         return side_gutter_size + (int)(((max - mdac)/float(max-min))*graph_width);
     }
 }
@@ -338,11 +295,11 @@ int BifurcationPlot::xToValue(int x) {
     if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) { 
         return largest_x_value - (int)((float(x - side_gutter_size)/graph_width)*float(largest_x_value-smallest_x_value));
     } else {
-        float min = libchaos_mdacToResistance(largest_x_value);
-        float max = libchaos_mdacToResistance(smallest_x_value);
-        int resistance = libchaos_mdacToResistance(largest_x_value) + int((float(x - side_gutter_size)/graph_width)*float(max-min));
-        int mdac = libchaos_resistanceToMdac(resistance);
-        wxLogMessage(wxT("Resistance: %d MDAC: %d"), resistance, mdac);
+        float min = ChaosCalibration::mdacToResistance(largest_x_value);
+        float max = ChaosCalibration::mdacToResistance(smallest_x_value);
+        float resistance = min + (float(x - side_gutter_size)/graph_width)*(max-min);
+        int mdac = ChaosCalibration::resistanceToMdac(resistance);
+        wxLogMessage(wxT("Resistance: %.0f MDAC: %d"), resistance, mdac);
         return mdac;
     }
 }
@@ -399,6 +356,19 @@ void BifurcationPlot::setPause(bool pause) {
     *   Pauses or unpauses the bifurcation based on the flag passed in.
     */
     paused = pause;
+    invalidate();
+}
+
+bool BifurcationPlot::needsRedraw() {
+    /**
+    *   The bifurcation collects its peaks as it is drawn, so it keeps
+    *   asking for frames until every MDAC value on screen has been
+    *   collected, unless it is paused.
+    */
+    if(ChaosPlot::needsRedraw() || ChaosSettings::BifRedraw) {
+        return true;
+    }
+    return collecting && !paused && !ChaosSettings::Paused;
 }
 
 void BifurcationPlot::UpdateStatusBar(int m_x, int m_y) {
@@ -410,14 +380,10 @@ void BifurcationPlot::UpdateStatusBar(int m_x, int m_y) {
         x = xToValue(m_x);
         y = yToValue(m_y);
         
-        if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-            y = y*3.3/1024 - 1.2;
-        } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-            y = y*3.3/1024;
-        }
+        y = ChaosCalibration::toUnits(ChaosCapture::X1, y);
         
         if(ChaosSettings::BifXAxis == ChaosSettings::RESISTANCE_VALUES) {
-            x = libchaos_mdacToResistance((int)x)/1000;
+            x = ChaosCalibration::mdacToResistance((int)x)/1000;
             statusBar->SetStatusText(wxString::Format(wxT("(%.3fk,%.3f)"),
                                         x,
                                         y), 3);
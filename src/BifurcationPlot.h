@@ -25,9 +25,11 @@ class BifurcationPlot : public ChaosPlot
         ~BifurcationPlot();
         void drawPlot();
         void setPause(bool pause);
+        bool needsRedraw();
     private: 
         // Functions
         void drawMdacLine(wxDC* dc);
+        void drawOverlay();
         int valueToX(int mdac_value);
         int xToValue(int x);
         int valueToY(int y);
@@ -36,13 +38,14 @@ class BifurcationPlot : public ChaosPlot
         int xToMdac(int x);
         void UpdateStatusBar(int m_x, int m_y);
     
-        wxBitmap* bifBmp;
-        
         // Event handlers
         void OnDblClick(wxMouseEvent& evt);
         void OnMouseUp(wxMouseEvent& evt);
         
         bool paused;
+        
+        // True while the last frame found MDAC values with no peaks yet
+        bool collecting;
 };
 
 #endif // BIFURCATIONPLOT_H
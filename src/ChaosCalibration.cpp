@@ -0,0 +1,283 @@
+/**
+ * \file ChaosCalibration.cpp
+ * \brief Per unit calibration and unit conversion tables
+ */
+
+#include <wx/wx.h>
+#include <wx/fileconf.h>
+#include "ChaosCalibration.h"
+#include "ChaosCapture.h"
+#include "ChaosSettings.h"
+#include "libchaos.h"
+
+// Nominal calibration of a channel: a 10-bit ADC over 3.3V biased at 1.2V
+#define NOMINAL_GAIN (3.3/1024)
+#define NOMINAL_OFFSET 0.0
+#define NOMINAL_BIAS 1.2
+
+// Number of units in ChaosSettings::YAxisLabels
+#define NUM_UNITS 3
+
+namespace ChaosCalibration {
+    /**
+    *   Calibration of the connected unit and the tables worked out from it.
+    *   Voltages from ground are gain*adc + offset and voltages from the
+    *   bias point subtract the bias of the channel as well.  Resistances
+    *   are the nominal resistance of libchaos scaled by resistance_gain.
+    */
+    double gain[ChaosCapture::NUM_CHANNELS];
+    double offset[ChaosCapture::NUM_CHANNELS];
+    double bias[ChaosCapture::NUM_CHANNELS];
+    double resistance_gain;
+
+    float scale[NUM_UNITS][ChaosCapture::NUM_CHANNELS];
+    float zero[NUM_UNITS][ChaosCapture::NUM_CHANNELS];
+    float tables[NUM_UNITS][ChaosCapture::NUM_CHANNELS][CALIBRATION_ADC_VALUES];
+    float resistance[CALIBRATION_MDAC_VALUES];
+    bool resistance_decreasing = true;
+
+    wxString unit_name;
+    bool device_loaded = false;
+    unsigned int version = 0;
+
+    const char* channel_keys[ChaosCapture::NUM_CHANNELS] = { "X1", "X2", "X3" };
+
+    void setNominal() {
+        /**
+        *   Sets the calibration to the values the circuit is designed for
+        */
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            gain[c] = NOMINAL_GAIN;
+            offset[c] = NOMINAL_OFFSET;
+            bias[c] = NOMINAL_BIAS;
+        }
+        resistance_gain = 1.0;
+    }
+
+    void buildTables() {
+        /**
+        *   Works out the conversion of every ADC value to every unit and the
+        *   resistance of every MDAC tap.  Only done when the calibration
+        *   changes so the conversions never have to be repeated per point.
+        */
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            scale[ChaosSettings::Y_AXIS_ADC][c] = 1;
+            zero[ChaosSettings::Y_AXIS_ADC][c] = 0;
+            scale[ChaosSettings::Y_AXIS_VGND][c] = gain[c];
+            zero[ChaosSettings::Y_AXIS_VGND][c] = offset[c];
+            scale[ChaosSettings::Y_AXIS_VBIAS][c] = gain[c];
+            zero[ChaosSettings::Y_AXIS_VBIAS][c] = offset[c] - bias[c];
+        }
+
+        for(int u = 0; u < NUM_UNITS; u++) {
+            for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+                for(int i = 0; i < CALIBRATION_ADC_VALUES; i++) {
+                    tables[u][c][i] = scale[u][c]*i + zero[u][c];
+                }
+            }
+        }
+
+        for(int i = 0; i < CALIBRATION_MDAC_VALUES; i++) {
+            resistance[i] = resistance_gain*libchaos_mdacToResistance(i);
+        }
+        resistance_decreasing = resistance[0] > resistance[CALIBRATION_MDAC_VALUES - 1];
+
+        version++;
+        ChaosSettings::BifRedraw = true;
+    }
+
+    void load() {
+        /**
+        *   Reads the calibration of the connected unit, falling back to the
+        *   nominal values for anything that has not been saved.
+        */
+        wxFileConfig config(wxT("ChaosConnect"), wxEmptyString, wxT("calibration.ini"),
+                            wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        config.SetPath(wxT("/") + unit_name);
+
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            wxString key = wxString::FromAscii(channel_keys[c]);
+            config.Read(key + wxT("/Gain"), &gain[c], NOMINAL_GAIN);
+            config.Read(key + wxT("/Offset"), &offset[c], NOMINAL_OFFSET);
+            config.Read(key + wxT("/Bias"), &bias[c], NOMINAL_BIAS);
+        }
+        config.Read(wxT("ResistanceGain"), &resistance_gain, 1.0);
+
+        wxLogMessage(wxT("Loaded calibration for %s"), unit_name.c_str());
+    }
+
+    void save() {
+        /**
+        *   Writes the calibration of the connected unit
+        */
+        wxFileConfig config(wxT("ChaosConnect"), wxEmptyString, wxT("calibration.ini"),
+                            wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        config.SetPath(wxT("/") + unit_name);
+
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            wxString key = wxString::FromAscii(channel_keys[c]);
+            config.Write(key + wxT("/Gain"), gain[c]);
+            config.Write(key + wxT("/Offset"), offset[c]);
+            config.Write(key + wxT("/Bias"), bias[c]);
+        }
+        config.Write(wxT("ResistanceGain"), resistance_gain);
+        config.Flush();
+    }
+
+    void init() {
+        /**
+        *   Builds the tables from the nominal calibration so that they can
+        *   be used before a unit connects.
+        */
+        setNominal();
+        unit_name = wxT("Default");
+        device_loaded = false;
+        buildTables();
+    }
+
+    void setDeviceStatus(bool connected) {
+        /**
+        *   Loads the calibration of a unit the first time it is seen after
+        *   connecting.  libchaos does not report a serial number, so units
+        *   are told apart by their firmware version.
+        */
+        if(!connected) {
+            device_loaded = false;
+            return;
+        }
+        if(device_loaded) {
+            return;
+        }
+
+        unit_name = wxString::Format(wxT("Unit%d"), libchaos_getFirmwareVersion());
+        device_loaded = true;
+        load();
+        buildTables();
+    }
+
+    const wxString& getUnitName() {
+        /**
+        *   Returns the name the calibration is stored under
+        */
+        return unit_name;
+    }
+
+    bool measureBias() {
+        /**
+        *   Takes the mean of each channel of the current capture as the bias
+        *   voltage of that channel.  The circuit oscillates about its bias
+        *   point, so this centers the Y_AXIS_VBIAS units on the real bias of
+        *   the unit instead of the nominal 1.2V.  Returns false if there is
+        *   no capture to measure.
+        */
+        int num_points = ChaosCapture::getNumPoints();
+        if(num_points == 0) {
+            return false;
+        }
+
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            const short* data = ChaosCapture::getChannel(c);
+            double sum = 0;
+            for(int i = 0; i < num_points; i++) {
+                sum += data[i];
+            }
+            bias[c] = gain[c]*(sum/num_points) + offset[c];
+            wxLogMessage(wxT("%s bias: %.4fV"), wxString::FromAscii(channel_keys[c]).c_str(), bias[c]);
+        }
+
+        buildTables();
+        save();
+        return true;
+    }
+
+    void reset() {
+        /**
+        *   Returns the connected unit to the nominal calibration
+        */
+        setNominal();
+        buildTables();
+        save();
+    }
+
+    unsigned int getVersion() {
+        /**
+        *   Returns a number that changes whenever the calibration changes
+        */
+        return version;
+    }
+
+    float toUnits(int channel, float adc) {
+        /**
+        *   Converts an ADC value, which need not be a whole number or in the
+        *   range of the ADC, to the current units.
+        */
+        int u = ChaosSettings::YAxisLabels;
+        return scale[u][channel]*adc + zero[u][channel];
+    }
+
+    float toAdc(int channel, float value) {
+        /**
+        *   Converts a value in the current units back to an ADC value
+        */
+        int u = ChaosSettings::YAxisLabels;
+        return (value - zero[u][channel])/scale[u][channel];
+    }
+
+    float getScale(int channel) {
+        /**
+        *   Returns the size of one ADC count in the current units
+        */
+        return scale[ChaosSettings::YAxisLabels][channel];
+    }
+
+    float getOffset(int channel) {
+        /**
+        *   Returns the value of an ADC reading of 0 in the current units
+        */
+        return zero[ChaosSettings::YAxisLabels][channel];
+    }
+
+    const float* getTable(int channel) {
+        /**
+        *   Returns the conversion of every ADC value of a channel to the
+        *   current units
+        */
+        return tables[ChaosSettings::YAxisLabels][channel];
+    }
+
+    float mdacToResistance(int mdac) {
+        /**
+        *   Looks up the resistance of an MDAC tap.  Taps outside the MDAC
+        *   are clamped to its ends.
+        */
+        if(mdac < 0) {
+            mdac = 0;
+        } else if(mdac >= CALIBRATION_MDAC_VALUES) {
+            mdac = CALIBRATION_MDAC_VALUES - 1;
+        }
+        return resistance[mdac];
+    }
+
+    int resistanceToMdac(float value) {
+        /**
+        *   Binary search of the resistance table for the tap closest to a
+        *   resistance.  The table is monotonic in either direction.
+        */
+        int low = 0;
+        int high = CALIBRATION_MDAC_VALUES - 1;
+        while(high - low > 1) {
+            int middle = (low + high)/2;
+            if((resistance[middle] > value) == resistance_decreasing) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+
+        float low_error = resistance[low] - value;
+        float high_error = resistance[high] - value;
+        if(low_error < 0) low_error = -low_error;
+        if(high_error < 0) high_error = -high_error;
+        return low_error <= high_error ? low : high;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * \file ChaosCalibration.h
+ * \brief Headers for ChaosCalibration.cpp
+ */
+
+#ifndef CHAOSCALIBRATION_H
+#define CHAOSCALIBRATION_H
+
+#include <wx/string.h>
+
+// Number of values the ADC of a channel can return
+#define CALIBRATION_ADC_VALUES 1024
+
+// Number of taps on the MDAC
+#define CALIBRATION_MDAC_VALUES 4096
+
+namespace ChaosCalibration {
+    /**
+    *   Namespace holding the calibration of the connected Chaos Unit.
+    *   Each channel has an ADC gain, an offset and the bias voltage the
+    *   circuit sits at, and the MDAC has a table of the resistance at every
+    *   tap.  The conversions from ADC values to every unit in
+    *   ChaosSettings::YAxisLabels are worked out once whenever the
+    *   calibration changes, so the plots convert coordinates with a table
+    *   lookup or a single multiply-add.  The calibration is stored per unit
+    *   and loaded when that unit is connected.
+    */
+
+    // Builds the tables from the nominal calibration
+    extern void init();
+
+    // Loads the calibration of a unit when it connects, call with the connection status
+    extern void setDeviceStatus(bool connected);
+
+    // Name the calibration of the connected unit is stored under
+    extern const wxString& getUnitName();
+
+    // Measures the bias voltage of each channel from the current capture and saves it
+    extern bool measureBias();
+
+    // Puts the calibration of the connected unit back to the nominal values and saves it
+    extern void reset();
+
+    // Incremented whenever the calibration changes
+    extern unsigned int getVersion();
+
+    // Converts an ADC value of a channel to the units set by ChaosSettings::YAxisLabels
+    extern float toUnits(int channel, float adc);
+
+    // Converts a value in the units set by ChaosSettings::YAxisLabels back to ADC
+    extern float toAdc(int channel, float value);
+
+    // Units per ADC count and units at an ADC value of 0, for use in loops
+    extern float getScale(int channel);
+    extern float getOffset(int channel);
+
+    // Table of CALIBRATION_ADC_VALUES converted values for a channel in the current units
+    extern const float* getTable(int channel);
+
+    // Looks up the resistance (Ohms) at an MDAC tap
+    extern float mdacToResistance(int mdac);
+
+    // Finds the MDAC tap with the resistance closest to the one given
+    extern int resistanceToMdac(float resistance);
+}
+
+#endif // CHAOSCALIBRATION_H
@@ -0,0 +1,86 @@
+/**
+ * \file ChaosCapture.cpp
+ * \brief Storage for the most recent capture from the Chaos Unit
+ */
+
+#include <stdlib.h>
+#include "ChaosCapture.h"
+#include "libchaos.h"
+
+namespace ChaosCapture {
+    /**
+    *   Contiguous copy of the plot data held by libchaos.
+    */
+    short* channels[NUM_CHANNELS] = { NULL, NULL, NULL };
+    int num_points = 0;
+    int allocated_points = 0;
+    int trigger_index = 0;
+    int mdac_value = 0;
+    unsigned int generation = 0;
+    
+    void update() {
+        /**
+        *   Copies the newest plot data out of libchaos.  The arrays are
+        *   only reallocated when the capture grows past their size.
+        */
+        int points = libchaos_getNumPlotPoints();
+        int x1, x2, x3;
+        
+        if(points > allocated_points) {
+            for(int c = 0; c < NUM_CHANNELS; c++) {
+                channels[c] = (short*)realloc(channels[c], points*sizeof(short));
+            }
+            allocated_points = points;
+        }
+        
+        for(int i = 0; i < points; i++) {
+            libchaos_getPlotPoint(&x1, &x2, &x3, i);
+            channels[X1][i] = x1;
+            channels[X2][i] = x2;
+            channels[X3][i] = x3;
+        }
+        
+        num_points = points;
+        trigger_index = libchaos_getTriggerIndex();
+        mdac_value = libchaos_getMDACValue();
+        generation++;
+    }
+    
+    unsigned int getGeneration() {
+        /**
+        *   Returns a counter that changes every time new data is captured.
+        *   Consumers compare it with the last value they saw to find out if
+        *   there is anything new to process.
+        */
+        return generation;
+    }
+    
+    int getNumPoints() {
+        /**
+        *   Returns the number of points in the current capture
+        */
+        return num_points;
+    }
+    
+    int getTriggerIndex() {
+        /**
+        *   Returns the index of the trigger point in the current capture
+        */
+        return trigger_index;
+    }
+    
+    int getMdacValue() {
+        /**
+        *   Returns the MDAC value the current capture was taken at
+        */
+        return mdac_value;
+    }
+    
+    const short* getChannel(int channel) {
+        /**
+        *   Returns the ADC values for a channel (X1, X2 or X3).  The array
+        *   holds getNumPoints() values and is valid until the next update.
+        */
+        return channels[channel];
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * \file ChaosCapture.h
+ * \brief Headers for ChaosCapture.cpp
+ */
+
+#ifndef CHAOSCAPTURE_H
+#define CHAOSCAPTURE_H
+
+namespace ChaosCapture {
+    /**
+    *   Namespace holding the most recent capture from the Chaos Unit.
+    *   The data is copied out of libchaos once per capture into contiguous
+    *   arrays, one per channel, so that analysis and plotting code can walk
+    *   it directly instead of calling into the library for every point.
+    */
+    
+    // Channels that are captured from the device
+    enum {
+        X1 = 0,
+        X2,
+        X3,
+        NUM_CHANNELS
+    };
+    
+    // Copies the newest capture out of libchaos, call after libchaos_readPlot()
+    extern void update();
+    
+    // Incremented every time new data is captured
+    extern unsigned int getGeneration();
+    
+    // Number of points in the current capture
+    extern int getNumPoints();
+    
+    // Index of the trigger point in the current capture
+    extern int getTriggerIndex();
+    
+    // MDAC value the current capture was taken at
+    extern int getMdacValue();
+    
+    // Contiguous array of ADC values for one channel
+    extern const short* getChannel(int channel);
+}
+
+#endif // CHAOSCAPTURE_H
@@ -0,0 +1,869 @@
+/**
+ * \file ChaosChannels.cpp
+ * \brief Device channels and derived channels computed from them
+ */
+
+#include <stdlib.h>
+#include <wx/wx.h>
+#include <wx/fileconf.h>
+#include "ChaosChannels.h"
+#include "ChaosCalibration.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Taps in a compiled filter kernel
+#define KERNEL_TAPS (2*CHANNELS_KERNEL_HALF + 1)
+
+namespace ChaosChannels {
+    /**
+    *   A linear expression while it is being compiled: a constant and a
+    *   kernel for each device channel, where the value at sample i is
+    *
+    *       constant + sum over c, t of taps[c][t]*channel c[i + t - HALF]
+    */
+    struct Linear {
+        float constant;
+        float taps[ChaosCapture::NUM_CHANNELS][KERNEL_TAPS];
+    };
+
+    /**
+    *   Any expression while it is being compiled: a linear part plus a sum
+    *   of products of linear factors
+    */
+    struct Polynomial {
+        Linear linear;
+        Linear factors[CHANNELS_MAX_PRODUCTS][CHANNELS_MAX_FACTORS];
+        int num_factors[CHANNELS_MAX_PRODUCTS];
+        int num_products;
+    };
+
+    /**
+    *   A linear expression once compiled.  Only the non-zero taps are
+    *   kept, as a flat list of operations that each add a weighted and
+    *   shifted copy of a device channel to the result.
+    */
+    struct Operation {
+        int source;
+        int offset;
+        float weight;
+    };
+
+    struct Kernel {
+        float constant;
+        Operation operations[ChaosCapture::NUM_CHANNELS*KERNEL_TAPS];
+        int num_operations;
+    };
+
+    struct Derived {
+        wxString name;
+        wxString expression;
+        Kernel linear;
+        Kernel factors[CHANNELS_MAX_PRODUCTS][CHANNELS_MAX_FACTORS];
+        int num_factors[CHANNELS_MAX_PRODUCTS];
+        int num_products;
+        int unit_channel;
+        short* data;
+    };
+
+    const wxString device_names[ChaosCapture::NUM_CHANNELS] = { wxT("X"), wxT("X'"), wxT("X''") };
+    const wxString no_expression;
+
+    Derived derived[CHANNELS_MAX_DERIVED];
+    int num_derived = 0;
+
+    // Device channels as floats with the end samples repeated
+    // CHANNELS_KERNEL_HALF times either side, so kernels need no edge cases
+    float* padded[ChaosCapture::NUM_CHANNELS] = { NULL, NULL, NULL };
+    float* sums = NULL;
+    float* product = NULL;
+    float* factor = NULL;
+    int allocated_points = 0;
+    unsigned int generation = 0;
+
+    // Filters that can be applied in an expression
+    const float difference_kernel[3] = { -0.5f, 0.0f, 0.5f };
+    const float low_pass_kernel[5] = { 1/16.0f, 4/16.0f, 6/16.0f, 4/16.0f, 1/16.0f };
+
+    void setConstant(Linear& a, float constant) {
+        /**
+        *   Makes an expression a constant
+        */
+        a.constant = constant;
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int t = 0; t < KERNEL_TAPS; t++) {
+                a.taps[c][t] = 0;
+            }
+        }
+    }
+
+    bool isConstant(const Linear& a) {
+        /**
+        *   Returns true if an expression does not depend on any channel
+        */
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int t = 0; t < KERNEL_TAPS; t++) {
+                if(a.taps[c][t] != 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void scale(Linear& a, float factor) {
+        /**
+        *   Multiplies an expression by a constant
+        */
+        a.constant *= factor;
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int t = 0; t < KERNEL_TAPS; t++) {
+                a.taps[c][t] *= factor;
+            }
+        }
+    }
+
+    void add(Linear& a, const Linear& b, float sign) {
+        /**
+        *   Adds sign times b to a
+        */
+        a.constant += sign*b.constant;
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int t = 0; t < KERNEL_TAPS; t++) {
+                a.taps[c][t] += sign*b.taps[c][t];
+            }
+        }
+    }
+
+    bool filter(Linear& a, const float* kernel, int half, wxString& error) {
+        /**
+        *   Applies a filter to an expression by convolving its kernels with
+        *   the filter.  A constant is scaled by the gain of the filter.
+        */
+        Linear result;
+        float gain = 0;
+        for(int k = 0; k <= 2*half; k++) {
+            gain += kernel[k];
+        }
+        setConstant(result, a.constant*gain);
+
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int t = 0; t < KERNEL_TAPS; t++) {
+                if(a.taps[c][t] == 0) {
+                    continue;
+                }
+                for(int k = 0; k <= 2*half; k++) {
+                    int m = t + k - half;
+                    if(kernel[k] == 0) {
+                        continue;
+                    }
+                    if(m < 0 || m >= KERNEL_TAPS) {
+                        error = wxString::Format(wxT("Filters are nested more than %d samples deep"), CHANNELS_KERNEL_HALF);
+                        return false;
+                    }
+                    result.taps[c][m] += a.taps[c][t]*kernel[k];
+                }
+            }
+        }
+        a = result;
+        return true;
+    }
+
+    void setConstant(Polynomial& a, float constant) {
+        /**
+        *   Makes an expression a constant
+        */
+        setConstant(a.linear, constant);
+        a.num_products = 0;
+    }
+
+    bool isConstant(const Polynomial& a) {
+        /**
+        *   Returns true if an expression does not depend on any channel
+        */
+        return a.num_products == 0 && isConstant(a.linear);
+    }
+
+    void scale(Polynomial& a, float factor) {
+        /**
+        *   Multiplies an expression by a constant
+        */
+        scale(a.linear, factor);
+        for(int p = 0; p < a.num_products; p++) {
+            scale(a.factors[p][0], factor);
+        }
+    }
+
+    bool addProduct(Polynomial& a, const Linear* factors, int num_factors, float weight, wxString& error) {
+        /**
+        *   Adds weight times the product of some linear factors to an
+        *   expression.  Factors that are constants are multiplied into the
+        *   weight, so a product that is left with one factor becomes part
+        *   of the linear part.
+        */
+        Linear kept[CHANNELS_MAX_FACTORS];
+        int num_kept = 0;
+        for(int f = 0; f < num_factors; f++) {
+            if(isConstant(factors[f])) {
+                weight *= factors[f].constant;
+            } else if(num_kept == CHANNELS_MAX_FACTORS) {
+                error = wxString::Format(wxT("No more than %d channels can be multiplied together"), CHANNELS_MAX_FACTORS);
+                return false;
+            } else {
+                kept[num_kept++] = factors[f];
+            }
+        }
+
+        if(weight == 0) {
+            return true;
+        }
+        if(num_kept == 0) {
+            a.linear.constant += weight;
+            return true;
+        }
+        if(num_kept == 1) {
+            add(a.linear, kept[0], weight);
+            return true;
+        }
+        if(a.num_products == CHANNELS_MAX_PRODUCTS) {
+            error = wxString::Format(wxT("No more than %d products in one channel"), CHANNELS_MAX_PRODUCTS);
+            return false;
+        }
+        int p = a.num_products++;
+        for(int f = 0; f < num_kept; f++) {
+            a.factors[p][f] = kept[f];
+        }
+        scale(a.factors[p][0], weight);
+        a.num_factors[p] = num_kept;
+        return true;
+    }
+
+    bool add(Polynomial& a, const Polynomial& b, float sign, wxString& error) {
+        /**
+        *   Adds sign times b to a
+        */
+        add(a.linear, b.linear, sign);
+        for(int p = 0; p < b.num_products; p++) {
+            if(!addProduct(a, b.factors[p], b.num_factors[p], sign, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool multiply(Polynomial& a, const Polynomial& b, wxString& error) {
+        /**
+        *   Multiplies a by b by multiplying out every pair of their terms.
+        *   The linear part of each counts as a term with one factor.
+        */
+        Polynomial result;
+        setConstant(result, 0);
+
+        for(int i = -1; i < a.num_products; i++) {
+            const Linear* a_factors = (i < 0) ? &a.linear : a.factors[i];
+            int a_count = (i < 0) ? 1 : a.num_factors[i];
+            for(int j = -1; j < b.num_products; j++) {
+                const Linear* b_factors = (j < 0) ? &b.linear : b.factors[j];
+                int b_count = (j < 0) ? 1 : b.num_factors[j];
+                Linear factors[2*CHANNELS_MAX_FACTORS];
+                for(int f = 0; f < a_count; f++) {
+                    factors[f] = a_factors[f];
+                }
+                for(int f = 0; f < b_count; f++) {
+                    factors[a_count + f] = b_factors[f];
+                }
+                if(!addProduct(result, factors, a_count + b_count, 1, error)) {
+                    return false;
+                }
+            }
+        }
+        a = result;
+        return true;
+    }
+
+    void skipSpaces(const wxChar*& p) {
+        /**
+        *   Moves past any white space
+        */
+        while(*p == wxT(' ') || *p == wxT('\t')) {
+            p++;
+        }
+    }
+
+    bool parseExpression(const wxChar*& p, Polynomial& a, wxString& error);
+
+    bool parseNumber(const wxChar*& p, float& value, wxString& error) {
+        /**
+        *   Parses a number without a sign
+        */
+        float place = 0;
+        value = 0;
+        for(; (*p >= wxT('0') && *p <= wxT('9')) || *p == wxT('.'); p++) {
+            if(*p == wxT('.')) {
+                if(place != 0) {
+                    error = wxT("Number with two decimal points");
+                    return false;
+                }
+                place = 1;
+            } else if(place == 0) {
+                value = value*10 + (*p - wxT('0'));
+            } else {
+                place /= 10;
+                value += place*(*p - wxT('0'));
+            }
+        }
+        return true;
+    }
+
+    bool parseFactor(const wxChar*& p, Polynomial& a, wxString& error) {
+        /**
+        *   Parses a number, a channel, a negated factor, a bracketed
+        *   expression or a filter applied to a bracketed expression.
+        */
+        skipSpaces(p);
+        if(*p == wxT('-')) {
+            p++;
+            if(!parseFactor(p, a, error)) {
+                return false;
+            }
+            scale(a, -1);
+            return true;
+        }
+
+        if((*p >= wxT('0') && *p <= wxT('9')) || *p == wxT('.')) {
+            float value;
+            if(!parseNumber(p, value, error)) {
+                return false;
+            }
+            setConstant(a, value);
+            return true;
+        }
+
+        if(*p == wxT('X') || *p == wxT('x')) {
+            int channel = 0;
+            for(p++; *p == wxT('\''); p++) {
+                channel++;
+            }
+            if(channel >= ChaosCapture::NUM_CHANNELS) {
+                error = wxT("Only X, X' and X'' are captured");
+                return false;
+            }
+            setConstant(a, 0);
+            a.linear.taps[channel][CHANNELS_KERNEL_HALF] = 1;
+            return true;
+        }
+
+        const float* kernel = NULL;
+        int half = 0;
+        if(*p == wxT('d') && p[1] == wxT('(')) {
+            kernel = difference_kernel;
+            half = 1;
+            p++;
+        } else if(*p == wxT('l') && p[1] == wxT('p') && p[2] == wxT('(')) {
+            kernel = low_pass_kernel;
+            half = 2;
+            p += 2;
+        }
+
+        if(*p != wxT('(')) {
+            error = wxString::Format(wxT("Unexpected '%c'"), *p ? *p : wxT(' '));
+            return false;
+        }
+        p++;
+        if(!parseExpression(p, a, error)) {
+            return false;
+        }
+        skipSpaces(p);
+        if(*p != wxT(')')) {
+            error = wxT("Missing ')'");
+            return false;
+        }
+        p++;
+        if(kernel != NULL) {
+            if(a.num_products > 0) {
+                error = wxT("Filters can only be applied to sums of channels, not to products");
+                return false;
+            }
+            return filter(a.linear, kernel, half, error);
+        }
+        return true;
+    }
+
+    bool parsePower(const wxChar*& p, Polynomial& a, wxString& error) {
+        /**
+        *   Parses a factor raised to a whole number power with ^
+        */
+        if(!parseFactor(p, a, error)) {
+            return false;
+        }
+        skipSpaces(p);
+        if(*p != wxT('^')) {
+            return true;
+        }
+        p++;
+        skipSpaces(p);
+        float power;
+        if(!(*p >= wxT('0') && *p <= wxT('9')) || !parseNumber(p, power, error)) {
+            error = wxT("Expected a number after '^'");
+            return false;
+        }
+        if(power != (int)power || power < 1 || power > CHANNELS_MAX_FACTORS) {
+            error = wxString::Format(wxT("Powers must be whole numbers from 1 to %d"), CHANNELS_MAX_FACTORS);
+            return false;
+        }
+        Polynomial base = a;
+        for(int n = 1; n < (int)power; n++) {
+            if(!multiply(a, base, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseTerm(const wxChar*& p, Polynomial& a, wxString& error) {
+        /**
+        *   Parses powers multiplied or divided together.  Only numbers can
+        *   be divided by.
+        */
+        if(!parsePower(p, a, error)) {
+            return false;
+        }
+        for(;;) {
+            skipSpaces(p);
+            wxChar op = *p;
+            if(op != wxT('*') && op != wxT('/')) {
+                return true;
+            }
+            p++;
+
+            Polynomial b;
+            if(!parsePower(p, b, error)) {
+                return false;
+            }
+            if(op == wxT('/')) {
+                if(!isConstant(b) || b.linear.constant == 0) {
+                    error = wxT("Can only divide by a non-zero number");
+                    return false;
+                }
+                scale(a, 1/b.linear.constant);
+            } else if(!multiply(a, b, error)) {
+                return false;
+            }
+        }
+    }
+
+    bool parseExpression(const wxChar*& p, Polynomial& a, wxString& error) {
+        /**
+        *   Parses terms added or subtracted together
+        */
+        if(!parseTerm(p, a, error)) {
+            return false;
+        }
+        for(;;) {
+            skipSpaces(p);
+            float sign;
+            if(*p == wxT('+')) {
+                sign = 1;
+            } else if(*p == wxT('-')) {
+                sign = -1;
+            } else {
+                return true;
+            }
+            p++;
+
+            Polynomial b;
+            if(!parseTerm(p, b, error)) {
+                return false;
+            }
+            if(!add(a, b, sign, error)) {
+                return false;
+            }
+        }
+    }
+
+    void applyKernel(const Kernel& kernel, float* out, int num_points) {
+        /**
+        *   Sets out to a compiled linear expression.  Each operation adds a
+        *   shifted channel times its weight, a loop over contiguous arrays
+        *   that SSE2 does four samples at a time.
+        */
+        for(int i = 0; i < num_points; i++) {
+            out[i] = kernel.constant;
+        }
+
+        for(int o = 0; o < kernel.num_operations; o++) {
+            const Operation& operation = kernel.operations[o];
+            const float* values = padded[operation.source] + CHANNELS_KERNEL_HALF + operation.offset;
+            float weight = operation.weight;
+            int i = 0;
+#ifdef __SSE2__
+            __m128 vweight = _mm_set1_ps(weight);
+            for(; i + 4 <= num_points; i += 4) {
+                __m128 sum = _mm_loadu_ps(out + i);
+                sum = _mm_add_ps(sum, _mm_mul_ps(vweight, _mm_loadu_ps(values + i)));
+                _mm_storeu_ps(out + i, sum);
+            }
+#endif
+            for(; i < num_points; i++) {
+                out[i] += weight*values[i];
+            }
+        }
+    }
+
+    void multiplyInto(float* out, const float* in, int num_points) {
+        /**
+        *   Multiplies out by in sample by sample
+        */
+        int i = 0;
+#ifdef __SSE2__
+        for(; i + 4 <= num_points; i += 4) {
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i)));
+        }
+#endif
+        for(; i < num_points; i++) {
+            out[i] *= in[i];
+        }
+    }
+
+    void addInto(float* out, const float* in, int num_points) {
+        /**
+        *   Adds in to out sample by sample
+        */
+        int i = 0;
+#ifdef __SSE2__
+        for(; i + 4 <= num_points; i += 4) {
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i)));
+        }
+#endif
+        for(; i < num_points; i++) {
+            out[i] += in[i];
+        }
+    }
+
+    void evaluate() {
+        /**
+        *   Works out every derived channel for the current capture.
+        *
+        *   The device channels are converted to floats once and shared by
+        *   all the derived channels.  The linear part of a channel is
+        *   applied straight into the sums, each product is built up factor
+        *   by factor and added to them, and the sums are rounded back to
+        *   ADC values.
+        */
+        int num_points = ChaosCapture::getNumPoints();
+        if(num_points == 0 || num_derived == 0) {
+            return;
+        }
+
+        if(num_points > allocated_points) {
+            for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+                padded[c] = (float*)realloc(padded[c], (num_points + 2*CHANNELS_KERNEL_HALF)*sizeof(float));
+            }
+            sums = (float*)realloc(sums, num_points*sizeof(float));
+            product = (float*)realloc(product, num_points*sizeof(float));
+            factor = (float*)realloc(factor, num_points*sizeof(float));
+            for(int d = 0; d < CHANNELS_MAX_DERIVED; d++) {
+                derived[d].data = (short*)realloc(derived[d].data, num_points*sizeof(short));
+            }
+            allocated_points = num_points;
+        }
+
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            const short* data = ChaosCapture::getChannel(c);
+            float* values = padded[c];
+            for(int i = 0; i < CHANNELS_KERNEL_HALF; i++) {
+                values[i] = data[0];
+                values[CHANNELS_KERNEL_HALF + num_points + i] = data[num_points - 1];
+            }
+            values += CHANNELS_KERNEL_HALF;
+            for(int i = 0; i < num_points; i++) {
+                values[i] = data[i];
+            }
+        }
+
+        for(int d = 0; d < num_derived; d++) {
+            Derived& channel = derived[d];
+            applyKernel(channel.linear, sums, num_points);
+            for(int p = 0; p < channel.num_products; p++) {
+                applyKernel(channel.factors[p][0], product, num_points);
+                for(int f = 1; f < channel.num_factors[p]; f++) {
+                    applyKernel(channel.factors[p][f], factor, num_points);
+                    multiplyInto(product, factor, num_points);
+                }
+                addInto(sums, product, num_points);
+            }
+
+            short* data = channel.data;
+            int i = 0;
+#ifdef __SSE2__
+            // Converting rounds to nearest and packing saturates to a short.
+            // Products can pass the range of an int, so clamp first.
+            __m128 top = _mm_set1_ps(32767);
+            __m128 bottom = _mm_set1_ps(-32768);
+            for(; i + 8 <= num_points; i += 8) {
+                __m128 low_sums = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(sums + i), top), bottom);
+                __m128 high_sums = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(sums + i + 4), top), bottom);
+                __m128i low = _mm_cvtps_epi32(low_sums);
+                __m128i high = _mm_cvtps_epi32(high_sums);
+                _mm_storeu_si128((__m128i*)(data + i), _mm_packs_epi32(low, high));
+            }
+#endif
+            for(; i < num_points; i++) {
+                float value = sums[i];
+                if(value > 32767) value = 32767;
+                if(value < -32768) value = -32768;
+                data[i] = (short)(value < 0 ? value - 0.5f : value + 0.5f);
+            }
+        }
+    }
+
+    void compileKernel(const Linear& a, Kernel& kernel, float* weights) {
+        /**
+        *   Keeps the non-zero taps of a linear expression as operations and
+        *   adds the size of the weights on each device channel to weights
+        */
+        kernel.constant = a.constant;
+        kernel.num_operations = 0;
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int t = 0; t < KERNEL_TAPS; t++) {
+                if(a.taps[c][t] == 0) {
+                    continue;
+                }
+                Operation& operation = kernel.operations[kernel.num_operations++];
+                operation.source = c;
+                operation.offset = t - CHANNELS_KERNEL_HALF;
+                operation.weight = a.taps[c][t];
+                weights[c] += a.taps[c][t] < 0 ? -a.taps[c][t] : a.taps[c][t];
+            }
+        }
+    }
+
+    void defineBuiltIn() {
+        /**
+        *   Compiles the built in derived channels.  The derivatives are
+        *   scaled up and centred in the range of the ADC so that they can
+        *   be seen on the same axes as the device channels.  X' error is
+        *   how far the measured X' is from the difference of X; the factor
+        *   of 8 matches dX/dt, the right one depends on the time constant
+        *   of the circuit.  Energy is centred on mid scale and divided down
+        *   to stay inside the ADC range.
+        */
+        wxString error;
+        clear();
+        define(wxT("X'''"), wxT("8*d(X'') + 512"), error);
+        define(wxT("dX/dt"), wxT("8*d(X) + 512"), error);
+        define(wxT("X filtered"), wxT("lp(lp(X))"), error);
+        define(wxT("X' error"), wxT("X' - 8*d(X)"), error);
+        define(wxT("Energy"), wxT("((X - 512)^2 + (X' - 512)^2)/512"), error);
+    }
+
+    void init() {
+        /**
+        *   Loads the derived channels saved in channels.ini.  The built in
+        *   channels are used if nothing has been saved or a saved
+        *   expression no longer compiles.
+        */
+        wxFileConfig config(wxT("ChaosConnect"), wxEmptyString, wxT("channels.ini"),
+                            wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        long count;
+        if(!config.Read(wxT("/Derived/Count"), &count)) {
+            defineBuiltIn();
+            return;
+        }
+
+        wxArrayString names;
+        wxArrayString expressions;
+        for(int d = 0; d < count; d++) {
+            wxString key = wxString::Format(wxT("/Derived/Channel%d/"), d);
+            names.Add(config.Read(key + wxT("Name"), wxEmptyString));
+            expressions.Add(config.Read(key + wxT("Expression"), wxEmptyString));
+        }
+        wxString error;
+        if(!setDefinitions(names, expressions, error)) {
+            wxLogMessage(wxT("Could not load the derived channels: %s"), error.c_str());
+            defineBuiltIn();
+        }
+    }
+
+    void save() {
+        /**
+        *   Writes the derived channels to channels.ini
+        */
+        wxFileConfig config(wxT("ChaosConnect"), wxEmptyString, wxT("channels.ini"),
+                            wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        config.DeleteGroup(wxT("/Derived"));
+        config.Write(wxT("/Derived/Count"), (long)num_derived);
+        for(int d = 0; d < num_derived; d++) {
+            wxString key = wxString::Format(wxT("/Derived/Channel%d/"), d);
+            config.Write(key + wxT("Name"), derived[d].name);
+            config.Write(key + wxT("Expression"), derived[d].expression);
+        }
+        config.Flush();
+    }
+
+    bool setDefinitions(const wxArrayString& names, const wxArrayString& expressions, wxString& error) {
+        /**
+        *   Compiles every expression in place of the current derived
+        *   channels.  The old definitions are compiled again if any of the
+        *   new ones fail, so the channels never end up half replaced.
+        */
+        wxArrayString old_names;
+        wxArrayString old_expressions;
+        for(int d = 0; d < num_derived; d++) {
+            old_names.Add(derived[d].name);
+            old_expressions.Add(derived[d].expression);
+        }
+
+        clear();
+        for(size_t d = 0; d < names.GetCount(); d++) {
+            if(names[d].IsEmpty()) {
+                error = wxString::Format(wxT("Derived channel %d has no name"), (int)d + 1);
+            } else if(define(names[d], expressions[d], error)) {
+                continue;
+            } else {
+                error = names[d] + wxT(": ") + error;
+            }
+
+            wxString ignored;
+            clear();
+            for(size_t o = 0; o < old_names.GetCount(); o++) {
+                define(old_names[o], old_expressions[o], ignored);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void update() {
+        /**
+        *   Evaluates the derived channels whenever there is a new capture
+        */
+        if(generation == ChaosCapture::getGeneration()) {
+            return;
+        }
+        generation = ChaosCapture::getGeneration();
+        evaluate();
+    }
+
+    bool define(const wxString& name, const wxString& expression, wxString& error) {
+        /**
+        *   Compiles an expression and adds it to the derived channels.  The
+        *   new channel is evaluated straight away so that it is ready as
+        *   soon as it can be chosen.
+        */
+        if(num_derived == CHANNELS_MAX_DERIVED) {
+            error = wxString::Format(wxT("No more than %d derived channels"), CHANNELS_MAX_DERIVED);
+            return false;
+        }
+
+        Polynomial a;
+        const wxChar* p = expression.c_str();
+        if(!parseExpression(p, a, error)) {
+            return false;
+        }
+        skipSpaces(p);
+        if(*p != 0) {
+            error = wxString::Format(wxT("Unexpected '%c'"), *p);
+            return false;
+        }
+
+        Derived& channel = derived[num_derived];
+        channel.name = name;
+        channel.expression = expression;
+        float weights[ChaosCapture::NUM_CHANNELS] = { 0, 0, 0 };
+        compileKernel(a.linear, channel.linear, weights);
+        channel.num_products = a.num_products;
+        for(int p = 0; p < a.num_products; p++) {
+            channel.num_factors[p] = a.num_factors[p];
+            for(int f = 0; f < a.num_factors[p]; f++) {
+                compileKernel(a.factors[p][f], channel.factors[p][f], weights);
+            }
+        }
+
+        // Units follow the device channel with the most weight
+        channel.unit_channel = ChaosCapture::X1;
+        for(int c = 1; c < ChaosCapture::NUM_CHANNELS; c++) {
+            if(weights[c] > weights[channel.unit_channel]) {
+                channel.unit_channel = c;
+            }
+        }
+        num_derived++;
+
+        evaluate();
+        return true;
+    }
+
+    void clear() {
+        /**
+        *   Removes every derived channel.  Their arrays are kept for reuse.
+        */
+        num_derived = 0;
+    }
+
+    int getNumChannels() {
+        /**
+        *   Returns the number of device and derived channels
+        */
+        return ChaosCapture::NUM_CHANNELS + num_derived;
+    }
+
+    bool isDerived(int channel) {
+        /**
+        *   Returns true if a channel is computed rather than captured
+        */
+        return channel >= ChaosCapture::NUM_CHANNELS;
+    }
+
+    const wxString& getName(int channel) {
+        /**
+        *   Returns the name of a channel
+        */
+        if(isDerived(channel)) {
+            return derived[channel - ChaosCapture::NUM_CHANNELS].name;
+        }
+        return device_names[channel];
+    }
+
+    const wxString& getExpression(int channel) {
+        /**
+        *   Returns the expression of a derived channel, or an empty string
+        *   for a device channel
+        */
+        if(isDerived(channel)) {
+            return derived[channel - ChaosCapture::NUM_CHANNELS].expression;
+        }
+        return no_expression;
+    }
+
+    const short* getChannel(int channel) {
+        /**
+        *   Returns the values of a channel.  The array is valid until the
+        *   next update.
+        */
+        if(isDerived(channel)) {
+            return derived[channel - ChaosCapture::NUM_CHANNELS].data;
+        }
+        return ChaosCapture::getChannel(channel);
+    }
+
+    float toUnits(int channel, float adc) {
+        /**
+        *   Converts a value of a channel to the current units
+        */
+        if(isDerived(channel)) {
+            channel = derived[channel - ChaosCapture::NUM_CHANNELS].unit_channel;
+        }
+        return ChaosCalibration::toUnits(channel, adc);
+    }
+
+    float toAdc(int channel, float value) {
+        /**
+        *   Converts a value in the current units back to a value of a channel
+        */
+        if(isDerived(channel)) {
+            channel = derived[channel - ChaosCapture::NUM_CHANNELS].unit_channel;
+        }
+        return ChaosCalibration::toAdc(channel, value);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * \file ChaosChannels.h
+ * \brief Headers for ChaosChannels.cpp
+ */
+
+#ifndef CHAOSCHANNELS_H
+#define CHAOSCHANNELS_H
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include "ChaosCapture.h"
+
+// Most derived channels that can be defined
+#define CHANNELS_MAX_DERIVED 8
+
+// Most products in one derived channel, and most factors in each product
+#define CHANNELS_MAX_PRODUCTS 4
+#define CHANNELS_MAX_FACTORS 3
+
+// Taps either side of the centre of a compiled filter kernel
+#define CHANNELS_KERNEL_HALF 16
+
+namespace ChaosChannels {
+    /**
+    *   Namespace holding the channels the plots can show: the three
+    *   channels captured from the device followed by derived channels
+    *   computed from them.  A derived channel is defined by an expression
+    *   in X, X' and X'' with fixed coefficients, for example
+    *
+    *       8*d(X'') + 512
+    *       ((X - 512)^2 + (X' - 512)^2)/512
+    *
+    *   where d() is the central difference of its argument and lp() is a
+    *   short low pass filter.  Filters can be nested and added together.
+    *   The linear part of an expression is compiled once into a single
+    *   filter kernel per device channel and a constant, so evaluating it
+    *   takes one multiply-add per tap no matter how it was written.
+    *   Products and powers are expanded into a sum of at most
+    *   CHANNELS_MAX_PRODUCTS products of such kernels.  Filters can only be
+    *   applied to linear expressions.
+    *
+    *   Derived channels are evaluated once per capture into arrays of ADC
+    *   like values, so a plot reads every channel the same way.  The
+    *   definitions are kept in channels.ini.
+    */
+
+    // Loads the saved derived channels, or compiles the built in ones if
+    // none have been saved
+    extern void init();
+
+    // Writes the derived channels to channels.ini
+    extern void save();
+
+    // Replaces every derived channel.  If any expression cannot be
+    // compiled the channels are left as they were and error says why.
+    extern bool setDefinitions(const wxArrayString& names, const wxArrayString& expressions, wxString& error);
+
+    // Evaluates the derived channels, call after ChaosCapture::update()
+    extern void update();
+
+    // Compiles an expression and adds it as a derived channel.  Returns
+    // false and describes the problem in error if it cannot be compiled.
+    extern bool define(const wxString& name, const wxString& expression, wxString& error);
+
+    // Removes every derived channel
+    extern void clear();
+
+    // Device channels followed by the derived channels
+    extern int getNumChannels();
+
+    // True if a channel is computed rather than captured
+    extern bool isDerived(int channel);
+
+    // Name of a channel, as used in axis labels
+    extern const wxString& getName(int channel);
+
+    // Expression a derived channel was defined by
+    extern const wxString& getExpression(int channel);
+
+    // Contiguous array of ChaosCapture::getNumPoints() values for a channel
+    extern const short* getChannel(int channel);
+
+    // Converts a value of a channel to and from the units set by
+    // ChaosSettings::YAxisLabels.  Derived channels use the calibration
+    // of the device channel that contributes most to them.
+    extern float toUnits(int channel, float adc);
+    extern float toAdc(int channel, float value);
+}
+
+#endif // CHAOSCHANNELS_H
@@ -5,6 +5,7 @@
 
 #include "ChaosConnectApp.h"
 #include "ChaosConnectFrm.h" 
+#include "ChaosWorkers.h"
 
 IMPLEMENT_APP(ChaosConnectFrmApp)
 
@@ -13,6 +14,8 @@ bool ChaosConnectFrmApp::OnInit()
     /**
     *   Creates the main form and shows it
     */
+    ChaosWorkers::start();
+    
     ChaosConnectFrm* frame = new ChaosConnectFrm(NULL);
     SetTopWindow(frame);
     frame->Show();
@@ -23,8 +26,10 @@ int ChaosConnectFrmApp::OnExit()
 {
     /**
     *   Closes the application and shuts down the USB connection established
-    *   by libchaos.
+    *   by libchaos.  The worker pool is stopped once all of the windows
+    *   that could use it are gone.
     */
+    ChaosWorkers::stop();
     libchaos_close();
     return 0;
 }
@@ -7,19 +7,33 @@
 #include "ChaosSettings.h"
 #include "ChaosConnectFrm.h"
 #include "libchaos.h"
+#include "ChaosCapture.h"
+#include "ChaosChannels.h"
+#include "ChaosStatistics.h"
+#include "ChaosCalibration.h"
+#include "ChaosRecord.h"
+#include "ChaosSpectrum.h"
+#include "FrequencyTracker.h"
 #include "Game.h"
 
 #define BORDER_SIZE 5
 #define TOP_BORDER_SIZE 30
 #define SIDE_GUTTER_SIZE 15
 
+// Shortest time between two frames of the plots in milliseconds, which
+// caps them at 50 frames per second
+#define FRAME_PERIOD 20
+
 BEGIN_EVENT_TABLE(ChaosConnectFrm,wxFrame)
     EVT_CLOSE(ChaosConnectFrm::OnClose)
     EVT_TIMER(ID_TIMER1,ChaosConnectFrm::timer1Timer)
+    EVT_TIMER(ID_FRAME_TIMER,ChaosConnectFrm::frameTimerTimer)
     EVT_MENU(ID_MNU_FILE_EXIT, ChaosConnectFrm::mnuExit)
     EVT_MENU(ID_MNU_SHOW_LOG, ChaosConnectFrm::mnuShowLog)
     EVT_MENU(ID_MNU_SAMPLE_TO_FILE, ChaosConnectFrm::mnuSampleToFile)
     EVT_MENU(ID_MNU_SETTINGS, ChaosConnectFrm::mnuSettings)
+    EVT_MENU(ID_MNU_MEASURE_BIAS, ChaosConnectFrm::mnuMeasureBias)
+    EVT_MENU(ID_MNU_RESET_CALIBRATION, ChaosConnectFrm::mnuResetCalibration)
     EVT_MENU(ID_MNU_VIEW_FULLSCREEN, ChaosConnectFrm::mnuFullscreen)
     EVT_MENU(ID_MNU_VIEW_SPLITSCREEN, ChaosConnectFrm::mnuSplitScreen)
     EVT_MENU(ID_MNU_VIEW_QUADVIEW, ChaosConnectFrm::mnuQuadScreen)    
@@ -42,11 +56,15 @@ ChaosConnectFrm::ChaosConnectFrm(wxWindow *parent, wxWindowID id, const wxString
     
     // Create GUI
     ChaosSettings::initSettings();
+    ChaosCalibration::init();
+    ChaosChannels::init();
+    ChaosRecord::setMemoryLimit(ChaosSettings::RecordMemory);
     CreateGUIControls();
     
     // Set up libchaos
     libchaos_init();
     libchaos_setPeaksPerMDAC(ChaosSettings::PeaksPerMdac);
+    ChaosSpectrum::setMode(ChaosSettings::SpectrumMode);
     
     wxIdleEvent::SetMode(wxIDLE_PROCESS_SPECIFIED);
     
@@ -59,6 +77,7 @@ ChaosConnectFrm::~ChaosConnectFrm() {
     *   Destructor for the Main form.
     */
     timer1->Stop();
+    frameTimer->Stop();
 }
 
 void ChaosConnectFrm::CreateGUIControls() {
@@ -137,21 +156,23 @@ void ChaosConnectFrm::CreateGUIControls() {
     // Create status bar
     // Create fields
     statusBar = new wxStatusBar(this, ID_STATUSBAR);
-    statusBar->SetFieldsCount(5);
+    statusBar->SetFieldsCount(6);
     statusBar->SetStatusText(wxT("Connected: ?"),0);
     statusBar->SetStatusText(wxT("MDAC Value: ????"),1);
     statusBar->SetStatusText(wxT("Resistance: ????"),2);
     statusBar->SetStatusText(wxT("(X,Y)"),3);
     statusBar->SetStatusText(wxT("Updating"),4);
+    statusBar->SetStatusText(wxT(""),5);
     
     // Set field sizes
-    int statusBar_Widths[5];
+    int statusBar_Widths[6];
     statusBar_Widths[0] = 100;
     statusBar_Widths[1] = 100;
     statusBar_Widths[2] = 100;
     statusBar_Widths[3] = 150;
-    statusBar_Widths[4] = -1; // Auto scale to the rest of the size
-    statusBar->SetStatusWidths(5,statusBar_Widths);
+    statusBar_Widths[4] = 70;
+    statusBar_Widths[5] = -1; // Auto scale to the rest of the size
+    statusBar->SetStatusWidths(6,statusBar_Widths);
     
     // Set status bar
     SetStatusBar(statusBar);
@@ -163,6 +184,8 @@ void ChaosConnectFrm::CreateGUIControls() {
     wxMenu *fileMenu = new wxMenu(0);
     fileMenu->Append(ID_MNU_SAMPLE_TO_FILE, wxT("Sample To File..."), wxT(""), wxITEM_NORMAL);
     fileMenu->Append(ID_MNU_SETTINGS, wxT("Settings..."), wxT(""), wxITEM_NORMAL);
+    fileMenu->Append(ID_MNU_MEASURE_BIAS, wxT("Measure Bias Calibration"), wxT(""), wxITEM_NORMAL);
+    fileMenu->Append(ID_MNU_RESET_CALIBRATION, wxT("Reset Calibration"), wxT(""), wxITEM_NORMAL);
     fileMenu->Append(ID_MNU_SHOW_LOG, wxT("Show Log"), wxT(""), wxITEM_NORMAL);
     fileMenu->Append(ID_MNU_FILE_EXIT, wxT("Exit"), wxT(""), wxITEM_NORMAL);
     menuBar->Append(fileMenu, wxT("File"));
@@ -186,6 +209,9 @@ void ChaosConnectFrm::CreateGUIControls() {
     timer1 = new wxTimer();
     timer1->SetOwner(this, ID_TIMER1);
     timer1->Start(ChaosSettings::UpdatePeriod);
+    frameTimer = new wxTimer();
+    frameTimer->SetOwner(this, ID_FRAME_TIMER);
+    frameTimer->Start(FRAME_PERIOD);
 
     // Set window properties and title bar
     SetTitle(wxT("ChaosConnect 1.0"));
@@ -219,6 +245,7 @@ void ChaosConnectFrm::OnClose(wxCloseEvent& event) {
     *   Exit the ChaosConnect Program
     */
     timer1->Stop();
+    frameTimer->Stop();
     Destroy();
 }
 
@@ -257,6 +284,35 @@ void ChaosConnectFrm::mnuSettings(wxCommandEvent& event) {
     settingsFrame->Show();
 }
 
+void ChaosConnectFrm::channelsChanged() {
+    /**
+    *   Called by the settings dialog after the derived channels change so
+    *   every display can refresh its channel choices.
+    */
+    display1->channelsChanged();
+    display2->channelsChanged();
+    display3->channelsChanged();
+    display4->channelsChanged();
+}
+
+void ChaosConnectFrm::mnuMeasureBias(wxCommandEvent& event) {
+    /**
+    *   Measures the bias voltage of each channel of the connected unit
+    *   from the current capture and saves it as that unit's calibration.
+    */
+    if(libchaos_isConnected() == false || ChaosCalibration::measureBias() == false) {
+        wxMessageBox(wxT("Connect a Chaos Unit and let it capture before measuring the bias."),
+                     wxT("Calibration"), wxOK | wxICON_INFORMATION, this);
+    }
+}
+
+void ChaosConnectFrm::mnuResetCalibration(wxCommandEvent& event) {
+    /**
+    *   Puts the calibration of the connected unit back to the nominal values
+    */
+    ChaosCalibration::reset();
+}
+
 void ChaosConnectFrm::mnuExit(wxCommandEvent& event) {
     /**
     *   Exit the ChaosConnect Program
@@ -336,12 +392,14 @@ void ChaosConnectFrm::timer1Timer(wxTimerEvent& event) {
     *   Collects more data if data collection is not paused.
     */
     DisplayBifurcationSettings();
-     if(libchaos_isConnected() == true) {  
+    bool connected = libchaos_isConnected();
+    ChaosCalibration::setDeviceStatus(connected);
+     if(connected == true) {  
         // Update the status bar
         statusBar->SetStatusText(wxT("Connected: Yes"),0);
         int value = libchaos_getMDACValue();
         statusBar->SetStatusText(wxString::Format(wxT("MDAC Value: %d"), value), 1);
-        statusBar->SetStatusText(wxString::Format(wxT("Resistance: %.2fk"), libchaos_mdacToResistance(value)/1000.0), 2);
+        statusBar->SetStatusText(wxString::Format(wxT("Resistance: %.2fk"), ChaosCalibration::mdacToResistance(value)/1000.0), 2);
         display1->getChaosPlot()->setDeviceStatus(true, value);
         display2->getChaosPlot()->setDeviceStatus(true, value);
         display3->getChaosPlot()->setDeviceStatus(true, value);
@@ -349,6 +407,13 @@ void ChaosConnectFrm::timer1Timer(wxTimerEvent& event) {
         // Read data from the device
         if(ChaosSettings::Paused == false) {
             libchaos_readPlot(-1);
+            ChaosCapture::update();
+            ChaosChannels::update();
+            ChaosRecord::update();
+            ChaosSpectrum::update();
+            FrequencyTracker::update();
+            ChaosStatistics::update();
+            DisplayStatistics();
         }
     } else {
         statusBar->SetStatusText(wxT("Connected: No"),0);
@@ -368,8 +433,22 @@ void ChaosConnectFrm::timer1Timer(wxTimerEvent& event) {
     if(timer1->GetInterval() != ChaosSettings::UpdatePeriod) {
         timer1->Start(ChaosSettings::UpdatePeriod);
     }
-    
-    wxWakeUpIdle();
+}
+
+void ChaosConnectFrm::frameTimerTimer(wxTimerEvent& event) {
+    /**
+    *   Event handler for the frame timer.
+    *   Draws every shown plot that has changed since its last frame.  In
+    *   the split and quad views they are drawn together so that their
+    *   traces are rendered in parallel.
+    */
+    ChaosPanel* displays[4] = { display1, display2, display3, display4 };
+    for(int i = 0; i < 4; i++) {
+        if(displays[i]->needsRedraw()) {
+            frames.add(displays[i]->getChaosPlot());
+        }
+    }
+    frames.draw();
 }
 
 void ChaosConnectFrm::OnStartStopBtn(wxCommandEvent& event) {
@@ -395,6 +474,7 @@ void ChaosConnectFrm::OnStartStopBtn(wxCommandEvent& event) {
         b = button_color.Blue() - 50;
         startStopButton->SetBackgroundColour(wxColor(r,g,b));
     }
+    ChaosPlot::invalidateAll();
 }
 
 void ChaosConnectFrm::OnSettingsApplyBtn(wxCommandEvent& event) {
@@ -434,6 +514,25 @@ void ChaosConnectFrm::DisplayBifurcationSettings() {
     }
 }
 
+void ChaosConnectFrm::DisplayStatistics() {
+    /**
+    *   Shows the peak to peak amplitude of each channel in the latest
+    *   capture on the status bar
+    */
+    float minimum, maximum, mean, rms, p2p[3];
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        ChaosStatistics::getValues(c, false, &minimum, &maximum, &mean, &rms, &p2p[c]);
+    }
+    
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        statusBar->SetStatusText(wxString::Format(wxT("p-p X: %.0f  X': %.0f  X'': %.0f"),
+                                                  p2p[0], p2p[1], p2p[2]), 5);
+    } else {
+        statusBar->SetStatusText(wxString::Format(wxT("p-p X: %.2f V  X': %.2f V  X'': %.2f V"),
+                                                  p2p[0], p2p[1], p2p[2]), 5);
+    }
+}
+
 void ChaosConnectFrm::OnBifEraseBtn(wxCommandEvent& event) {
     /**
     *   Event handler for the erase button
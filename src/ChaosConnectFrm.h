@@ -30,6 +30,7 @@
 #include <wx/dcbuffer.h>
 
 #include "ChaosPanel.h"
+#include "PlotFrames.h"
 #include "SampleToFileDlg.h"
 #include "SettingsDlg.h"
 #include "AboutDlg.h"
@@ -43,6 +44,7 @@ class ChaosConnectFrm : public wxFrame
     public:
         ChaosConnectFrm(wxWindow *parent, wxWindowID id = 1, const wxString &title = wxT("ChaosConnect"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxDefaultSize, long style = ChaosConnectFrm_STYLE);
         virtual ~ChaosConnectFrm();
+        void channelsChanged();
 
     private:
         // Event handlers
@@ -51,22 +53,28 @@ class ChaosConnectFrm : public wxFrame
         void mnuShowLog(wxCommandEvent& event);
         void mnuSampleToFile(wxCommandEvent& event);
         void mnuSettings(wxCommandEvent& event);
+        void mnuMeasureBias(wxCommandEvent& event);
+        void mnuResetCalibration(wxCommandEvent& event);
         void mnuExit(wxCommandEvent& event);
         void mnuFullscreen(wxCommandEvent& event);
         void mnuSplitScreen(wxCommandEvent& event);
         void mnuQuadScreen(wxCommandEvent& event);
         void mnuAbout(wxCommandEvent& event);
         void timer1Timer(wxTimerEvent& event);
+        void frameTimerTimer(wxTimerEvent& event);
         void OnStartStopBtn(wxCommandEvent& event);
         void OnSettingsApplyBtn(wxCommandEvent& event);
         void OnBifEraseBtn(wxCommandEvent& event);
         void DisplayBifurcationSettings();
+        void DisplayStatistics();
 
         // Functions
         void CreateGUIControls();
         
         // wxWidgets gui objects
         wxTimer *timer1;
+        wxTimer *frameTimer;
+        PlotFrames frames;
         wxMenuBar *menuBar;
         wxStatusBar *statusBar;
         wxPanel *display5;
@@ -94,11 +102,14 @@ class ChaosConnectFrm : public wxFrame
         enum {
             ////GUI Enum Control ID Start
             ID_TIMER1 = 1151,
+            ID_FRAME_TIMER,
             ID_MNU_FILE,
             ID_MNU_FILE_EXIT,
             ID_MNU_SAMPLE_TO_FILE,
             ID_MNU_SETTINGS,
             ID_MNU_SHOW_LOG,
+            ID_MNU_MEASURE_BIAS,
+            ID_MNU_RESET_CALIBRATION,
             ID_MNU_VIEW,
             ID_MNU_VIEW_FULLSCREEN,
             ID_MNU_VIEW_SPLITSCREEN,
@@ -0,0 +1,243 @@
+/**
+ * \file ChaosFFT.cpp
+ * \brief Fast Fourier transform used by the analysis code
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "ChaosFFT.h"
+
+ChaosFFT::ChaosFFT() {
+    /**
+    *   Constructor for the ChaosFFT class.
+    *
+    *   libchaos only gives us the magnitude of its own transform of each
+    *   capture, so analysis that needs complex spectra or transforms of
+    *   other lengths uses this radix-2 transform.  The tables are built
+    *   once per size so repeated transforms only do the butterflies.
+    *   There is also a fixed point transform for integer data such as the
+    *   ADC samples, which is cheaper than the float one on older PCs.
+    */
+    size = 0;
+    log2_size = 0;
+    cos_table = NULL;
+    sin_table = NULL;
+    reversed = NULL;
+    fixed_cos = NULL;
+    fixed_sin = NULL;
+}
+
+ChaosFFT::~ChaosFFT() {
+    /**
+    *   Destructor for the ChaosFFT class
+    */
+    free(cos_table);
+    free(sin_table);
+    free(reversed);
+    free(fixed_cos);
+    free(fixed_sin);
+}
+
+int ChaosFFT::nextPowerOfTwo(int n) {
+    /**
+    *   Returns the smallest power of two that is at least n
+    */
+    int p = 1;
+    while(p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+void ChaosFFT::setSize(int new_size) {
+    /**
+    *   Sets the length of the transform, which must be a power of two,
+    *   and builds the tables for it.  Does nothing if it is unchanged.
+    */
+    if(new_size == size) {
+        return;
+    }
+    size = new_size;
+    log2_size = 0;
+    while((1 << log2_size) < size) {
+        log2_size++;
+    }
+    
+    cos_table = (float*)realloc(cos_table, (size/2)*sizeof(float));
+    sin_table = (float*)realloc(sin_table, (size/2)*sizeof(float));
+    reversed = (int*)realloc(reversed, size*sizeof(int));
+    fixed_cos = (int*)realloc(fixed_cos, (size/2)*sizeof(int));
+    fixed_sin = (int*)realloc(fixed_sin, (size/2)*sizeof(int));
+    
+    for(int i = 0; i < size/2; i++) {
+        cos_table[i] = cos(2*M_PI*i/size);
+        sin_table[i] = -sin(2*M_PI*i/size);
+        fixed_cos[i] = (int)floor(cos_table[i]*(1 << FIXED_FFT_BITS) + 0.5);
+        fixed_sin[i] = (int)floor(sin_table[i]*(1 << FIXED_FFT_BITS) + 0.5);
+    }
+    for(int i = 0; i < size; i++) {
+        int r = 0;
+        for(int b = 0; b < log2_size; b++) {
+            r |= ((i >> b) & 1) << (log2_size - 1 - b);
+        }
+        reversed[i] = r;
+    }
+}
+
+int ChaosFFT::getSize() {
+    /**
+    *   Returns the length of the transform
+    */
+    return size;
+}
+
+void ChaosFFT::forward(float* re, float* im) {
+    /**
+    *   Replaces re + i*im with its discrete Fourier transform
+    */
+    transform(re, im);
+}
+
+void ChaosFFT::inverse(float* re, float* im) {
+    /**
+    *   Replaces re + i*im with its inverse discrete Fourier transform,
+    *   scaled by 1/size.  Done by conjugating around the forward transform.
+    */
+    for(int i = 0; i < size; i++) {
+        im[i] = -im[i];
+    }
+    transform(re, im);
+    float scale = 1.0/size;
+    for(int i = 0; i < size; i++) {
+        re[i] *= scale;
+        im[i] *= -scale;
+    }
+}
+
+void ChaosFFT::transform(float* re, float* im) {
+    /**
+    *   In place iterative radix-2 decimation in time transform.  The
+    *   inner loop walks the butterflies of a stage with a fixed stride
+    *   through the twiddle tables.
+    */
+    for(int i = 0; i < size; i++) {
+        int j = reversed[i];
+        if(j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    
+    for(int half = 1; half < size; half <<= 1) {
+        int stride = size/(2*half);
+        for(int start = 0; start < size; start += 2*half) {
+            for(int k = 0; k < half; k++) {
+                float wr = cos_table[k*stride];
+                float wi = sin_table[k*stride];
+                int a = start + k;
+                int b = a + half;
+                float tr = re[b]*wr - im[b]*wi;
+                float ti = re[b]*wi + im[b]*wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void ChaosFFT::forwardFixed(int* re, int* im, int* exponent) {
+    /**
+    *   Fixed point version of forward() for integer data.  Works in block
+    *   floating point: before a stage the data is halved until it is below
+    *   FIXED_FFT_HEADROOM, so a butterfly, which can grow it by at most
+    *   1 + sqrt(2), cannot overflow and the twiddle products stay inside
+    *   32 bits.  The number of halvings is returned in exponent, the result
+    *   is the transform divided by 2^exponent.  Precision is best with the
+    *   input scaled up to just below the headroom.
+    */
+    // Locals, since the int stores could otherwise alias the members
+    const int n = size;
+    const int* cos_q = fixed_cos;
+    const int* sin_q = fixed_sin;
+    const int* order = reversed;
+    
+    *exponent = 0;
+    int bits = 0;
+    for(int i = 0; i < n; i++) {
+        int j = order[i];
+        if(j > i) {
+            int t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+        bits |= (re[i] ^ (re[i] >> 31)) | (im[i] ^ (im[i] >> 31));
+    }
+    
+    const int round = 1 << (FIXED_FFT_BITS - 1);
+    for(int half = 1; half < n; half <<= 1) {
+        int shift = 0;
+        while((bits >> shift) >= FIXED_FFT_HEADROOM) {
+            shift++;
+        }
+        if(shift > 0) {
+            for(int i = 0; i < n; i++) {
+                re[i] >>= shift;
+                im[i] >>= shift;
+            }
+            *exponent += shift;
+        }
+        bits = 0;
+        
+        // The first twiddle factor of every group is 1, so it is done
+        // without multiplying, which is all of the first stage
+        int stride = n/(2*half);
+        for(int start = 0; start < n; start += 2*half) {
+            int a = start;
+            int b = a + half;
+            int tr = re[b];
+            int ti = im[b];
+            re[b] = re[a] - tr;
+            im[b] = im[a] - ti;
+            re[a] += tr;
+            im[a] += ti;
+            
+            for(int k = 1; k < half; k++) {
+                int wr = cos_q[k*stride];
+                int wi = sin_q[k*stride];
+                a = start + k;
+                b = a + half;
+                tr = (re[b]*wr - im[b]*wi + round) >> FIXED_FFT_BITS;
+                ti = (re[b]*wi + im[b]*wr + round) >> FIXED_FFT_BITS;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+        for(int i = 0; i < n; i++) {
+            bits |= (re[i] ^ (re[i] >> 31)) | (im[i] ^ (im[i] >> 31));
+        }
+    }
+}
+
+float ChaosFFT::fastLog2(unsigned long long value) {
+    /**
+    *   Quick base 2 logarithm of an integer such as a power from
+    *   forwardFixed().  The top bit gives the integer part and the next
+    *   23 bits m the fraction, with log2(1 + m) taken from a polynomial
+    *   that is within 0.001 of it.  Returns -1 for 0.
+    */
+    if(value == 0) {
+        return -1;
+    }
+    int top = 63 - __builtin_clzll(value);
+    unsigned long long mantissa;
+    if(top >= 23) {
+        mantissa = value >> (top - 23);
+    } else {
+        mantissa = value << (23 - top);
+    }
+    float m = float(mantissa & 0x7fffff)*(1.0f/8388608.0f);
+    return top + m + m*(1 - m)*(0.42285f - 0.1592f*m);
+}
@@ -0,0 +1,48 @@
+/**
+ * \file ChaosFFT.h
+ * \brief Headers for ChaosFFT.cpp
+ */
+
+#ifndef CHAOSFFT_H
+#define CHAOSFFT_H
+
+// Fixed point twiddle factors are scaled by 2^FIXED_FFT_BITS
+#define FIXED_FFT_BITS 14
+
+// forwardFixed() halves the data before a stage until it is below this,
+// which keeps every product and sum inside 32 bits
+#define FIXED_FFT_HEADROOM (1 << 14)
+
+class ChaosFFT
+{
+    public:
+        // class constructor
+        ChaosFFT();
+        // class destructor
+        ~ChaosFFT();
+        void setSize(int size);
+        int getSize();
+        void forward(float* re, float* im);
+        void inverse(float* re, float* im);
+        void forwardFixed(int* re, int* im, int* exponent);
+        
+        static int nextPowerOfTwo(int n);
+        static float fastLog2(unsigned long long value);
+        
+    private:
+        void transform(float* re, float* im);
+        
+        int size;
+        int log2_size;
+        
+        // Twiddle factors for the largest stage and the bit reversed order
+        float* cos_table;
+        float* sin_table;
+        int* reversed;
+        
+        // Twiddle factors for forwardFixed()
+        int* fixed_cos;
+        int* fixed_sin;
+};
+
+#endif // CHAOSFFT_H
@@ -5,15 +5,24 @@
 
 #include "ChaosPanel.h"
 #include "ChaosSettings.h"
+#include "ChaosChannels.h"
 #include "../icons/zoom.xpm"
 #include "../icons/bullet_red.xpm"
 #include "../icons/bullet_green.xpm"
 #include "../icons/bullet_blue.xpm"
 #include "../icons/control_pause_blue.xpm"
 
+// Samples of a capture the XT plot can show across it, the first is the
+// length of the average and the last the longest capture libchaos makes
+#define XT_NUM_SPANS 4
+static const int xt_spans[XT_NUM_SPANS] = { AVERAGE_POINTS, 1020, 2040, 8160 };
+
+// Brightness the XY phosphor keeps from one capture to the next
+#define XY_NUM_PERSISTENCES 3
+static const float xy_persistences[XY_NUM_PERSISTENCES] = { 0.7f, 0.9f, 0.97f };
+
 BEGIN_EVENT_TABLE(ChaosPanel, wxPanel)
    EVT_PAINT(ChaosPanel::OnPaint)
-   EVT_IDLE(ChaosPanel::OnIdle)
    EVT_CHOICE(ID_CHOICE, ChaosPanel::OnChoice)
    EVT_TOOL(ID_DEFAULT_ZOOM, ChaosPanel::OnZoomDefault)
    EVT_TOOL_RANGE(ID_XT_X1, ID_XT_X3, ChaosPanel::OnShowXTClick)
@@ -22,8 +31,35 @@ BEGIN_EVENT_TABLE(ChaosPanel, wxPanel)
    EVT_MENU(ID_MNU_SAVETOPNG, ChaosPanel::OnMnuSaveToPNG)
    EVT_MENU(ID_MNU_GAME, ChaosPanel::OnMnuGame)
    EVT_MENU(ID_MNU_RECOLLECT, ChaosPanel::OnMnuRecollect)
+   EVT_MENU(ID_MNU_STATISTICS, ChaosPanel::OnMnuStatistics)
    EVT_TOOL(ID_3D_PLAY, ChaosPanel::On3DPlayPause)
    EVT_COMMAND_SCROLL_THUMBTRACK(ID_3D_SLIDER, ChaosPanel::On3DSliderChange)
+   EVT_CHECKBOX(ID_RETURN_DENSITY, ChaosPanel::OnDensityClick)
+   EVT_SPINCTRL(ID_RETURN_LAG, ChaosPanel::OnLagChange)
+   EVT_CHOICE(ID_POINCARE_AXIS, ChaosPanel::OnPoincareAxisChoice)
+   EVT_SPINCTRL(ID_POINCARE_LEVEL, ChaosPanel::OnPoincareLevelChange)
+   EVT_SPINCTRL(ID_RECURRENCE_THRESHOLD, ChaosPanel::OnRecurrenceThresholdChange)
+   EVT_BUTTON(ID_RETURN_SUGGEST, ChaosPanel::OnSuggestLag)
+   EVT_CHOICE(ID_DELAY_CHANNEL, ChaosPanel::OnDelayChannelChoice)
+   EVT_CHECKBOX(ID_HISTOGRAM_LOG, ChaosPanel::OnHistogramLogClick)
+   EVT_BUTTON(ID_HISTOGRAM_RESET, ChaosPanel::OnHistogramReset)
+   EVT_CHECKBOX(ID_FREQUENCY_HARMONICS, ChaosPanel::OnFrequencyHarmonicsClick)
+   EVT_BUTTON(ID_FREQUENCY_RESET, ChaosPanel::OnFrequencyReset)
+   EVT_CHOICE(ID_CROSS_PAIR, ChaosPanel::OnCrossPairChoice)
+   EVT_CHOICE(ID_CROSS_QUANTITY, ChaosPanel::OnCrossQuantityChoice)
+   EVT_BUTTON(ID_CROSS_RESET, ChaosPanel::OnCrossReset)
+   EVT_CHECKBOX(ID_XT_AVERAGE, ChaosPanel::OnXTAverageClick)
+   EVT_CHECKBOX(ID_XT_ENVELOPE, ChaosPanel::OnXTEnvelopeClick)
+   EVT_CHOICE(ID_XT_DERIVED, ChaosPanel::OnXTDerivedChoice)
+   EVT_CHOICE(ID_XT_SPAN, ChaosPanel::OnXTSpanChoice)
+   EVT_CHECKBOX(ID_XY_PHOSPHOR, ChaosPanel::OnXYPhosphorClick)
+   EVT_CHOICE(ID_XY_PERSISTENCE, ChaosPanel::OnXYPersistenceChoice)
+   EVT_CHOICE(ID_XY_X_CHANNEL, ChaosPanel::OnXYChannelChoice)
+   EVT_CHOICE(ID_XY_Y_CHANNEL, ChaosPanel::OnXYChannelChoice)
+   EVT_CHOICE(ID_3D_X_CHANNEL, ChaosPanel::On3DChannelChoice)
+   EVT_CHOICE(ID_3D_Y_CHANNEL, ChaosPanel::On3DChannelChoice)
+   EVT_CHOICE(ID_3D_Z_CHANNEL, ChaosPanel::On3DChannelChoice)
+   EVT_CHECKBOX(ID_3D_PERSPECTIVE, ChaosPanel::On3DPerspectiveClick)
 END_EVENT_TABLE()
 
 ChaosPanel::ChaosPanel(wxWindow* parent, wxWindowID id, const wxPoint& pos,
@@ -37,7 +73,6 @@ ChaosPanel::ChaosPanel(wxWindow* parent, wxWindowID id, const wxPoint& pos,
     plotType = plot;
     wxLogMessage(wxT("Creating panel with plot type: %d"), plotType);
     initGUI();
-    this->SetExtraStyle(wxWS_EX_PROCESS_IDLE);
     Hide();
 }
 
@@ -117,6 +152,14 @@ void ChaosPanel::initToolbar() {
     choices.Add(wxT("Return Map 2"));
     choices.Add(wxT("FFT"));
     choices.Add(wxT("3D Plot"));
+    choices.Add(wxT("Delay Embedding"));
+    choices.Add(wxT("Poincare Section"));
+    choices.Add(wxT("Correlation Dimension"));
+    choices.Add(wxT("Recurrence Plot"));
+    choices.Add(wxT("Delay Selection"));
+    choices.Add(wxT("Amplitude Histogram"));
+    choices.Add(wxT("Frequency Tracking"));
+    choices.Add(wxT("Cross Spectrum"));
     
     graphChoice = new wxChoice(toolbar, ID_CHOICE, wxPoint(25, 5), wxSize(120, 21), choices, 0, wxDefaultValidator, wxT("graphChoice"));
     
@@ -174,16 +217,53 @@ void ChaosPanel::initNewPlot() {
             break;
         case CHAOS_XY:
             plotPanel = new XYPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addXYTools();
             break;
         case CHAOS_XT:
             plotPanel = new XTPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
             addXTTools();
             break;
         case CHAOS_RETURN1:
-            plotPanel = new Return1Plot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            plotPanel = new ReturnMapPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100), 
+                                          wxTAB_TRAVERSAL, wxT("panel"), ReturnMapEngine::PEAK_RETURN, 1);
+            addReturnMapTools();
             break;
         case CHAOS_RETURN2:
-            plotPanel = new Return2Plot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            plotPanel = new ReturnMapPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100), 
+                                          wxTAB_TRAVERSAL, wxT("panel"), ReturnMapEngine::PEAK_RETURN, 2);
+            addReturnMapTools();
+            break;
+        case CHAOS_DELAY:
+            plotPanel = new ReturnMapPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100), 
+                                          wxTAB_TRAVERSAL, wxT("panel"), ReturnMapEngine::DELAY_EMBEDDING, 10);
+            addReturnMapTools();
+            break;
+        case CHAOS_POINCARE:
+            plotPanel = new PoincarePlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addPoincareTools();
+            break;
+        case CHAOS_CORRELATION:
+            plotPanel = new CorrelationPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            break;
+        case CHAOS_RECURRENCE:
+            plotPanel = new RecurrencePlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addRecurrenceTools();
+            break;
+        case CHAOS_DELAY_SELECTION:
+            plotPanel = new DelayPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addDelayTools();
+            break;
+        case CHAOS_HISTOGRAM:
+            plotPanel = new HistogramPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addHistogramTools();
+            break;
+        case CHAOS_FREQUENCY:
+            plotPanel = new FrequencyPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addFrequencyTools();
+            break;
+        case CHAOS_CROSS_SPECTRUM:
+            plotPanel = new CrossSpectrumPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
+            addCrossSpectrumTools();
             break;
         case CHAOS_FFT:
             plotPanel = new FFTPlot(this, wxID_ANY, wxPoint(5, 30), wxSize(200, 100));
@@ -219,29 +299,23 @@ void ChaosPanel::OnChoice(wxCommandEvent& evt) {
     initNewPlot();
 }
 
-void ChaosPanel::OnIdle(wxIdleEvent& evt) {
+bool ChaosPanel::needsRedraw() {
     /**
-    *   Event handler for idle events.
-    *   If we don't have anything else we need to do, draw our plot.
+    *   Returns true if the panel is shown and its plot has changed since
+    *   its last frame.  The main window only draws the plots that need
+    *   it, so any number of new captures, zooms and resizes between two
+    *   frames come out as a single frame and a panel with nothing new to
+    *   show costs next to nothing.
     */
-    
-    if(plotPanel && isShown) {
-        drawPlot();
-        if(plotType == CHAOS_BIFURCATION) {
-            evt.RequestMore();
-        }
-    }
+    return plotPanel && isShown && plotPanel->needsRedraw();
 }
 
 void ChaosPanel::OnPaint(wxPaintEvent& evt) {
     /**
-    *   Event handler for painting the ChaosPanel
-    *   Redraws the plot
+    *   Event handler for painting the ChaosPanel.  The plot keeps its
+    *   last frame and repaints itself from it, so nothing is drawn here.
     */
     wxPaintDC dc(this);
-    if(isShown) {
-        drawPlot();
-    }
 }
 
 void ChaosPanel::Show() {
@@ -256,6 +330,9 @@ void ChaosPanel::Show() {
     }
     
     isShown = true;
+    if(plotPanel) {
+        plotPanel->invalidate();
+    }
     
     if(plotType == CHAOS_BIFURCATION) {
         ChaosSettings::BifVisible = true;
@@ -272,6 +349,17 @@ void ChaosPanel::Hide() {
     }
 }
 
+void ChaosPanel::channelsChanged() {
+    /**
+    *   Informs the panel that the derived channels were redefined. Plots
+    *   with channel choices are rebuilt so the choices list the new
+    *   channels.
+    */
+    if(plotType == CHAOS_XT || plotType == CHAOS_XY || plotType == CHAOS_3D) {
+        initNewPlot();
+    }
+}
+
 ChaosPlot* ChaosPanel::getChaosPlot() {
     /**
     *   Returns the panel that is being displayed. This is used by the
@@ -285,8 +373,10 @@ void ChaosPanel::OnZoomDefault(wxCommandEvent& evt) {
     *   Calls the appropriate zoom function on the chaos plot to reset
     *   the display.  If this was a bifurcation, it sets the redraw flag.
     */
-    if(plotPanel)
+    if(plotPanel) {
         plotPanel->zoomDefault();
+        plotPanel->invalidate();
+    }
         
     if(plotType == CHAOS_BIFURCATION) {
         ChaosSettings::BifRedraw = true;
@@ -296,20 +386,68 @@ void ChaosPanel::OnZoomDefault(wxCommandEvent& evt) {
 void ChaosPanel::clearPlotTools() {
     /**
     *   Removes all of the specialized plot tools from the toolbar so that
-    *   we have a clean slate to add the appropriate ones to.
+    *   we have a clean slate to add the appropriate ones to.  The tools
+    *   are deleted rather than removed, which would leave their controls
+    *   behind as children of the toolbar on every plot switch.
+    */
+    toolbar->DeleteTool(ID_XT_X1);
+    toolbar->DeleteTool(ID_XT_X2);
+    toolbar->DeleteTool(ID_XT_X3);
+    toolbar->DeleteTool(ID_BIF_PLAY);
+    toolbar->DeleteTool(ID_3D_PLAY);
+    toolbar->DeleteTool(ID_3D_SLIDER);
+    toolbar->DeleteTool(ID_RETURN_DENSITY);
+    toolbar->DeleteTool(ID_RETURN_LAG);
+    toolbar->DeleteTool(ID_POINCARE_AXIS);
+    toolbar->DeleteTool(ID_POINCARE_LEVEL);
+    toolbar->DeleteTool(ID_RECURRENCE_THRESHOLD);
+    toolbar->DeleteTool(ID_RETURN_SUGGEST);
+    toolbar->DeleteTool(ID_DELAY_CHANNEL);
+    toolbar->DeleteTool(ID_HISTOGRAM_LOG);
+    toolbar->DeleteTool(ID_HISTOGRAM_RESET);
+    toolbar->DeleteTool(ID_XT_AVERAGE);
+    toolbar->DeleteTool(ID_XT_ENVELOPE);
+    toolbar->DeleteTool(ID_FREQUENCY_HARMONICS);
+    toolbar->DeleteTool(ID_FREQUENCY_RESET);
+    toolbar->DeleteTool(ID_CROSS_PAIR);
+    toolbar->DeleteTool(ID_CROSS_QUANTITY);
+    toolbar->DeleteTool(ID_CROSS_RESET);
+    toolbar->DeleteTool(ID_XT_DERIVED);
+    toolbar->DeleteTool(ID_XY_X_CHANNEL);
+    toolbar->DeleteTool(ID_XY_Y_CHANNEL);
+    toolbar->DeleteTool(ID_3D_X_CHANNEL);
+    toolbar->DeleteTool(ID_3D_Y_CHANNEL);
+    toolbar->DeleteTool(ID_3D_Z_CHANNEL);
+    toolbar->DeleteTool(ID_XT_SPAN);
+    toolbar->DeleteTool(ID_XY_PHOSPHOR);
+    toolbar->DeleteTool(ID_XY_PERSISTENCE);
+    toolbar->DeleteTool(ID_3D_PERSPECTIVE);
+}
+
+wxChoice* ChaosPanel::newChannelChoice(int id, int selection, bool allow_none) {
+    /**
+    *   Creates a choice of the device and derived channels.  With
+    *   allow_none the first entry is "None", which selects channel -1.
     */
-    toolbar->RemoveTool(ID_XT_X1);
-    toolbar->RemoveTool(ID_XT_X2);
-    toolbar->RemoveTool(ID_XT_X3);
-    toolbar->RemoveTool(ID_BIF_PLAY);
-    toolbar->RemoveTool(ID_3D_PLAY);
-    toolbar->RemoveTool(ID_3D_SLIDER);
+    wxArrayString channels;
+    if(allow_none) {
+        channels.Add(wxT("None"));
+    }
+    for(int c = 0; c < ChaosChannels::getNumChannels(); c++) {
+        channels.Add(ChaosChannels::getName(c));
+    }
+    wxChoice* choice = new wxChoice(toolbar, id, wxDefaultPosition, wxSize(70, -1), channels);
+    choice->SetSelection(allow_none ? selection + 1 : selection);
+    return choice;
 }
 
 void ChaosPanel::addXTTools() {
     /**
     *   Adds the toolbar buttons for the XT graph
     *   These consist of toggle buttons for each of the 3 inputs (X, X', X'')
+    *   and check boxes for averaging the periods and showing their envelope,
+    *   followed by a choice of derived channel to draw as well and a choice
+    *   of how much of the capture to show.
     */
     wxBitmap* toolbarBitmaps[3];
     toolbarBitmaps[0] = new wxBitmap(bullet_red_xpm);
@@ -322,6 +460,17 @@ void ChaosPanel::addXTTools() {
     toolbar->AddCheckTool(ID_XT_X3, wxT("View Xdotdot"), *toolbarBitmaps[2], wxNullBitmap, wxT("View Xdotdot"));
 
     toolbar->ToggleTool(ID_XT_X1, true);
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_XT_AVERAGE, wxT("Average")));
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_XT_ENVELOPE, wxT("Envelope")));
+    toolbar->AddControl(newChannelChoice(ID_XT_DERIVED, -1, true));
+    
+    wxArrayString spans;
+    for(int i = 0; i < XT_NUM_SPANS; i++) {
+        spans.Add(wxString::Format(wxT("%.0f ms"), xt_spans[i]*1000.0/float(LIBCHAOS_SAMPLE_FREQUENCY)));
+    }
+    wxChoice* spanChoice = new wxChoice(toolbar, ID_XT_SPAN, wxDefaultPosition, wxSize(70, -1), spans);
+    spanChoice->SetSelection(0);
+    toolbar->AddControl(spanChoice);
     toolbar->Realize();
 
     // Can delete the bitmaps since they're reference counted
@@ -330,6 +479,28 @@ void ChaosPanel::addXTTools() {
         delete toolbarBitmaps[i];
 }
 
+void ChaosPanel::addXYTools() {
+    /**
+    *   Adds the toolbar controls for the XY graph
+    *   These are choices of the channel drawn along each axis, a check box
+    *   for the phosphor and a choice of how long it persists.
+    */
+    XYPlot* plot = (XYPlot*)plotPanel;
+    toolbar->AddControl(newChannelChoice(ID_XY_X_CHANNEL, plot->getXChannel(), false));
+    toolbar->AddControl(newChannelChoice(ID_XY_Y_CHANNEL, plot->getYChannel(), false));
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_XY_PHOSPHOR, wxT("Phosphor")));
+    
+    wxArrayString persistences;
+    persistences.Add(wxT("Short"));
+    persistences.Add(wxT("Medium"));
+    persistences.Add(wxT("Long"));
+    wxChoice* persistenceChoice = new wxChoice(toolbar, ID_XY_PERSISTENCE, wxDefaultPosition, wxSize(70, -1), persistences);
+    persistenceChoice->SetSelection(1);
+    plot->setPersistence(xy_persistences[1]);
+    toolbar->AddControl(persistenceChoice);
+    toolbar->Realize();
+}
+
 void ChaosPanel::addBifurcationTools() {
     /**
     *   Adds the toolbar buttons for the Bifurcation graph
@@ -355,13 +526,21 @@ void ChaosPanel::add3dTools() {
     /**
     *   Adds the toolbar buttons for the 3d graph
     *   These consist of a play/pause toggle button as well as a slider
-    *   to manually control the rotation of the graph.
+    *   to manually control the rotation of the graph, choices of the
+    *   channel drawn across, up and into the graph and a check box for
+    *   the perspective projection.  The graph can also be turned by
+    *   dragging it and zoomed with the mouse wheel.
     */
     wxBitmap* toolbarBitmaps[1];
     toolbarBitmaps[0] = new wxBitmap(control_pause_blue_xpm);
     
     toolbar->AddCheckTool(ID_3D_PLAY, wxT("Play/Pause Rotation"), *toolbarBitmaps[0], wxNullBitmap, wxT("Play/Pause Rotation"));
     toolbar->AddControl(new wxSlider(toolbar, ID_3D_SLIDER, 0, 0, 25));
+    Rotating3dPlot* plot = (Rotating3dPlot*)plotPanel;
+    toolbar->AddControl(newChannelChoice(ID_3D_X_CHANNEL, plot->getChannel(0), false));
+    toolbar->AddControl(newChannelChoice(ID_3D_Y_CHANNEL, plot->getChannel(1), false));
+    toolbar->AddControl(newChannelChoice(ID_3D_Z_CHANNEL, plot->getChannel(2), false));
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_3D_PERSPECTIVE, wxT("Perspective")));
     
     toolbar->Realize();
 
@@ -371,6 +550,131 @@ void ChaosPanel::add3dTools() {
         delete toolbarBitmaps[i];
 }
 
+void ChaosPanel::addReturnMapTools() {
+    /**
+    *   Adds the toolbar controls for the return maps
+    *   These consist of a check box to draw the points as a density map
+    *   and a spinner to choose k (peaks) or tau (samples).  Delay
+    *   embeddings also get a button that sets tau from the delay analysis.
+    */
+    int lag = ((ReturnMapPlot*)plotPanel)->getLag();
+    
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_RETURN_DENSITY, wxT("Density")));
+    toolbar->AddControl(new wxSpinCtrl(toolbar, ID_RETURN_LAG, 
+                                       wxString::Format(wxT("%d"), lag), 
+                                       wxDefaultPosition, wxSize(60, -1), 
+                                       wxSP_ARROW_KEYS, 1, RETURN_MAP_MAX_LAG, lag));
+    if(((ReturnMapPlot*)plotPanel)->getMode() == ReturnMapEngine::DELAY_EMBEDDING) {
+        toolbar->AddControl(new wxButton(toolbar, ID_RETURN_SUGGEST, wxT("Suggest")));
+    }
+    toolbar->Realize();
+}
+
+void ChaosPanel::addPoincareTools() {
+    /**
+    *   Adds the toolbar controls for the Poincare section
+    *   These consist of the density check box, a choice of which channel
+    *   the plane holds fixed and a spinner for the level of the plane.
+    */
+    PoincarePlot* plot = (PoincarePlot*)plotPanel;
+    
+    wxArrayString axes;
+    axes.Add(wxT("X ="));
+    axes.Add(wxT("X' ="));
+    axes.Add(wxT("X'' ="));
+    wxChoice* axisChoice = new wxChoice(toolbar, ID_POINCARE_AXIS, wxDefaultPosition, wxSize(55, -1), axes);
+    axisChoice->SetSelection(plot->getPlaneAxis());
+    
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_RETURN_DENSITY, wxT("Density")));
+    toolbar->AddControl(axisChoice);
+    toolbar->AddControl(new wxSpinCtrl(toolbar, ID_POINCARE_LEVEL, 
+                                       wxString::Format(wxT("%d"), plot->getPlaneLevel()), 
+                                       wxDefaultPosition, wxSize(60, -1), 
+                                       wxSP_ARROW_KEYS, 0, 1023, plot->getPlaneLevel()));
+    toolbar->Realize();
+}
+
+void ChaosPanel::addRecurrenceTools() {
+    /**
+    *   Adds the toolbar controls for the recurrence plot
+    *   This is a spinner for the recurrence threshold in ADC counts.
+    */
+    int threshold = ((RecurrencePlot*)plotPanel)->getThreshold();
+    
+    toolbar->AddControl(new wxSpinCtrl(toolbar, ID_RECURRENCE_THRESHOLD, 
+                                       wxString::Format(wxT("%d"), threshold), 
+                                       wxDefaultPosition, wxSize(60, -1), 
+                                       wxSP_ARROW_KEYS, 1, 512, threshold));
+    toolbar->Realize();
+}
+
+void ChaosPanel::addDelayTools() {
+    /**
+    *   Adds the toolbar controls for the delay selection plot
+    *   This is a choice of which channel is analysed.
+    */
+    wxArrayString channels;
+    channels.Add(wxT("X"));
+    channels.Add(wxT("X'"));
+    channels.Add(wxT("X''"));
+    wxChoice* channelChoice = new wxChoice(toolbar, ID_DELAY_CHANNEL, wxDefaultPosition, wxSize(50, -1), channels);
+    channelChoice->SetSelection(((DelayPlot*)plotPanel)->getChannel());
+    
+    toolbar->AddControl(channelChoice);
+    toolbar->Realize();
+}
+
+void ChaosPanel::addHistogramTools() {
+    /**
+    *   Adds the toolbar controls for the amplitude histogram
+    *   These consist of a check box for a log scale and a button that
+    *   throws away the counts so far.
+    */
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_HISTOGRAM_LOG, wxT("Log")));
+    toolbar->AddControl(new wxButton(toolbar, ID_HISTOGRAM_RESET, wxT("Reset")));
+    toolbar->Realize();
+}
+
+void ChaosPanel::addFrequencyTools() {
+    /**
+    *   Adds the toolbar controls for the frequency tracking plot
+    *   These consist of a check box for showing the harmonics and a button
+    *   that throws away the frequencies found so far.
+    */
+    toolbar->AddControl(new wxCheckBox(toolbar, ID_FREQUENCY_HARMONICS, wxT("Harmonics")));
+    toolbar->AddControl(new wxButton(toolbar, ID_FREQUENCY_RESET, wxT("Reset")));
+    toolbar->Realize();
+}
+
+void ChaosPanel::addCrossSpectrumTools() {
+    /**
+    *   Adds the toolbar controls for the cross spectrum
+    *   These consist of a choice of the pair of channels, a choice of
+    *   plotting the gain, phase or coherence and a button that throws away
+    *   the averages so far.
+    */
+    CrossSpectrumPlot* plot = (CrossSpectrumPlot*)plotPanel;
+    
+    wxArrayString pairs;
+    pairs.Add(wxT("X to X'"));
+    pairs.Add(wxT("X' to X''"));
+    pairs.Add(wxT("X to X''"));
+    wxChoice* pairChoice = new wxChoice(toolbar, ID_CROSS_PAIR, wxDefaultPosition, wxSize(70, -1), pairs);
+    pairChoice->SetSelection(plot->getPair());
+    
+    wxArrayString quantities;
+    quantities.Add(wxT("Gain"));
+    quantities.Add(wxT("Phase"));
+    quantities.Add(wxT("Coherence"));
+    wxChoice* quantityChoice = new wxChoice(toolbar, ID_CROSS_QUANTITY, wxDefaultPosition, wxSize(75, -1), quantities);
+    quantityChoice->SetSelection(plot->getQuantity());
+    
+    toolbar->AddControl(pairChoice);
+    toolbar->AddControl(quantityChoice);
+    toolbar->AddControl(new wxButton(toolbar, ID_CROSS_RESET, wxT("Reset")));
+    toolbar->Realize();
+}
+
 void ChaosPanel::OnShowXTClick(wxCommandEvent& evt) {
     /**
     *   Event handler for the XT toolbar buttons.
@@ -381,6 +685,188 @@ void ChaosPanel::OnShowXTClick(wxCommandEvent& evt) {
     ((XTPlot*)plotPanel)->setX3Visibility(toolbar->GetToolState(ID_XT_X3));
 }
 
+void ChaosPanel::OnXTAverageClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XT average check box.
+    *   Switches between the latest capture and the average of the periods.
+    */
+    ((XTPlot*)plotPanel)->setAveraging(evt.IsChecked());
+}
+
+void ChaosPanel::OnXTDerivedChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XT derived channel choice.  The first entry
+    *   is "None".
+    */
+    ((XTPlot*)plotPanel)->setDerivedChannel(evt.GetSelection() - 1);
+}
+
+void ChaosPanel::OnXTSpanChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XT span choice
+    */
+    ((XTPlot*)plotPanel)->setSpan(xt_spans[evt.GetSelection()]);
+}
+
+void ChaosPanel::OnXYPhosphorClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XY phosphor check box
+    */
+    ((XYPlot*)plotPanel)->setPhosphor(evt.IsChecked());
+}
+
+void ChaosPanel::OnXYPersistenceChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XY persistence choice
+    */
+    ((XYPlot*)plotPanel)->setPersistence(xy_persistences[evt.GetSelection()]);
+}
+
+void ChaosPanel::OnXYChannelChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XY axis channel choices
+    */
+    int x_channel = ((wxChoice*)toolbar->FindControl(ID_XY_X_CHANNEL))->GetSelection();
+    int y_channel = ((wxChoice*)toolbar->FindControl(ID_XY_Y_CHANNEL))->GetSelection();
+    ((XYPlot*)plotPanel)->setChannels(x_channel, y_channel);
+}
+
+void ChaosPanel::On3DChannelChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the 3d axis channel choices
+    */
+    int x_channel = ((wxChoice*)toolbar->FindControl(ID_3D_X_CHANNEL))->GetSelection();
+    int y_channel = ((wxChoice*)toolbar->FindControl(ID_3D_Y_CHANNEL))->GetSelection();
+    int z_channel = ((wxChoice*)toolbar->FindControl(ID_3D_Z_CHANNEL))->GetSelection();
+    ((Rotating3dPlot*)plotPanel)->setChannels(x_channel, y_channel, z_channel);
+}
+
+void ChaosPanel::On3DPerspectiveClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the 3d perspective check box
+    */
+    ((Rotating3dPlot*)plotPanel)->setPerspective(evt.IsChecked());
+}
+
+void ChaosPanel::OnXTEnvelopeClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the XT envelope check box
+    */
+    ((XTPlot*)plotPanel)->setShowEnvelope(evt.IsChecked());
+}
+
+void ChaosPanel::OnDensityClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the return map density check box.
+    *   Switches between plain points and points coloured by hit count.
+    */
+    plotPanel->setDensityMap(evt.IsChecked());
+}
+
+void ChaosPanel::OnLagChange(wxSpinEvent& evt) {
+    /**
+    *   Event handler for the return map lag spinner.
+    *   Changes k or tau on the return map and starts accumulating again.
+    */
+    ((ReturnMapPlot*)plotPanel)->setLag(evt.GetPosition());
+}
+
+void ChaosPanel::OnPoincareAxisChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the Poincare section axis choice.
+    *   Changes which channel the plane holds fixed.
+    */
+    PoincarePlot* plot = (PoincarePlot*)plotPanel;
+    plot->setPlane(evt.GetSelection(), plot->getPlaneLevel());
+}
+
+void ChaosPanel::OnPoincareLevelChange(wxSpinEvent& evt) {
+    /**
+    *   Event handler for the Poincare section level spinner.
+    *   Moves the plane and starts accumulating crossings again.
+    */
+    PoincarePlot* plot = (PoincarePlot*)plotPanel;
+    plot->setPlane(plot->getPlaneAxis(), evt.GetPosition());
+}
+
+void ChaosPanel::OnRecurrenceThresholdChange(wxSpinEvent& evt) {
+    /**
+    *   Event handler for the recurrence threshold spinner
+    */
+    ((RecurrencePlot*)plotPanel)->setThreshold(evt.GetPosition());
+}
+
+void ChaosPanel::OnSuggestLag(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the delay embedding suggest button.
+    *   Sets tau to the one suggested by the delay analysis.
+    */
+    ReturnMapPlot* plot = (ReturnMapPlot*)plotPanel;
+    int lag = plot->getSuggestedLag();
+    plot->setLag(lag);
+    
+    wxSpinCtrl* lagSpin = (wxSpinCtrl*)toolbar->FindControl(ID_RETURN_LAG);
+    if(lagSpin) {
+        lagSpin->SetValue(lag);
+    }
+}
+
+void ChaosPanel::OnDelayChannelChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the delay selection channel choice
+    */
+    ((DelayPlot*)plotPanel)->setChannel(evt.GetSelection());
+}
+
+void ChaosPanel::OnHistogramLogClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the histogram log check box
+    */
+    ((HistogramPlot*)plotPanel)->setLogScale(evt.IsChecked());
+}
+
+void ChaosPanel::OnHistogramReset(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the histogram reset button
+    */
+    ((HistogramPlot*)plotPanel)->reset();
+}
+
+void ChaosPanel::OnFrequencyHarmonicsClick(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the frequency tracking harmonics check box
+    */
+    ((FrequencyPlot*)plotPanel)->setShowHarmonics(evt.IsChecked());
+}
+
+void ChaosPanel::OnFrequencyReset(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the frequency tracking reset button
+    */
+    ((FrequencyPlot*)plotPanel)->reset();
+}
+
+void ChaosPanel::OnCrossPairChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the cross spectrum pair choice
+    */
+    ((CrossSpectrumPlot*)plotPanel)->setPair(evt.GetSelection());
+}
+
+void ChaosPanel::OnCrossQuantityChoice(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the cross spectrum quantity choice
+    */
+    ((CrossSpectrumPlot*)plotPanel)->setQuantity(evt.GetSelection());
+}
+
+void ChaosPanel::OnCrossReset(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the cross spectrum reset button
+    */
+    ((CrossSpectrumPlot*)plotPanel)->reset();
+}
+
 void ChaosPanel::OnBifPlayPause(wxCommandEvent& evt) {
     /**
     *   Event handler for the Bifurcation play/pause button
@@ -405,6 +891,10 @@ void ChaosPanel::OnListRightClick(wxContextMenuEvent& evt)
     if (plotType == CHAOS_BIFURCATION) {
         mnu.Append(ID_MNU_RECOLLECT, wxT("Recollect Bifurcation Data"));
     }
+    if (plotPanel) {
+        mnu.AppendCheckItem(ID_MNU_STATISTICS, wxT("Show Statistics"));
+        mnu.Check(ID_MNU_STATISTICS, plotPanel->getShowStatistics());
+    }
     
     PopupMenu(&mnu);
 }
@@ -429,6 +919,14 @@ void ChaosPanel::OnMnuRecollect(wxCommandEvent& evt) {
     ChaosSettings::BifRedraw = true;
 }
 
+void ChaosPanel::OnMnuStatistics(wxCommandEvent& evt) {
+    /**
+    *   Event handler for the show statistics menu click
+    *   Toggles the channel statistics box on the graph.
+    */
+    plotPanel->setShowStatistics(evt.IsChecked());
+}
+
 void ChaosPanel::OnMnuSaveToPNG(wxCommandEvent& evt) {
     /**
     *   Event handler for the save to image menu click
@@ -9,16 +9,26 @@
 #include <wx/panel.h>
 #include <wx/stattext.h>
 #include <wx/choice.h>
+#include <wx/checkbox.h>
+#include <wx/spinctrl.h>
+#include <wx/button.h>
 #include <wx/log.h>
 #include <wx/listctrl.h>
+#include <wx/timer.h>
 #include "wx/toolbar.h"
 
 #include "ChaosPlot.h"
 #include "BifurcationPlot.h"
 #include "XTPlot.h"
 #include "XYPlot.h"
-#include "Return1Plot.h"
-#include "Return2Plot.h"
+#include "ReturnMapPlot.h"
+#include "PoincarePlot.h"
+#include "CorrelationPlot.h"
+#include "RecurrencePlot.h"
+#include "DelayPlot.h"
+#include "HistogramPlot.h"
+#include "FrequencyPlot.h"
+#include "CrossSpectrumPlot.h"
 #include "FFTPlot.h"
 #include "Rotating3dPlot.h"
 #include "Game.h"
@@ -33,7 +43,15 @@ class ChaosPanel : public wxPanel
             CHAOS_RETURN1,
             CHAOS_RETURN2,
             CHAOS_FFT,
-            CHAOS_3D
+            CHAOS_3D,
+            CHAOS_DELAY,
+            CHAOS_POINCARE,
+            CHAOS_CORRELATION,
+            CHAOS_RECURRENCE,
+            CHAOS_DELAY_SELECTION,
+            CHAOS_HISTOGRAM,
+            CHAOS_FREQUENCY,
+            CHAOS_CROSS_SPECTRUM
         };
         
         // class constructor
@@ -47,8 +65,10 @@ class ChaosPanel : public wxPanel
         // class destructor
         ~ChaosPanel();
         void drawPlot();
+        bool needsRedraw();
         void Show();
         void Hide();
+        void channelsChanged();
         ChaosPlot* getChaosPlot();
         void setStatusBar(wxStatusBar *s);
 
@@ -59,8 +79,17 @@ class ChaosPanel : public wxPanel
         void clearPlotTools();
         void addZoomTool();
         void addXTTools();
+        void addXYTools();
+        wxChoice* newChannelChoice(int id, int selection, bool allow_none);
         void addBifurcationTools();
         void add3dTools();
+        void addReturnMapTools();
+        void addPoincareTools();
+        void addRecurrenceTools();
+        void addDelayTools();
+        void addHistogramTools();
+        void addFrequencyTools();
+        void addCrossSpectrumTools();
         
         //Event Handlers
         void OnChoice(wxCommandEvent& evt);
@@ -69,12 +98,35 @@ class ChaosPanel : public wxPanel
         void OnListRightClick(wxContextMenuEvent &evt);
         void OnMnuSaveToPNG(wxCommandEvent& evt);
         void OnMnuGame(wxCommandEvent& evt);
-        void OnIdle(wxIdleEvent& evt);
         void OnPaint(wxPaintEvent& evt);
         void OnZoomDefault(wxCommandEvent& evt);
         void OnShowXTClick(wxCommandEvent& evt);
         void OnBifPlayPause(wxCommandEvent& evt);
         void OnMnuRecollect(wxCommandEvent& evt);
+        void OnMnuStatistics(wxCommandEvent& evt);
+        void OnDensityClick(wxCommandEvent& evt);
+        void OnLagChange(wxSpinEvent& evt);
+        void OnPoincareAxisChoice(wxCommandEvent& evt);
+        void OnPoincareLevelChange(wxSpinEvent& evt);
+        void OnRecurrenceThresholdChange(wxSpinEvent& evt);
+        void OnSuggestLag(wxCommandEvent& evt);
+        void OnDelayChannelChoice(wxCommandEvent& evt);
+        void OnHistogramLogClick(wxCommandEvent& evt);
+        void OnHistogramReset(wxCommandEvent& evt);
+        void OnXTAverageClick(wxCommandEvent& evt);
+        void OnXTEnvelopeClick(wxCommandEvent& evt);
+        void OnFrequencyHarmonicsClick(wxCommandEvent& evt);
+        void OnFrequencyReset(wxCommandEvent& evt);
+        void OnCrossPairChoice(wxCommandEvent& evt);
+        void OnCrossQuantityChoice(wxCommandEvent& evt);
+        void OnCrossReset(wxCommandEvent& evt);
+        void OnXTDerivedChoice(wxCommandEvent& evt);
+        void OnXTSpanChoice(wxCommandEvent& evt);
+        void OnXYPhosphorClick(wxCommandEvent& evt);
+        void OnXYPersistenceChoice(wxCommandEvent& evt);
+        void OnXYChannelChoice(wxCommandEvent& evt);
+        void On3DChannelChoice(wxCommandEvent& evt);
+        void On3DPerspectiveClick(wxCommandEvent& evt);
         
         // wxWidgets components
         wxChoice* graphChoice;
@@ -99,7 +151,34 @@ class ChaosPanel : public wxPanel
             ID_MNU_GAME,
             ID_3D_SLIDER,
             ID_3D_PLAY,
-            ID_MNU_RECOLLECT
+            ID_MNU_RECOLLECT,
+            ID_MNU_STATISTICS,
+            ID_RETURN_DENSITY,
+            ID_RETURN_LAG,
+            ID_POINCARE_AXIS,
+            ID_POINCARE_LEVEL,
+            ID_RECURRENCE_THRESHOLD,
+            ID_RETURN_SUGGEST,
+            ID_DELAY_CHANNEL,
+            ID_HISTOGRAM_LOG,
+            ID_HISTOGRAM_RESET,
+            ID_XT_AVERAGE,
+            ID_XT_ENVELOPE,
+            ID_FREQUENCY_HARMONICS,
+            ID_FREQUENCY_RESET,
+            ID_CROSS_PAIR,
+            ID_CROSS_QUANTITY,
+            ID_CROSS_RESET,
+            ID_XT_DERIVED,
+            ID_XY_X_CHANNEL,
+            ID_XY_Y_CHANNEL,
+            ID_3D_X_CHANNEL,
+            ID_3D_Y_CHANNEL,
+            ID_3D_Z_CHANNEL,
+            ID_XT_SPAN,
+            ID_XY_PHOSPHOR,
+            ID_XY_PERSISTENCE,
+            ID_3D_PERSPECTIVE
         };
     protected:
         DECLARE_EVENT_TABLE()
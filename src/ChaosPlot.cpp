@@ -3,15 +3,25 @@
  * \brief Contains class for plotting
  */
  
+#include <stdlib.h>
+#include <string.h>
 #include "ChaosPlot.h"
 #include "ChaosSettings.h"
+#include "ChaosStatistics.h"
+#include "ChaosCalibration.h"
+#include "ChaosCapture.h"
 
 BEGIN_EVENT_TABLE(ChaosPlot, wxPanel)
    EVT_LEFT_DOWN(ChaosPlot::OnMouseDown)
    EVT_LEFT_UP(ChaosPlot::OnMouseUp)
    EVT_MOTION(ChaosPlot::OnMouseMove)
+   EVT_SIZE(ChaosPlot::OnSize)
+   EVT_PAINT(ChaosPlot::OnPaint)
+   EVT_ERASE_BACKGROUND(ChaosPlot::OnEraseBackground)
 END_EVENT_TABLE()
 
+unsigned int ChaosPlot::view_generation = 0;
+
 // class constructor
 ChaosPlot::ChaosPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
                        const wxSize& size, long style, const wxString& name) 
@@ -20,8 +30,26 @@ ChaosPlot::ChaosPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
     *   Constructor for the ChaosPlot class
     *   Sets up a default graph with generic sizes/titles
     */
-    dc = NULL;
+    buffer = new wxMemoryDC();
+    bmp = NULL;
+    buffer_dirty = true;
+    layer = new wxMemoryDC();
+    layer_bmp = NULL;
+    layer_dirty = true;
+    layer_width = 0;
+    layer_height = 0;
+    layer_graph_width = 0;
+    layer_graph_height = 0;
+    num_layer_axes = 0;
+    layer_axis = 0;
+    content_dirty = true;
+    drawn_capture = 0;
+    drawn_calibration = 0;
+    drawn_view = 0;
+    deferred = false;
+    raster_pending = false;
     device_connected = false;
+    device_mdac_value = 4095;
     largest_x_value = 1000;
     smallest_x_value = 0;
     smallest_y_value = 0;
@@ -33,6 +61,21 @@ ChaosPlot::ChaosPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
     graph_subtitle = wxT("Graph Subtitle");
     save_to_file = false;
     zoomable_graph = false;
+    density_map = false;
+    show_statistics = false;
+    point_levels = NULL;
+    allocated_levels = 0;
+    level_points = NULL;
+    allocated_level_points = 0;
+    
+    // Density colours run from a pale blue for rarely visited points
+    // to a dark blue for the most visited ones
+    for(int i = 0; i < DENSITY_LEVELS; i++) {
+        float t = float(i)/(DENSITY_LEVELS - 1);
+        density_colours[i] = wxColour((unsigned char)(190*(1 - t)),
+                                      (unsigned char)(210*(1 - t)),
+                                      (unsigned char)(255 - 115*t));
+    }
 }
 
 // class destructor
@@ -40,35 +83,61 @@ ChaosPlot::~ChaosPlot() {
     /**
     *   Deconstructor for the ChaosPlot class
     *   All wxWidgets objects are deleted by the class using the Destory method
+    *   apart from the back buffer and the layer, which are ours.
     */
-
+    buffer->SelectObject(wxNullBitmap);
+    delete buffer;
+    delete bmp;
+    layer->SelectObject(wxNullBitmap);
+    delete layer;
+    delete layer_bmp;
+    free(point_levels);
+    free(level_points);
 }
 
 void ChaosPlot::startDraw() {
     /**
     *   Begins the drawing of a graph by setting up the buffers, drawing 
     *   the graphing rectangle, and placing a title on the graph.
+    *
+    *   The back buffer is reused from the last frame and is only made
+    *   again once it has been invalidated.  The rectangle and titles come
+    *   from the layer, which is only drawn again when the size or titles
+    *   have changed.
     */
     // update the sizes
     this->GetSize(&width, &height);
     graph_width = width - side_gutter_size;
     graph_height = height - bottom_gutter_size - top_gutter_size;
     
-    if(dc) delete dc;
-    dc = new wxClientDC(this);
-
-    // Initialize the buffers
-    bmp = new wxBitmap();
-
-    bmp->SetHeight(height);
-    bmp->SetWidth(width);
-
-    buffer = new wxBufferedDC(dc, *bmp);
+    if(buffer_dirty || bmp == NULL) {
+        int w = width > 0 ? width : 1;
+        int h = height > 0 ? height : 1;
+        buffer->SelectObject(wxNullBitmap);
+        delete bmp;
+        bmp = new wxBitmap(w, h);
+        buffer->SelectObject(*bmp);
+        layer->SelectObject(wxNullBitmap);
+        delete layer_bmp;
+        layer_bmp = new wxBitmap(w, h);
+        layer->SelectObject(*layer_bmp);
+        background = wxBrush(GetBackgroundColour());
+        buffer_dirty = false;
+        layer_dirty = true;
+    }
+    
+    // This frame is drawn from the current state
+    content_dirty = false;
+    drawn_capture = ChaosCapture::getGeneration();
+    drawn_calibration = ChaosCalibration::getVersion();
+    drawn_view = view_generation;
 
-    // Update drawing area
-    int txt_width, txt_height;
-    buffer->GetTextExtent(graph_title, &txt_width, &txt_height);
-    top_gutter_size = 2*txt_height + 5;
+    // Update drawing area, the title is only measured when it changes
+    if(layer_dirty || graph_title != layer_title) {
+        int txt_width, txt_height;
+        layer->GetTextExtent(graph_title, &txt_width, &txt_height);
+        top_gutter_size = 2*txt_height + 5;
+    }
 
     // Return plots are graphed in a square window
     if( square ) {
@@ -80,29 +149,85 @@ void ChaosPlot::startDraw() {
         side_gutter_size = width/2 - graph_width/2;
     }
     
-    // Clear data and draw our rectangle
-    wxPen axisPen(*wxLIGHT_GREY, 1);
-    buffer->SetPen(axisPen);
-    buffer->SetBackground(dc->GetBackground());
-
-    buffer->Clear();
-    buffer->DrawRectangle(side_gutter_size, 
-                          top_gutter_size, 
-                          graph_width, 
-                          graph_height + 1);
+    if(layer_dirty || width != layer_width || height != layer_height ||
+       graph_width != layer_graph_width || graph_height != layer_graph_height ||
+       graph_title != layer_title || graph_subtitle != layer_subtitle) {
+        drawLayerBackground();
+        num_layer_axes = 0;
+        layer_dirty = false;
+        layer_width = width;
+        layer_height = height;
+        layer_graph_width = graph_width;
+        layer_graph_height = graph_height;
+        layer_title = graph_title;
+        layer_subtitle = graph_subtitle;
+    }
+    layer_axis = 0;
+    
+    // Start the frame from the layer
+    buffer->Blit(0, 0, width, height, layer, 0, 0);
+    buffer->SetPen(wxPen(*wxLIGHT_GREY, 1));
+    buffer->SetBrush(*wxWHITE_BRUSH);
+}
+
+void ChaosPlot::drawLayerBackground() {
+    /**
+    *   Clears the layer and draws the graphing rectangle and the titles
+    */
+    layer->SetPen(wxPen(*wxLIGHT_GREY, 1));
+    layer->SetBrush(*wxWHITE_BRUSH);
+    layer->SetBackground(background);
+    layer->Clear();
+    layer->DrawRectangle(side_gutter_size, 
+                         top_gutter_size, 
+                         graph_width, 
+                         graph_height + 1);
                           
     // Draw our graph title
-    buffer->DrawText(graph_title, (width/2) - (txt_width/2), 2);
-    buffer->GetTextExtent(graph_subtitle, &txt_width, &txt_height);
-    buffer->DrawText(graph_subtitle, (width/2) - (txt_width/2), 4+txt_height);
-    
+    int txt_width, txt_height;
+    layer->GetTextExtent(graph_title, &txt_width, &txt_height);
+    layer->DrawText(graph_title, (width/2) - (txt_width/2), 2);
+    layer->GetTextExtent(graph_subtitle, &txt_width, &txt_height);
+    layer->DrawText(graph_subtitle, (width/2) - (txt_width/2), 4+txt_height);
 }
 
 void ChaosPlot::endDraw() {
     /**
     *   Ends a drawing by drawing the zooming rectangle if necessary,
-    *   flushing the buffer, and saving the graph to a file if requested.
+    *   copying the buffer to the screen, and saving the graph to a file if
+    *   requested.
+    *
+    *   While deferred this is left for finishDraw(), to be called once
+    *   the raster has been rendered.
     */    
+    // Axes left in the layer that were not drawn this frame are out of
+    // date, so the layer is drawn again for the next frame
+    if(layer_axis < num_layer_axes) {
+        layer_dirty = true;
+        invalidate();
+    }
+    
+    if(deferred == false) {
+        finishDraw();
+    }
+}
+
+void ChaosPlot::finishDraw() {
+    /**
+    *   Finishes a frame: copies the raster onto the back buffer if it was
+    *   held back, draws anything that goes over the traces and then puts
+    *   the buffer on the screen
+    */
+    if(raster_pending) {
+        raster.end(buffer);
+        raster_pending = false;
+    }
+    drawOverlay();
+    
+    if(show_statistics) {
+        drawStatistics();
+    }
+    
     if(zoomable_graph == true && mouse_dragging == true) {
         buffer->SetPen(wxPen(*wxGREEN, 1));
         buffer->SetBrush(wxBrush(*wxGREEN, wxTRANSPARENT));
@@ -129,13 +254,209 @@ void ChaosPlot::endDraw() {
         delete pictureBmp;
     }
 
-    delete buffer;
-    delete bmp;
+    wxClientDC dc(this);
+    dc.Blit(0, 0, width, height, buffer, 0, 0);
+}
+
+bool ChaosPlot::startRaster(bool keep) {
+    /**
+    *   Starts drawing traces into the raster, which covers the inside of
+    *   the graph rectangle.  Call after startDraw().  With keep, the
+    *   traces of the last frame are drawn over if the graph has not moved;
+    *   returns true if they were kept.
+    */
+    return raster.begin(side_gutter_size + 1, top_gutter_size + 1, graph_width - 1, graph_height - 1, keep);
+}
+
+void ChaosPlot::endRaster() {
+    /**
+    *   Copies the traces drawn into the raster onto the back buffer, or
+    *   leaves it for finishDraw() while deferred
+    */
+    if(deferred) {
+        raster_pending = true;
+    } else {
+        raster.end(buffer);
+    }
+}
+
+void ChaosPlot::setDeferred(bool deferred) {
+    /**
+    *   Chooses whether the traces of a frame are drawn straight away or
+    *   recorded and left for renderFrame() and finishDraw().  Deferred
+    *   frames let several plots render their traces at once on the
+    *   worker pool.
+    */
+    this->deferred = deferred;
+    raster.setDeferred(deferred);
+}
+
+void ChaosPlot::renderFrame() {
+    /**
+    *   Renders the traces recorded by a deferred frame.  Only touches the
+    *   raster, so it can be run on a worker thread between drawPlot() and
+    *   finishDraw().
+    */
+    if(raster_pending) {
+        raster.render();
+    }
+}
+
+void ChaosPlot::drawOverlay() {
+    /**
+    *   Draws anything that goes on top of the traces, such as labels.
+    *   Called by finishDraw() after the raster is copied onto the back
+    *   buffer.  By default only graph_note is drawn, in the top right
+    *   corner of the graph.
+    */
+    if(graph_note.IsEmpty()) {
+        return;
+    }
+    int txt_width, txt_height;
+    buffer->GetTextExtent(graph_note, &txt_width, &txt_height);
+    buffer->DrawText(graph_note, side_gutter_size + graph_width - txt_width - 6, top_gutter_size + 4);
+}
+
+void ChaosPlot::invalidateBuffer() {
+    /**
+    *   Marks the back buffer to be made again before the next frame
+    */
+    buffer_dirty = true;
+}
+
+void ChaosPlot::invalidate() {
+    /**
+    *   Marks the plot to be drawn again on the next frame.  Called
+    *   whenever something the plot shows is changed other than the data.
+    */
+    content_dirty = true;
+}
+
+void ChaosPlot::invalidateAll() {
+    /**
+    *   Marks every plot to be drawn again on the next frame, for settings
+    *   that change how all of them look
+    */
+    view_generation++;
+}
+
+bool ChaosPlot::needsRedraw() {
+    /**
+    *   Returns true if the last frame is out of date: the plot has been
+    *   invalidated or resized, or there is a new capture or calibration
+    *   since it was drawn.  Plots that change on their own as well
+    *   override this.
+    */
+    return content_dirty || buffer_dirty || bmp == NULL ||
+           drawn_capture != ChaosCapture::getGeneration() ||
+           drawn_calibration != ChaosCalibration::getVersion() ||
+           drawn_view != view_generation;
+}
+
+void ChaosPlot::OnSize(wxSizeEvent& evt) {
+    /**
+    *   Event handler for resizing the plot.  The back buffer no longer
+    *   fits, so it is made again on the next frame.
+    */
+    invalidateBuffer();
+    evt.Skip();
+}
+
+void ChaosPlot::OnPaint(wxPaintEvent& evt) {
+    /**
+    *   Event handler for painting the plot.  While the back buffer is
+    *   still valid it holds the last frame, which is copied back to the
+    *   screen without drawing the plot again.
+    */
+    wxPaintDC dc(this);
+    if(!buffer_dirty && bmp != NULL) {
+        dc.Blit(0, 0, width, height, buffer, 0, 0);
+    }
+}
+
+void ChaosPlot::OnEraseBackground(wxEraseEvent& evt) {
+    /**
+    *   Event handler for erasing the background.  The back buffer covers
+    *   the whole plot, so erasing it first would only make it flicker.
+    */
+    if(buffer_dirty || bmp == NULL) {
+        evt.Skip();
+    }
 }
 
 void ChaosPlot::drawYAxis(float bottom, float top, float interval) {
     /**
-    *   Draws the Y-Axis on the graph using the specified minimum and maximum
+    *   Draws the Y-Axis on the graph, see paintYAxis().  It is drawn into
+    *   the layer and only drawn again when the values change.
+    */
+    drawLayerAxis(true, bottom, top, interval);
+}
+
+void ChaosPlot::drawXAxis(float bottom, float top, float interval) {
+    /**
+    *   Draws the X-Axis on the graph, see paintXAxis().  It is drawn into
+    *   the layer and only drawn again when the values change.
+    */
+    drawLayerAxis(false, bottom, top, interval);
+}
+
+void ChaosPlot::drawLayerAxis(bool vertical, float bottom, float top, float interval) {
+    /**
+    *   Draws an axis as part of the layer.
+    *
+    *   The axes a plot draws are kept in order with the values they were
+    *   drawn with.  An axis that matches the one kept in its place is
+    *   already on the frame.  One that does not means the layer is out of
+    *   date from that axis on, so it is drawn again with the axes before
+    *   it and copied back to the frame.  Plots draw their axes before
+    *   anything else, so nothing is lost by the copy.
+    */
+    if(layer_axis < num_layer_axes) {
+        if(layer_axis_vertical[layer_axis] == vertical &&
+           layer_axis_values[layer_axis][0] == bottom &&
+           layer_axis_values[layer_axis][1] == top &&
+           layer_axis_values[layer_axis][2] == interval) {
+            layer_axis++;
+            return;
+        }
+        
+        num_layer_axes = layer_axis;
+        drawLayerBackground();
+        for(int i = 0; i < num_layer_axes; i++) {
+            float* values = layer_axis_values[i];
+            if(layer_axis_vertical[i]) {
+                paintYAxis(layer, values[0], values[1], values[2]);
+            } else {
+                paintXAxis(layer, values[0], values[1], values[2]);
+            }
+        }
+        buffer->Blit(0, 0, width, height, layer, 0, 0);
+    }
+    
+    // Add the axis to the layer if there is room and to this frame
+    if(num_layer_axes < LAYER_AXES) {
+        layer_axis_vertical[num_layer_axes] = vertical;
+        layer_axis_values[num_layer_axes][0] = bottom;
+        layer_axis_values[num_layer_axes][1] = top;
+        layer_axis_values[num_layer_axes][2] = interval;
+        num_layer_axes++;
+        layer_axis = num_layer_axes;
+        if(vertical) {
+            paintYAxis(layer, bottom, top, interval);
+        } else {
+            paintXAxis(layer, bottom, top, interval);
+        }
+    }
+    if(vertical) {
+        paintYAxis(buffer, bottom, top, interval);
+    } else {
+        paintXAxis(buffer, bottom, top, interval);
+    }
+}
+
+void ChaosPlot::paintYAxis(wxDC* dc, float bottom, float top, float interval) {
+    /**
+    *   Draws the Y-Axis on a DC using the specified minimum and maximum
     *   values as well as the interval.
     *
     *   Uses integers as axis labels unless the interval is small, then uses
@@ -146,7 +467,7 @@ void ChaosPlot::drawYAxis(float bottom, float top, float interval) {
     wxString buf;
     
     wxPen axisPen(*wxLIGHT_GREY, 1);
-    buffer->SetPen(axisPen);
+    dc->SetPen(axisPen);
     
     float scale = graph_height/fabs(top - bottom);
     
@@ -162,19 +483,19 @@ void ChaosPlot::drawYAxis(float bottom, float top, float interval) {
         int x = 0;
         int y = (int)(graph_height-scale*i*fabs(interval) + top_gutter_size);
         
-        buffer->DrawText(buf,
-                         side_gutter_size-20+x,
-                         y-8);
-        buffer->DrawLine(side_gutter_size-5,
-                         y,
-                         x+graph_width+side_gutter_size,
-                         y);
+        dc->DrawText(buf,
+                     side_gutter_size-20+x,
+                     y-8);
+        dc->DrawLine(side_gutter_size-5,
+                     y,
+                     x+graph_width+side_gutter_size,
+                     y);
     }
 }
 
-void ChaosPlot::drawXAxis(float bottom, float top, float interval) {
+void ChaosPlot::paintXAxis(wxDC* dc, float bottom, float top, float interval) {
     /**
-    *   Draws the X-Axis on the graph using the specified minimum and maximum
+    *   Draws the X-Axis on a DC using the specified minimum and maximum
     *   values as well as the interval.
     *
     *   Uses integers as axis labels unless the interval is small, then uses
@@ -185,7 +506,7 @@ void ChaosPlot::drawXAxis(float bottom, float top, float interval) {
     wxString buf;
     
     wxPen axisPen(*wxLIGHT_GREY, 1);
-    buffer->SetPen(axisPen);
+    dc->SetPen(axisPen);
     
     float scale = graph_width/fabs(top - bottom);
     
@@ -201,13 +522,13 @@ void ChaosPlot::drawXAxis(float bottom, float top, float interval) {
         int x = (int)(scale*i*fabs(interval) + side_gutter_size);
         int y = (int)(graph_height + top_gutter_size);
         
-        buffer->DrawText(buf,
-                         x-15,
-                         y+5);
-        buffer->DrawLine(x,
-                         y+5,
-                         x,
-                         top_gutter_size);
+        dc->DrawText(buf,
+                     x-15,
+                     y+5);
+        dc->DrawLine(x,
+                     y+5,
+                     x,
+                     top_gutter_size);
     }
 }
 
@@ -217,6 +538,9 @@ void ChaosPlot::setDeviceStatus(bool connected, int value) {
     *   This is used by graphs to determine if they should draw data or not.
     *   and gives them the ability to read the current mdac value.
     */
+    if(connected != device_connected || value != device_mdac_value) {
+        invalidate();
+    }
     device_connected = connected;
     device_mdac_value = value;
 }
@@ -230,6 +554,7 @@ void ChaosPlot::OnMouseDown(wxMouseEvent& evt) {
     evt.Skip();
     mouse_dragging = true;
     current_position = drag_start = evt.GetPosition();
+    invalidate();
 }
 
 void ChaosPlot::OnMouseUp(wxMouseEvent& evt) {
@@ -288,6 +613,7 @@ void ChaosPlot::OnMouseUp(wxMouseEvent& evt) {
     
     // We aren't dragging the mouse anymore
     mouse_dragging = false;
+    invalidate();
 }
 
 void ChaosPlot::OnMouseMove(wxMouseEvent& evt) {
@@ -297,6 +623,9 @@ void ChaosPlot::OnMouseMove(wxMouseEvent& evt) {
     */
     if(mouse_dragging == true) {
         current_position = evt.GetPosition();
+        if(zoomable_graph == true) {
+            invalidate();
+        }
     }
     UpdateStatusBar(evt.m_x, evt.m_y);
 }
@@ -341,16 +670,131 @@ void ChaosPlot::zoomDefault() {
     return;
 }
 
-void ChaosPlot::drawPoint(wxDC* buffer, int x, int y) {
+void ChaosPlot::drawPoints(const wxPoint* points, int num_points) {
     /**
-    *   Draws a point at the given (X,Y) coordinate on the given DC using
-    *   the point size specified in the settings.  Use this so you don't
-    *   have to check the point size yourself when drawing a point.
+    *   Draws points into the raster in its current colour using the point
+    *   size specified in the settings.  Use this so you don't have to
+    *   check the point size yourself when drawing points.
     */
-    if(ChaosSettings::PointSize == ChaosSettings::SMALL_PT) {
-        buffer->DrawPoint(x, y);
+    raster.drawPoints(points, num_points, ChaosSettings::PointSize);
+}
+
+void ChaosPlot::drawDensityPoints(const wxPoint* points, const unsigned char* levels, int num_points) {
+    /**
+    *   Draws points into the raster in the colour of their density level,
+    *   from densityLevel().  The points are sorted by level so each
+    *   colour is drawn in one go, with the most visited points on top.
+    */
+    if(num_points > allocated_level_points) {
+        level_points = (wxPoint*)realloc(level_points, num_points*sizeof(wxPoint));
+        allocated_level_points = num_points;
+    }
+    int starts[DENSITY_LEVELS + 1] = { 0 };
+    for(int i = 0; i < num_points; i++) {
+        starts[levels[i] + 1]++;
+    }
+    for(int level = 0; level < DENSITY_LEVELS; level++) {
+        starts[level + 1] += starts[level];
+    }
+    int next[DENSITY_LEVELS];
+    memcpy(next, starts, sizeof(next));
+    for(int i = 0; i < num_points; i++) {
+        level_points[next[levels[i]]++] = points[i];
+    }
+    for(int level = 0; level < DENSITY_LEVELS; level++) {
+        if(starts[level + 1] > starts[level]) {
+            raster.setColour(density_colours[level]);
+            drawPoints(level_points + starts[level], starts[level + 1] - starts[level]);
+        }
+    }
+}
+
+int ChaosPlot::densityLevel(unsigned int hits, unsigned int max_hits) {
+    /**
+    *   Returns the density level of a point that has been hit the given
+    *   number of times.  Levels are spaced logarithmically so that rarely
+    *   visited points remain visible next to very dense ones.
+    */
+    int level = DENSITY_LEVELS - 1;
+    if(max_hits > 1) {
+        level = (int)((DENSITY_LEVELS - 1)*log(float(hits))/log(float(max_hits)) + 0.5);
+    }
+    if(level < 0) level = 0;
+    if(level > DENSITY_LEVELS - 1) level = DENSITY_LEVELS - 1;
+    return level;
+}
+
+unsigned char* ChaosPlot::getPointLevels(int num_points) {
+    /**
+    *   Returns an array of at least num_points density levels for the
+    *   caller to fill in alongside the raster's points.  It is kept
+    *   between frames.
+    */
+    if(num_points > allocated_levels) {
+        point_levels = (unsigned char*)realloc(point_levels, num_points);
+        allocated_levels = num_points;
+    }
+    return point_levels;
+}
+
+void ChaosPlot::setDensityMap(bool enabled) {
+    /**
+    *   Enables or disables drawing accumulated points coloured by how
+    *   often they have been hit.  Only used by plots that accumulate points.
+    */
+    density_map = enabled;
+    invalidate();
+}
+
+void ChaosPlot::setShowStatistics(bool show) {
+    /**
+    *   Shows or hides the channel statistics in the corner of the graph
+    */
+    show_statistics = show;
+    invalidate();
+}
+
+bool ChaosPlot::getShowStatistics() {
+    /**
+    *   Returns true if the channel statistics are shown
+    */
+    return show_statistics;
+}
+
+void ChaosPlot::drawStatistics() {
+    /**
+    *   Draws a box in the top left corner of the graph with the running
+    *   statistics of each channel since the MDAC value last changed.
+    */
+    static const wxChar* names[] = { wxT("X"), wxT("X'"), wxT("X''") };
+    wxString lines[4];
+    float minimum, maximum, mean, rms, p2p;
+    
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        lines[0] = wxString::Format(wxT("%u captures (ADC)"), ChaosStatistics::getNumCaptures());
     } else {
-        buffer->DrawCircle(x, y, ChaosSettings::PointSize);
+        lines[0] = wxString::Format(wxT("%u captures (V)"), ChaosStatistics::getNumCaptures());
+    }
+    for(int c = 0; c < 3; c++) {
+        ChaosStatistics::getValues(c, true, &minimum, &maximum, &mean, &rms, &p2p);
+        lines[c + 1] = wxString::Format(wxT("%s  min %.2f  max %.2f  mean %.2f  rms %.2f  p-p %.2f"),
+                                        names[c], minimum, maximum, mean, rms, p2p);
+    }
+    
+    int box_width = 0, line_height = 0;
+    for(int i = 0; i < 4; i++) {
+        int w, h;
+        buffer->GetTextExtent(lines[i], &w, &h);
+        if(w > box_width) box_width = w;
+        line_height = h;
+    }
+    
+    buffer->SetPen(wxPen(*wxLIGHT_GREY, 1));
+    buffer->SetBrush(*wxWHITE_BRUSH);
+    buffer->DrawRectangle(side_gutter_size + 4, top_gutter_size + 4,
+                          box_width + 8, 4*line_height + 6);
+    for(int i = 0; i < 4; i++) {
+        buffer->DrawText(lines[i], side_gutter_size + 8, top_gutter_size + 7 + i*line_height);
     }
 }
 
@@ -361,6 +805,7 @@ void ChaosPlot::saveToFile(wxString filename) {
     */
     save_to_file = true;
     save_filename = filename;
+    invalidate();
 }
 
 void ChaosPlot::setStatusBar(wxStatusBar *s) {
@@ -380,11 +825,7 @@ void ChaosPlot::UpdateStatusBar(int m_x, int m_y) {
         x = xToValue(m_x);
         y = yToValue(m_y);
         
-        if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-            y = y*3.3/1024 - 1.2;
-        } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-            y = y*3.3/1024;
-        }
+        y = ChaosCalibration::toUnits(ChaosCapture::X1, y);
         
         statusBar->SetStatusText(wxString::Format(wxT("(%.3f,%.3f)"),
                                         x,
@@ -8,6 +8,13 @@
 #include <wx/dcbuffer.h>
 #include <wx/panel.h>
 #include <wx/wx.h>
+#include "PlotRaster.h"
+
+// Number of colours used when drawing hit counts as a density
+#define DENSITY_LEVELS 8
+
+// Most axes kept in the cached layer of a plot
+#define LAYER_AXES 4
 
 class ChaosPlot : public wxPanel
 {
@@ -30,6 +37,16 @@ class ChaosPlot : public wxPanel
         virtual void zoomDefault();
         void saveToFile(wxString filename);
         void setStatusBar(wxStatusBar *s);
+        void setDensityMap(bool enabled);
+        void setShowStatistics(bool show);
+        bool getShowStatistics();
+        void invalidateBuffer();
+        void invalidate();
+        virtual bool needsRedraw();
+        static void invalidateAll();
+        void setDeferred(bool deferred);
+        void renderFrame();
+        void finishDraw();
         
         protected:
         virtual int xToValue(int x);
@@ -37,10 +54,31 @@ class ChaosPlot : public wxPanel
         virtual int valueToX(int value);
         virtual int valueToY(int value);
         virtual void UpdateStatusBar(int m_x, int m_y);
-        void drawPoint(wxDC* buffer, int x, int y);
+        void drawPoints(const wxPoint* points, int num_points);
+        void drawDensityPoints(const wxPoint* points, const unsigned char* levels, int num_points);
+        int densityLevel(unsigned int hits, unsigned int max_hits);
+        unsigned char* getPointLevels(int num_points);
+        void drawStatistics();
+        virtual void drawOverlay();
+        bool startRaster(bool keep = false);
+        void endRaster();
+        void drawLayerBackground();
+        void drawLayerAxis(bool vertical, float bottom, float top, float interval);
+        void paintYAxis(wxDC* dc, float bottom, float top, float interval);
+        void paintXAxis(wxDC* dc, float bottom, float top, float interval);
         bool save_to_file;
         wxString save_filename;
         bool zoomable_graph;
+        bool density_map;
+        bool show_statistics;
+        
+        // Colours of the density levels, and room for the level of each
+        // point and for the points sorted by level
+        wxColour density_colours[DENSITY_LEVELS];
+        unsigned char* point_levels;
+        int allocated_levels;
+        wxPoint* level_points;
+        int allocated_level_points;
         
         // Variables used for zooming
         int largest_x_value;
@@ -61,9 +99,51 @@ class ChaosPlot : public wxPanel
         //int* mdac_value;
         wxString graph_title;
         wxString graph_subtitle;
-        wxBufferedDC* buffer;
+        // Value that changes with the captures, such as a count or a
+        // result, drawn in the corner of the graph by drawOverlay() so the
+        // titles stay fixed and the layer is kept
+        wxString graph_note;
+        
+        // Back buffer kept from frame to frame.  The bitmap is only made
+        // again when buffer_dirty is set, which happens when the plot is
+        // resized.
+        wxMemoryDC* buffer;
         wxBitmap* bmp;
-        wxClientDC* dc;
+        wxBrush background;
+        bool buffer_dirty;
+        
+        // Layer holding the background, titles, axes, labels and grid,
+        // which is copied under every frame.  It is kept until the size
+        // or titles change or an axis is drawn with different values.
+        wxMemoryDC* layer;
+        wxBitmap* layer_bmp;
+        bool layer_dirty;
+        wxString layer_title;
+        wxString layer_subtitle;
+        int layer_width;
+        int layer_height;
+        int layer_graph_width;
+        int layer_graph_height;
+        int num_layer_axes;
+        int layer_axis;
+        bool layer_axis_vertical[LAYER_AXES];
+        float layer_axis_values[LAYER_AXES][3];
+        
+        // State the last frame was drawn from.  A new frame is only drawn
+        // once something it depends on has changed, see needsRedraw().
+        bool content_dirty;
+        unsigned int drawn_capture;
+        unsigned int drawn_calibration;
+        unsigned int drawn_view;
+        static unsigned int view_generation;
+        
+        // Pixel buffer covering the inside of the graph for drawing traces
+        PlotRaster raster;
+        
+        // While deferred, endRaster() and endDraw() leave the rest of the
+        // frame for renderFrame() and finishDraw()
+        bool deferred;
+        bool raster_pending;
         bool square;
         wxStatusBar *statusBar;
         
@@ -76,6 +156,9 @@ class ChaosPlot : public wxPanel
         void OnMouseDown(wxMouseEvent& evt);
         virtual void OnMouseUp(wxMouseEvent& evt);
         void OnMouseMove(wxMouseEvent& evt);
+        void OnSize(wxSizeEvent& evt);
+        void OnPaint(wxPaintEvent& evt);
+        void OnEraseBackground(wxEraseEvent& evt);
 };
 
 #endif // CHAOSPLOT_H
@@ -0,0 +1,345 @@
+/**
+ * \file ChaosRecord.cpp
+ * \brief Long record of the captures stored in chunks
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include "ChaosRecord.h"
+#include "ChaosCapture.h"
+
+namespace ChaosRecord {
+    /**
+    *   The chunks form a ring of up to max_chunks slots.  The memory of a
+    *   slot is allocated the first time it is used and kept until the
+    *   memory limit changes.  While the record is held, memory that would
+    *   be reused or freed is retired instead and freed on release.
+    */
+    struct Chunk {
+        short* channels[ChaosCapture::NUM_CHANNELS];
+        int num_points;
+        long long start;
+    };
+
+    Chunk* slots = NULL;
+    int max_chunks = 0;
+    int memory_limit = 0;
+    int first_slot = 0;
+    int num_chunks = 0;
+    long long end_position = 0;
+    int mdac_value = -1;
+    unsigned int generation = 0;
+    wxMutex record_mutex;
+
+    // Start of every capture still in the record, oldest first
+    long long* capture_starts = NULL;
+    int num_captures = 0;
+    int captures_allocated = 0;
+
+    // Chunk memory that cannot be reused until the holders have finished
+    int holders = 0;
+    short** retired = NULL;
+    int num_retired = 0;
+    int retired_allocated = 0;
+
+    void retire(short* data) {
+        /**
+        *   Frees chunk memory, or keeps it until release() if anyone is
+        *   still reading the record
+        */
+        if(holders == 0) {
+            free(data);
+            return;
+        }
+        if(num_retired == retired_allocated) {
+            retired_allocated = retired_allocated ? 2*retired_allocated : 8;
+            retired = (short**)realloc(retired, retired_allocated*sizeof(short*));
+        }
+        retired[num_retired++] = data;
+    }
+
+    Chunk* getSlot(int chunk) {
+        /**
+        *   Returns the slot of the chunk-th oldest chunk
+        */
+        return &slots[(first_slot + chunk) % max_chunks];
+    }
+
+    void dropCaptures() {
+        /**
+        *   Forgets the captures that have no samples left in the record
+        */
+        long long start = getSlot(0)->start;
+        int dropped = 0;
+        while(dropped < num_captures - 1 && capture_starts[dropped + 1] <= start) {
+            dropped++;
+        }
+        if(dropped > 0) {
+            num_captures -= dropped;
+            memmove(capture_starts, capture_starts + dropped, num_captures*sizeof(long long));
+        }
+    }
+
+    Chunk* newChunk() {
+        /**
+        *   Starts a new chunk after the newest one, dropping the oldest
+        *   chunk if the record is at its memory limit
+        */
+        if(num_chunks == max_chunks) {
+            first_slot = (first_slot + 1) % max_chunks;
+            num_chunks--;
+        }
+        Chunk* chunk = getSlot(num_chunks);
+        if(chunk->channels[0] != NULL && holders > 0) {
+            // The old contents may still be read
+            retire(chunk->channels[0]);
+            chunk->channels[0] = NULL;
+        }
+        if(chunk->channels[0] == NULL) {
+            short* data = (short*)malloc(RECORD_CHUNK_BYTES);
+            for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+                chunk->channels[c] = data + c*RECORD_CHUNK_POINTS;
+            }
+        }
+        chunk->num_points = 0;
+        chunk->start = end_position;
+        num_chunks++;
+        return chunk;
+    }
+
+    void update() {
+        /**
+        *   Appends the current capture to the record, splitting it over
+        *   chunks where it does not fit in the newest one.
+        */
+        int points = ChaosCapture::getNumPoints();
+        if(points == 0 || max_chunks == 0) {
+            return;
+        }
+
+        wxMutexLocker locker(record_mutex);
+        if(ChaosCapture::getMdacValue() != mdac_value) {
+            mdac_value = ChaosCapture::getMdacValue();
+            num_chunks = 0;
+            num_captures = 0;
+        }
+
+        if(num_captures == captures_allocated) {
+            captures_allocated = captures_allocated ? 2*captures_allocated : 256;
+            capture_starts = (long long*)realloc(capture_starts, captures_allocated*sizeof(long long));
+        }
+        capture_starts[num_captures++] = end_position;
+
+        int copied = 0;
+        while(copied < points) {
+            Chunk* chunk = NULL;
+            if(num_chunks > 0) {
+                chunk = getSlot(num_chunks - 1);
+            }
+            if(chunk == NULL || chunk->num_points == RECORD_CHUNK_POINTS) {
+                chunk = newChunk();
+            }
+
+            int count = RECORD_CHUNK_POINTS - chunk->num_points;
+            if(count > points - copied) count = points - copied;
+            for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+                memcpy(chunk->channels[c] + chunk->num_points,
+                       ChaosCapture::getChannel(c) + copied, count*sizeof(short));
+            }
+            chunk->num_points += count;
+            end_position += count;
+            copied += count;
+        }
+        dropCaptures();
+        generation++;
+    }
+
+    void clear() {
+        /**
+        *   Drops every chunk.  Positions keep counting from where they were.
+        */
+        wxMutexLocker locker(record_mutex);
+        num_chunks = 0;
+        num_captures = 0;
+        generation++;
+    }
+
+    void setMemoryLimit(int megabytes) {
+        /**
+        *   Frees the record and sets how many chunks it may hold.  There is
+        *   always room for at least two chunks.
+        */
+        wxMutexLocker locker(record_mutex);
+        for(int i = 0; i < max_chunks; i++) {
+            if(slots[i].channels[0] != NULL) {
+                retire(slots[i].channels[0]);
+            }
+        }
+
+        memory_limit = megabytes;
+        max_chunks = (int)(((long long)megabytes << 20)/RECORD_CHUNK_BYTES);
+        if(max_chunks < 2) max_chunks = 2;
+        slots = (Chunk*)realloc(slots, max_chunks*sizeof(Chunk));
+        for(int i = 0; i < max_chunks; i++) {
+            for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+                slots[i].channels[c] = NULL;
+            }
+        }
+        first_slot = 0;
+        num_chunks = 0;
+        num_captures = 0;
+        generation++;
+    }
+
+    int getMemoryLimit() {
+        /**
+        *   Returns the memory limit in megabytes
+        */
+        return memory_limit;
+    }
+
+    unsigned int getGeneration() {
+        /**
+        *   Returns a counter that changes whenever the record changes
+        */
+        return generation;
+    }
+
+    void lock() {
+        /**
+        *   Stops the record from changing while another thread reads it
+        */
+        record_mutex.Lock();
+    }
+
+    void unlock() {
+        /**
+        *   Lets the record change again
+        */
+        record_mutex.Unlock();
+    }
+
+    void hold() {
+        /**
+        *   Stops chunk memory from being reused or freed.  Holds nest.
+        */
+        holders++;
+    }
+
+    void release() {
+        /**
+        *   Ends a hold, freeing the memory retired during it once the last
+        *   holder has finished
+        */
+        holders--;
+        if(holders == 0) {
+            for(int i = 0; i < num_retired; i++) {
+                free(retired[i]);
+            }
+            num_retired = 0;
+        }
+    }
+
+    long long getStart() {
+        /**
+        *   Returns the position of the oldest sample in the record
+        */
+        return num_chunks ? getSlot(0)->start : end_position;
+    }
+
+    long long getEnd() {
+        /**
+        *   Returns the position one past the newest sample in the record
+        */
+        return end_position;
+    }
+
+    int getNumChunks() {
+        /**
+        *   Returns the number of chunks in the record
+        */
+        return num_chunks;
+    }
+
+    long long getChunkStart(int chunk) {
+        /**
+        *   Returns the position of the first sample of a chunk
+        */
+        return getSlot(chunk)->start;
+    }
+
+    int getChunkPoints(int chunk) {
+        /**
+        *   Returns the number of samples in a chunk
+        */
+        return getSlot(chunk)->num_points;
+    }
+
+    const short* getChunkChannel(int chunk, int channel) {
+        /**
+        *   Returns the samples of one channel of a chunk
+        */
+        return getSlot(chunk)->channels[channel];
+    }
+
+    int findChunk(long long position) {
+        /**
+        *   Chunks other than the newest are always full, so the chunk
+        *   holding a position is found without searching.
+        */
+        if(num_chunks == 0 || position < getStart() || position >= end_position) {
+            return -1;
+        }
+        return (int)((position - getStart())/RECORD_CHUNK_POINTS);
+    }
+
+    int getNumCaptures() {
+        /**
+        *   Returns the number of captures with samples in the record
+        */
+        return num_captures;
+    }
+
+    long long getCaptureStart(int capture) {
+        /**
+        *   Returns the position of the first sample of a capture.  The
+        *   oldest capture may have lost its first samples with a chunk.
+        */
+        long long start = getStart();
+        return (capture_starts[capture] > start) ? capture_starts[capture] : start;
+    }
+
+    int getRun(long long position, int channel, const short** data, bool* capture_start) {
+        /**
+        *   Consumers walk the record with this, one run at a time.  The
+        *   capture the position is in is found by bisection.
+        */
+        int chunk = findChunk(position);
+        if(chunk < 0) {
+            return 0;
+        }
+        Chunk* slot = getSlot(chunk);
+        int offset = (int)(position - slot->start);
+        long long end = slot->start + slot->num_points;
+
+        int low = 0;
+        int high = num_captures - 1;
+        while(low < high) {
+            int mid = (low + high + 1)/2;
+            if(capture_starts[mid] <= position) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        if(low + 1 < num_captures && capture_starts[low + 1] < end) {
+            end = capture_starts[low + 1];
+        }
+
+        *data = slot->channels[channel] + offset;
+        *capture_start = (capture_starts[low] == position);
+        return (int)(end - position);
+    }
+}
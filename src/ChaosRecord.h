@@ -0,0 +1,79 @@
+/**
+ * \file ChaosRecord.h
+ * \brief Headers for ChaosRecord.cpp
+ */
+
+#ifndef CHAOSRECORD_H
+#define CHAOSRECORD_H
+
+// Samples of each channel held by one chunk of the record
+#define RECORD_CHUNK_POINTS 65536
+
+// Memory one chunk takes up for all channels, in bytes
+#define RECORD_CHUNK_BYTES (RECORD_CHUNK_POINTS*3*sizeof(short))
+
+namespace ChaosRecord {
+    /**
+    *   Namespace holding a long record of the captures from the Chaos Unit.
+    *   libchaos can only hold a few thousand samples at once, so every
+    *   capture is appended to the record, which can grow to millions of
+    *   samples.  The record is stored in fixed size chunks that are
+    *   allocated as it grows and reused oldest first once it reaches its
+    *   memory limit, so its memory use is bounded and it never has to be
+    *   copied to grow.  Consumers walk it one chunk at a time.
+    *
+    *   Samples are numbered by their position since the program started,
+    *   which keeps counting up when old chunks are dropped or the record is
+    *   cleared, so a consumer can remember where it stopped reading.
+    *   Captures are not continuous with each other, so where each one
+    *   starts is kept as well; the record starts again whenever the MDAC
+    *   value changes.
+    */
+
+    // Appends the newest capture, call after ChaosCapture::update()
+    extern void update();
+
+    // Throws away everything recorded so far
+    extern void clear();
+
+    // Sets the most memory the record may use in megabytes, clears the record
+    extern void setMemoryLimit(int megabytes);
+    extern int getMemoryLimit();
+
+    // Incremented every time a capture is appended
+    extern unsigned int getGeneration();
+
+    // Hold the record locked while reading it from a thread other than the GUI
+    extern void lock();
+    extern void unlock();
+
+    // Call with the record locked.  While held, the memory of the chunks is
+    // not reused or freed, so chunk pointers taken under the lock can be
+    // read after unlocking until release().
+    extern void hold();
+    extern void release();
+
+    // Position of the oldest sample held and one past the newest
+    extern long long getStart();
+    extern long long getEnd();
+
+    // Chunks from oldest to newest
+    extern int getNumChunks();
+    extern long long getChunkStart(int chunk);
+    extern int getChunkPoints(int chunk);
+    extern const short* getChunkChannel(int chunk, int channel);
+
+    // Chunk holding the sample at a position, or -1 if it is not held
+    extern int findChunk(long long position);
+
+    // Captures from oldest to newest, each one ends where the next starts
+    extern int getNumCaptures();
+    extern long long getCaptureStart(int capture);
+
+    // Gets the samples of a channel from a position up to the end of its
+    // chunk or capture, whichever is first, and whether the position is the
+    // start of a capture.  Returns how many there are, 0 at the end.
+    extern int getRun(long long position, int channel, const short** data, bool* capture_start);
+}
+
+#endif // CHAOSRECORD_H
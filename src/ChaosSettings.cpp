@@ -17,6 +17,8 @@ namespace ChaosSettings {
     int YAxisLabels;
     int PointsPerSample;
     int TransientPoints;
+    int RecordMemory;
+    int SpectrumMode;
     int UpdatePeriod;
     bool Paused;
     float Version;
@@ -36,6 +38,8 @@ namespace ChaosSettings {
         YAxisLabels = Y_AXIS_VBIAS;
         PointsPerSample = 2040;
         TransientPoints = 4;
+        RecordMemory = 32;
+        SpectrumMode = FFT_LIBRARY;
         UpdatePeriod = 300;
         Paused = false;
         BifRedraw = true;
@@ -34,6 +34,12 @@ namespace ChaosSettings {
     // Determines how many points should dropped per sample
     extern int TransientPoints;
     
+    // Most memory the long capture record may use (measured in megabytes)
+    extern int RecordMemory;
+    
+    // Sets where the spectrum comes from (FFT_LIBRARY, FFT_FIXED_POINT)
+    extern int SpectrumMode;
+    
     // Determines how fast the GUI updates (measured in milliseconds)
     extern int UpdatePeriod;
     
@@ -69,6 +75,11 @@ namespace ChaosSettings {
         Y_AXIS_VBIAS,
         Y_AXIS_VGND
     };
+    
+    enum {
+        FFT_LIBRARY = 0,
+        FFT_FIXED_POINT
+    };
 }
 
 #endif
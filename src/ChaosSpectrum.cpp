@@ -0,0 +1,215 @@
+/**
+ * \file ChaosSpectrum.cpp
+ * \brief Spectrum of the captures, from libchaos or a fixed point transform
+ */
+
+#include <math.h>
+#include "ChaosSpectrum.h"
+#include "ChaosSettings.h"
+#include "ChaosCapture.h"
+#include "ChaosRecord.h"
+#include "ChaosFFT.h"
+#include "libchaos.h"
+
+// Captures at the same MDAC value between spectra, as in libchaos
+#define SPECTRUM_INTERVAL 21
+
+// Bins at log10(0) are raised to this level
+#define SPECTRUM_FLOOR -10.0f
+
+// The Hann window is scaled by 2^15
+#define WINDOW_BITS 15
+
+// Windowed samples are scaled up by 2^INPUT_BITS, which brings 10-bit data
+// close to FIXED_FFT_HEADROOM and makes up for the window halving the peaks
+#define INPUT_BITS 4
+
+namespace ChaosSpectrum {
+    /**
+    *   The current spectrum and the buffers of the fixed point transform.
+    */
+    float spectrum[SPECTRUM_BINS];
+    int mode = ChaosSettings::FFT_LIBRARY;
+    int mdac_value = -1;
+    int captures_since = 0;
+    unsigned int capture_generation = 0;
+    unsigned int generation = 0;
+
+    ChaosFFT fft;
+    int re[SPECTRUM_FFT_SIZE];
+    int im[SPECTRUM_FFT_SIZE];
+    int window[SPECTRUM_FFT_SIZE];
+    int window_points = 0;
+
+    void readLibrary() {
+        /**
+        *   Copies the spectrum out of libchaos.  It only changes when the
+        *   library has transformed a capture, so the generation is only
+        *   incremented if it is different from last time.
+        */
+        bool changed = false;
+        for(int k = 0; k < SPECTRUM_BINS; k++) {
+            float value;
+            libchaos_getFFTPlotPoint(&value, k);
+            // Written so that NaN is caught as well
+            if(!(value > SPECTRUM_FLOOR)) {
+                value = SPECTRUM_FLOOR;
+            }
+            if(value != spectrum[k]) {
+                spectrum[k] = value;
+                changed = true;
+            }
+        }
+        if(changed) {
+            mdac_value = ChaosCapture::getMdacValue();
+            generation++;
+        }
+    }
+
+    void buildWindow(int points) {
+        /**
+        *   Builds a Hann window for a capture of the given length.  The
+        *   capture is shorter than the transform and padded with zeros,
+        *   and the window keeps its ends from spreading every peak out.
+        */
+        for(int i = 0; i < points; i++) {
+            window[i] = (int)(0.5*(1 - cos(2*M_PI*i/(points - 1)))*(1 << WINDOW_BITS) + 0.5);
+        }
+        window_points = points;
+    }
+
+    int readCapture() {
+        /**
+        *   Copies up to SPECTRUM_FFT_SIZE samples of X from the start of the
+        *   newest capture in the record into re, one run of the record at a
+        *   time since the capture may be split over two chunks.  Returns
+        *   the number of samples.
+        */
+        int capture = ChaosRecord::getNumCaptures() - 1;
+        if(capture < 0) {
+            return 0;
+        }
+        long long position = ChaosRecord::getCaptureStart(capture);
+        int points = 0;
+        const short* data;
+        bool starts_capture;
+        int count;
+        while(points < SPECTRUM_FFT_SIZE &&
+              (count = ChaosRecord::getRun(position, ChaosCapture::X1, &data, &starts_capture)) > 0) {
+            if(count > SPECTRUM_FFT_SIZE - points) count = SPECTRUM_FFT_SIZE - points;
+            for(int i = 0; i < count; i++) {
+                re[points + i] = data[i];
+            }
+            points += count;
+            position += count;
+        }
+        return points;
+    }
+
+    void transformFixed() {
+        /**
+        *   Takes the spectrum of X in the newest capture in fixed point.
+        *   The mean is taken off, the window applied and the result padded
+        *   to SPECTRUM_FFT_SIZE, so the bins are the same frequencies as
+        *   those of libchaos.  The log of the power is taken straight from
+        *   the integer power with ChaosFFT::fastLog2().
+        */
+        int points = readCapture();
+        if(points < 2) {
+            return;
+        }
+        if(points != window_points) {
+            buildWindow(points);
+        }
+
+        int sum = 0;
+        for(int i = 0; i < points; i++) {
+            sum += re[i];
+        }
+        int mean = sum/points;
+        for(int i = 0; i < points; i++) {
+            re[i] = ((re[i] - mean)*window[i]) >> (WINDOW_BITS - INPUT_BITS - 1);
+            im[i] = 0;
+        }
+        for(int i = points; i < SPECTRUM_FFT_SIZE; i++) {
+            re[i] = 0;
+            im[i] = 0;
+        }
+
+        int exponent;
+        fft.setSize(SPECTRUM_FFT_SIZE);
+        fft.forwardFixed(re, im, &exponent);
+
+        // Power in ADC counts squared is the integer power times 4^(exponent - INPUT_BITS)
+        float offset = 2*(exponent - INPUT_BITS);
+        const float log10_2 = 0.30103f;
+        for(int k = 0; k < SPECTRUM_BINS; k++) {
+            unsigned long long power = (long long)re[k]*re[k] + (long long)im[k]*im[k];
+            if(power == 0) {
+                spectrum[k] = SPECTRUM_FLOOR;
+            } else {
+                spectrum[k] = (ChaosFFT::fastLog2(power) + offset)*log10_2;
+            }
+        }
+        mdac_value = ChaosCapture::getMdacValue();
+        generation++;
+    }
+
+    void update() {
+        /**
+        *   Picks up the spectrum of any new capture.  The fixed point
+        *   transform is run as often as libchaos runs its own: when the MDAC
+        *   value changes and every SPECTRUM_INTERVAL captures after that.
+        */
+        if(capture_generation == ChaosCapture::getGeneration()) {
+            return;
+        }
+        capture_generation = ChaosCapture::getGeneration();
+
+        if(mode == ChaosSettings::FFT_LIBRARY) {
+            readLibrary();
+        } else {
+            captures_since++;
+            if(ChaosCapture::getMdacValue() != mdac_value || captures_since >= SPECTRUM_INTERVAL) {
+                captures_since = 0;
+                transformFixed();
+            }
+        }
+    }
+
+    void setMode(int new_mode) {
+        /**
+        *   Chooses where the spectrum comes from.  libchaos reads an extra
+        *   capture for its transform, so it is told to stop when the fixed
+        *   point transform is used.
+        */
+        mode = new_mode;
+        mdac_value = -1;
+        if(mode == ChaosSettings::FFT_LIBRARY) {
+            libchaos_enableFFT();
+        } else {
+            libchaos_disableFFT();
+        }
+    }
+
+    unsigned int getGeneration() {
+        /**
+        *   Returns a counter that changes whenever the spectrum changes
+        */
+        return generation;
+    }
+
+    int getMdacValue() {
+        /**
+        *   Returns the MDAC value the spectrum was taken at
+        */
+        return mdac_value;
+    }
+
+    const float* getSpectrum() {
+        /**
+        *   Returns the SPECTRUM_BINS values of log10 power
+        */
+        return spectrum;
+    }
+}
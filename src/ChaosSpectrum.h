@@ -0,0 +1,42 @@
+/**
+ * \file ChaosSpectrum.h
+ * \brief Headers for ChaosSpectrum.cpp
+ */
+
+#ifndef CHAOSSPECTRUM_H
+#define CHAOSSPECTRUM_H
+
+// Length of the transform, the same as libchaos uses
+#define SPECTRUM_FFT_SIZE 8192
+
+// Number of bins from DC up to half the sample frequency
+#define SPECTRUM_BINS (SPECTRUM_FFT_SIZE/2)
+
+namespace ChaosSpectrum {
+    /**
+    *   Namespace holding the spectrum of X shown by the FFT plot and used
+    *   by the frequency tracking.  It either comes from libchaos, which
+    *   transforms its own capture in float, or from a fixed point transform
+    *   of the capture that is cheaper on older PCs.  Which one is set by
+    *   ChaosSettings::SpectrumMode.  Either way the spectrum is only worked
+    *   out when the MDAC value changes and every so many captures after
+    *   that, and it is in log10 of the power.
+    */
+
+    // Takes the spectrum of the newest capture if it is due, call after ChaosCapture::update()
+    extern void update();
+
+    // Switches between the libchaos and the fixed point transform (FFT_LIBRARY, FFT_FIXED_POINT)
+    extern void setMode(int mode);
+
+    // Incremented every time the spectrum changes
+    extern unsigned int getGeneration();
+
+    // MDAC value the spectrum was taken at
+    extern int getMdacValue();
+
+    // SPECTRUM_BINS values of log10 power
+    extern const float* getSpectrum();
+}
+
+#endif // CHAOSSPECTRUM_H
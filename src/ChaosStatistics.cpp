@@ -0,0 +1,173 @@
+/**
+ * \file ChaosStatistics.cpp
+ * \brief Running statistics of the captured channels
+ */
+
+#include <math.h>
+#include "ChaosStatistics.h"
+#include "ChaosCapture.h"
+#include "ChaosCalibration.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Vectors summed in 32 bit lanes before they are moved into 64 bit totals.
+// With 10-bit samples a lane of squares stays below 512*2*1023^2 < 2^31.
+#define VECTORS_PER_BLOCK 512
+
+namespace ChaosStatistics {
+    /**
+    *   Sums kept for each channel.  Counts and sums are doubles so that
+    *   they cannot overflow however long the totals run.
+    */
+    struct Totals {
+        int minimum;
+        int maximum;
+        double count;
+        double sum;
+        double sum_squares;
+    };
+    
+    Totals capture_totals[ChaosCapture::NUM_CHANNELS];
+    Totals running_totals[ChaosCapture::NUM_CHANNELS];
+    unsigned int num_captures = 0;
+    int mdac_value = -1;
+    
+    void summarize(const short* data, int num_points, Totals* totals) {
+        /**
+        *   Finds the minimum, maximum, sum and sum of squares of a channel
+        *   in a single pass.  With SSE2 eight samples are done at a time,
+        *   the squares and sums coming from one multiply-add each.
+        */
+        int minimum = 0x7fff;
+        int maximum = -0x8000;
+        long long sum = 0;
+        long long sum_squares = 0;
+        int i = 0;
+        
+#ifdef __SSE2__
+        __m128i vmin = _mm_set1_epi16(0x7fff);
+        __m128i vmax = _mm_set1_epi16(-0x8000);
+        __m128i ones = _mm_set1_epi16(1);
+        int vector_end = num_points & ~7;
+        while(i < vector_end) {
+            int block_end = i + 8*VECTORS_PER_BLOCK;
+            if(block_end > vector_end) block_end = vector_end;
+            
+            __m128i vsum = _mm_setzero_si128();
+            __m128i vsquares = _mm_setzero_si128();
+            for(; i < block_end; i += 8) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+                vmin = _mm_min_epi16(vmin, x);
+                vmax = _mm_max_epi16(vmax, x);
+                vsum = _mm_add_epi32(vsum, _mm_madd_epi16(x, ones));
+                vsquares = _mm_add_epi32(vsquares, _mm_madd_epi16(x, x));
+            }
+            
+            int lanes[4];
+            _mm_storeu_si128((__m128i*)lanes, vsum);
+            sum += (long long)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            _mm_storeu_si128((__m128i*)lanes, vsquares);
+            sum_squares += (long long)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+        
+        short extremes[8];
+        _mm_storeu_si128((__m128i*)extremes, vmin);
+        for(int k = 0; k < 8; k++) {
+            if(extremes[k] < minimum) minimum = extremes[k];
+        }
+        _mm_storeu_si128((__m128i*)extremes, vmax);
+        for(int k = 0; k < 8; k++) {
+            if(extremes[k] > maximum) maximum = extremes[k];
+        }
+#endif
+        
+        for(; i < num_points; i++) {
+            int x = data[i];
+            if(x < minimum) minimum = x;
+            if(x > maximum) maximum = x;
+            sum += x;
+            sum_squares += x*x;
+        }
+        
+        totals->minimum = minimum;
+        totals->maximum = maximum;
+        totals->count = num_points;
+        totals->sum = (double)sum;
+        totals->sum_squares = (double)sum_squares;
+    }
+    
+    void update() {
+        /**
+        *   Summarizes the newest capture and adds it to the running totals
+        */
+        int num_points = ChaosCapture::getNumPoints();
+        if(num_points == 0) {
+            return;
+        }
+        if(ChaosCapture::getMdacValue() != mdac_value) {
+            mdac_value = ChaosCapture::getMdacValue();
+            reset();
+        }
+        
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            Totals* capture = &capture_totals[c];
+            Totals* running = &running_totals[c];
+            summarize(ChaosCapture::getChannel(c), num_points, capture);
+            
+            if(num_captures == 0) {
+                *running = *capture;
+            } else {
+                if(capture->minimum < running->minimum) running->minimum = capture->minimum;
+                if(capture->maximum > running->maximum) running->maximum = capture->maximum;
+                running->count += capture->count;
+                running->sum += capture->sum;
+                running->sum_squares += capture->sum_squares;
+            }
+        }
+        num_captures++;
+    }
+    
+    void reset() {
+        /**
+        *   Starts the running totals again from the next capture
+        */
+        num_captures = 0;
+    }
+    
+    unsigned int getNumCaptures() {
+        /**
+        *   Returns the number of captures in the running totals
+        */
+        return num_captures;
+    }
+    
+    void getValues(int channel, bool running,
+                   float* minimum, float* maximum, float* mean,
+                   float* rms, float* peak_to_peak) {
+        /**
+        *   Converts the totals of a channel to statistics in the current
+        *   units.  Volts are a*x + b of the ADC value, so the RMS is worked
+        *   out from the mean and mean square of the raw values.
+        */
+        Totals* totals = running ? &running_totals[channel] : &capture_totals[channel];
+        if(num_captures == 0 || totals->count == 0) {
+            *minimum = *maximum = *mean = *rms = *peak_to_peak = 0;
+            return;
+        }
+        
+        float a = ChaosCalibration::getScale(channel);
+        float b = ChaosCalibration::getOffset(channel);
+        
+        double mean_adc = totals->sum/totals->count;
+        double mean_square_adc = totals->sum_squares/totals->count;
+        double mean_square = a*a*mean_square_adc + 2*a*b*mean_adc + b*b;
+        
+        *minimum = a*totals->minimum + b;
+        *maximum = a*totals->maximum + b;
+        *mean = a*mean_adc + b;
+        *rms = sqrt(mean_square > 0 ? mean_square : 0);
+        *peak_to_peak = a*(totals->maximum - totals->minimum);
+    }
+}
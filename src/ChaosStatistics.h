@@ -0,0 +1,34 @@
+/**
+ * \file ChaosStatistics.h
+ * \brief Headers for ChaosStatistics.cpp
+ */
+
+#ifndef CHAOSSTATISTICS_H
+#define CHAOSSTATISTICS_H
+
+namespace ChaosStatistics {
+    /**
+    *   Namespace holding per channel statistics of the captures.  Each new
+    *   capture is summarized in one pass per channel and the summary is
+    *   folded into running totals, so the running values cost the same to
+    *   keep up to date no matter how many captures they cover.  The running
+    *   totals start again whenever the MDAC value changes.
+    */
+    
+    // Summarizes the newest capture, call after ChaosCapture::update()
+    extern void update();
+    
+    // Starts the running totals again
+    extern void reset();
+    
+    // Number of captures in the running totals
+    extern unsigned int getNumCaptures();
+    
+    // Statistics of a channel in the units set by ChaosSettings::YAxisLabels,
+    // for the latest capture or for all captures since the last reset
+    extern void getValues(int channel, bool running,
+                          float* minimum, float* maximum, float* mean,
+                          float* rms, float* peak_to_peak);
+}
+
+#endif // CHAOSSTATISTICS_H
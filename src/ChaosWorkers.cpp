@@ -0,0 +1,238 @@
+/**
+ * \file ChaosWorkers.cpp
+ * \brief Pool of worker threads shared by the analysis code
+ */
+
+#include "ChaosWorkers.h"
+
+// Upper limit on the number of threads in the pool
+#define MAX_WORKERS 16
+
+// Upper limit on the number of tasks running at the same time
+#define MAX_TASKS 16
+
+class ChaosWorker : public wxThread
+{
+    /**
+    *   One thread of the pool.  Sleeps until a task is started and then
+    *   takes jobs from the running tasks until there are none left.
+    */
+    public:
+        ChaosWorker(int thread);
+    protected:
+        ExitCode Entry();
+    private:
+        int thread;
+};
+
+namespace ChaosWorkers
+{
+    // A task that has been started and the progress of its jobs
+    struct TaskSlot {
+        ChaosTask* task;
+        int next_job;
+        int total_jobs;
+        int jobs_done;
+    };
+    
+    // Threads in the pool, the thread calling run() is counted as thread 0
+    ChaosWorker* workers[MAX_WORKERS];
+    int num_threads = 1;
+    
+    // Running tasks, protected by pool_mutex
+    wxMutex* pool_mutex = NULL;
+    wxCondition* start_condition = NULL;
+    wxCondition* done_condition = NULL;
+    wxCondition* slot_condition = NULL;
+    TaskSlot slots[MAX_TASKS];
+    int next_slot = 0;
+    bool stopping = false;
+    
+    bool takeJob(int* slot, int* job);
+    bool takeOwnJob(int slot, int* job);
+    void finishJob(int slot);
+}
+
+ChaosWorker::ChaosWorker(int thread) 
+    : wxThread(wxTHREAD_JOINABLE) {
+    /**
+    *   Constructor for a pool thread
+    */
+    this->thread = thread;
+}
+
+wxThread::ExitCode ChaosWorker::Entry() {
+    /**
+    *   Main loop of a pool thread
+    */
+    int slot;
+    int job;
+    while(ChaosWorkers::takeJob(&slot, &job)) {
+        ChaosWorkers::slots[slot].task->runJob(job, thread);
+        ChaosWorkers::finishJob(slot);
+    }
+    return 0;
+}
+
+void ChaosWorkers::start() {
+    /**
+    *   Starts one thread for each core after the first.  The thread that
+    *   calls run() always works on its task as well so the pool never
+    *   takes more cores than the machine has.
+    */
+    pool_mutex = new wxMutex();
+    start_condition = new wxCondition(*pool_mutex);
+    done_condition = new wxCondition(*pool_mutex);
+    slot_condition = new wxCondition(*pool_mutex);
+    stopping = false;
+    for(int s = 0; s < MAX_TASKS; s++) {
+        slots[s].task = NULL;
+    }
+    
+    num_threads = wxThread::GetCPUCount();
+    if(num_threads < 1) num_threads = 1;
+    if(num_threads > MAX_WORKERS) num_threads = MAX_WORKERS;
+    
+    for(int i = 1; i < num_threads; i++) {
+        workers[i] = new ChaosWorker(i);
+        workers[i]->Create();
+        workers[i]->Run();
+    }
+    wxLogMessage(wxT("Started %d worker threads"), num_threads);
+}
+
+void ChaosWorkers::stop() {
+    /**
+    *   Stops the pool threads.  Only call this once nothing can start a
+    *   task any more.
+    */
+    if(pool_mutex == NULL) {
+        return;
+    }
+    
+    pool_mutex->Lock();
+    stopping = true;
+    start_condition->Broadcast();
+    pool_mutex->Unlock();
+    
+    for(int i = 1; i < num_threads; i++) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+    num_threads = 1;
+    
+    delete start_condition;
+    delete done_condition;
+    delete slot_condition;
+    delete pool_mutex;
+    start_condition = done_condition = slot_condition = NULL;
+    pool_mutex = NULL;
+}
+
+int ChaosWorkers::getNumThreads() {
+    /**
+    *   Returns the number of threads jobs can be run on, including the
+    *   thread calling run()
+    */
+    return num_threads;
+}
+
+void ChaosWorkers::run(ChaosTask* task, int num_jobs) {
+    /**
+    *   Runs jobs 0 to num_jobs-1 of the task spread over the pool and
+    *   returns once they have all finished.  May be called from any
+    *   thread and by several threads at once; the pool threads share
+    *   their time between all of the running tasks so a short task is
+    *   not stuck behind a long one.  Keep jobs coarse, each one costs a
+    *   mutex lock to hand out.
+    */
+    if(pool_mutex == NULL) {
+        // Pool not started, just run everything here
+        for(int i = 0; i < num_jobs; i++) {
+            task->runJob(i, 0);
+        }
+        return;
+    }
+    
+    // Find a free slot for the task
+    pool_mutex->Lock();
+    int slot = -1;
+    while(slot < 0) {
+        for(int s = 0; s < MAX_TASKS; s++) {
+            if(slots[s].task == NULL) {
+                slot = s;
+                break;
+            }
+        }
+        if(slot < 0) {
+            slot_condition->Wait();
+        }
+    }
+    slots[slot].task = task;
+    slots[slot].next_job = 0;
+    slots[slot].total_jobs = num_jobs;
+    slots[slot].jobs_done = 0;
+    start_condition->Broadcast();
+    pool_mutex->Unlock();
+    
+    // Work on our own task as thread 0
+    int job;
+    while(takeOwnJob(slot, &job)) {
+        task->runJob(job, 0);
+        finishJob(slot);
+    }
+    
+    pool_mutex->Lock();
+    while(slots[slot].jobs_done < slots[slot].total_jobs) {
+        done_condition->Wait();
+    }
+    slots[slot].task = NULL;
+    slot_condition->Signal();
+    pool_mutex->Unlock();
+}
+
+bool ChaosWorkers::takeJob(int* slot, int* job) {
+    /**
+    *   Hands the next job of one of the running tasks to a pool thread,
+    *   waiting for a task to be started if there are none.  The tasks are
+    *   taken in turn.  Returns false when the pool is stopping.
+    */
+    wxMutexLocker locker(*pool_mutex);
+    while(!stopping) {
+        for(int i = 0; i < MAX_TASKS; i++) {
+            int s = (next_slot + i) % MAX_TASKS;
+            if(slots[s].task != NULL && slots[s].next_job < slots[s].total_jobs) {
+                *slot = s;
+                *job = slots[s].next_job++;
+                next_slot = (s + 1) % MAX_TASKS;
+                return true;
+            }
+        }
+        start_condition->Wait();
+    }
+    return false;
+}
+
+bool ChaosWorkers::takeOwnJob(int slot, int* job) {
+    /**
+    *   Hands the next job of a task to the thread that started it.
+    *   Returns false once all of its jobs have been handed out.
+    */
+    wxMutexLocker locker(*pool_mutex);
+    if(slots[slot].next_job >= slots[slot].total_jobs) {
+        return false;
+    }
+    *job = slots[slot].next_job++;
+    return true;
+}
+
+void ChaosWorkers::finishJob(int slot) {
+    /**
+    *   Marks a job as done and wakes run() after the last one
+    */
+    wxMutexLocker locker(*pool_mutex);
+    slots[slot].jobs_done++;
+    if(slots[slot].jobs_done == slots[slot].total_jobs) {
+        done_condition->Broadcast();
+    }
+}
@@ -0,0 +1,33 @@
+/**
+ * \file ChaosWorkers.h
+ * \brief Headers for ChaosWorkers.cpp
+ */
+
+#ifndef CHAOSWORKERS_H
+#define CHAOSWORKERS_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+
+class ChaosTask
+{
+    /**
+    *   A piece of work that can be split into independent jobs and run on
+    *   the worker pool.  Thread is between 0 and getNumThreads()-1 and is
+    *   unique among the jobs of the task running at the same time, so tasks can keep
+    *   per thread partial results without locking.
+    */
+    public:
+        virtual ~ChaosTask() {}
+        virtual void runJob(int job, int thread) = 0;
+};
+
+namespace ChaosWorkers
+{
+    void start();
+    void stop();
+    int getNumThreads();
+    void run(ChaosTask* task, int num_jobs);
+}
+
+#endif // CHAOSWORKERS_H
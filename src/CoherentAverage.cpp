@@ -0,0 +1,166 @@
+/**
+ * \file CoherentAverage.cpp
+ * \brief Averages the periods of the waveform aligned on the trigger level
+ */
+
+#include "CoherentAverage.h"
+
+// ADC counts X must fall below the trigger level before it can trigger again,
+// so that noise around the level does not start extra windows
+#define TRIGGER_HYSTERESIS 8
+
+// ADC counts X' and X'' may be from the reference at a crossing for it to
+// start a window.  In period-n and chaotic windows X crosses the level more
+// than once per period, at different phases, and those crossings are told
+// apart by where the other channels are.
+#define TRIGGER_NEIGHBOURHOOD 24
+
+CoherentAverage::CoherentAverage() {
+    /**
+    *   Constructor for the CoherentAverage class.
+    *
+    *   In a periodic window every period of the waveform is the same apart
+    *   from noise, so averaging periods that are lined up with each other
+    *   keeps the waveform and averages the noise away, which falls with
+    *   the square root of the number of periods.  The periods are lined up
+    *   on upward crossings of X through the level the device triggered on,
+    *   where X' and X'' are also near their values at that trigger.
+    */
+    generation = ChaosCapture::getGeneration();
+    clear();
+}
+
+void CoherentAverage::update() {
+    /**
+    *   Adds every period of any capture that arrived since the last call.
+    *
+    *   Each upward crossing of the reference level that passes close to
+    *   the reference state starts a window.  The crossing is found to a
+    *   fraction of a sample by interpolating between the samples either
+    *   side of it, and the window is resampled at that fraction so that
+    *   windows line up more closely than the sample clock.
+    */
+    if(generation == ChaosCapture::getGeneration()) {
+        return;
+    }
+    generation = ChaosCapture::getGeneration();
+
+    int num_points = ChaosCapture::getNumPoints();
+    int trigger = ChaosCapture::getTriggerIndex();
+    if(trigger < 1 || trigger + AVERAGE_POINTS + 1 > num_points) {
+        return;
+    }
+
+    if(!has_reference) {
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            reference[c] = ChaosCapture::getChannel(c)[trigger];
+        }
+        has_reference = true;
+    }
+
+    const short* x = ChaosCapture::getChannel(ChaosCapture::X1);
+    float level = reference[ChaosCapture::X1];
+    bool armed = false;
+    for(int i = 1; i + AVERAGE_POINTS < num_points; i++) {
+        if(x[i] < level - TRIGGER_HYSTERESIS) {
+            armed = true;
+        } else if(armed && x[i-1] < level && x[i] >= level) {
+            float fraction = (level - x[i-1])/(x[i] - x[i-1]);
+            if(nearReference(i - 1, fraction)) {
+                addWindow(i - 1, fraction);
+            }
+            armed = false;
+        }
+    }
+}
+
+bool CoherentAverage::nearReference(int start, float fraction) {
+    /**
+    *   Returns true if X' and X'' at the crossing fraction of a sample
+    *   after start are within TRIGGER_NEIGHBOURHOOD of the reference, so
+    *   the crossing is at the same phase of the orbit as the reference.
+    */
+    float distance = 0;
+    for(int c = ChaosCapture::X2; c < ChaosCapture::NUM_CHANNELS; c++) {
+        const short* data = ChaosCapture::getChannel(c) + start;
+        float d = data[0] + fraction*(data[1] - data[0]) - reference[c];
+        distance += d*d;
+    }
+    return distance < TRIGGER_NEIGHBOURHOOD*TRIGGER_NEIGHBOURHOOD;
+}
+
+void CoherentAverage::addWindow(int start, float fraction) {
+    /**
+    *   Adds the window of every channel that starts fraction of a sample
+    *   after start to the running sums and envelope.
+    */
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        const short* data = ChaosCapture::getChannel(c) + start;
+        double* sum = sums[c];
+        float* low = minimum[c];
+        float* high = maximum[c];
+        for(int k = 0; k < AVERAGE_POINTS; k++) {
+            float value = data[k] + fraction*(data[k+1] - data[k]);
+            sum[k] += value;
+            low[k] = value < low[k] ? value : low[k];
+            high[k] = value > high[k] ? value : high[k];
+        }
+    }
+    num_periods++;
+    mean_valid = false;
+}
+
+void CoherentAverage::clear() {
+    /**
+    *   Throws away the periods averaged so far
+    */
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        for(int k = 0; k < AVERAGE_POINTS; k++) {
+            sums[c][k] = 0;
+            mean[c][k] = 0;
+            minimum[c][k] = 1e9;
+            maximum[c][k] = -1e9;
+        }
+    }
+    num_periods = 0;
+    mean_valid = true;
+    has_reference = false;
+}
+
+int CoherentAverage::getNumPeriods() {
+    /**
+    *   Returns the number of periods in the average
+    */
+    return num_periods;
+}
+
+const float* CoherentAverage::getMean(int channel) {
+    /**
+    *   Returns the AVERAGE_POINTS averaged ADC values of a channel.  The
+    *   sums are only divided out when they have changed.
+    */
+    if(!mean_valid && num_periods > 0) {
+        double scale = 1.0/num_periods;
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            for(int k = 0; k < AVERAGE_POINTS; k++) {
+                mean[c][k] = sums[c][k]*scale;
+            }
+        }
+        mean_valid = true;
+    }
+    return mean[channel];
+}
+
+const float* CoherentAverage::getMinimum(int channel) {
+    /**
+    *   Returns the lowest value of each sample of a channel over the periods
+    */
+    return minimum[channel];
+}
+
+const float* CoherentAverage::getMaximum(int channel) {
+    /**
+    *   Returns the highest value of each sample of a channel over the periods
+    */
+    return maximum[channel];
+}
@@ -0,0 +1,46 @@
+/**
+ * \file CoherentAverage.h
+ * \brief Headers for CoherentAverage.cpp
+ */
+
+#ifndef COHERENTAVERAGE_H
+#define COHERENTAVERAGE_H
+
+#include "ChaosCapture.h"
+
+// Number of samples in an averaged window, the width of the XT plot
+#define AVERAGE_POINTS 300
+
+class CoherentAverage
+{
+    public:
+        // class constructor
+        CoherentAverage();
+        void update();
+        void clear();
+        int getNumPeriods();
+        const float* getMean(int channel);
+        const float* getMinimum(int channel);
+        const float* getMaximum(int channel);
+
+    private:
+        void addWindow(int start, float fraction);
+        bool nearReference(int start, float fraction);
+
+        unsigned int generation;
+        int num_periods;
+        bool mean_valid;
+
+        // State of all channels at the trigger the average is lined up on,
+        // taken from the first capture after clear()
+        bool has_reference;
+        float reference[ChaosCapture::NUM_CHANNELS];
+
+        // Running sums and envelope, preallocated so nothing is allocated per capture
+        double sums[ChaosCapture::NUM_CHANNELS][AVERAGE_POINTS];
+        float mean[ChaosCapture::NUM_CHANNELS][AVERAGE_POINTS];
+        float minimum[ChaosCapture::NUM_CHANNELS][AVERAGE_POINTS];
+        float maximum[ChaosCapture::NUM_CHANNELS][AVERAGE_POINTS];
+};
+
+#endif // COHERENTAVERAGE_H
@@ -0,0 +1,595 @@
+/**
+ * \file CorrelationDimension.cpp
+ * \brief Estimates the correlation dimension of the attractor
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "CorrelationDimension.h"
+#include "ChaosRecord.h"
+
+// The grid cells are 16 ADC counts on a side, 64 cells along each axis
+#define CELL_SHIFT 4
+#define CELL_SIZE (1 << CELL_SHIFT)
+#define GRID_SIZE (1024 >> CELL_SHIFT)
+#define GRID_CELLS (GRID_SIZE*GRID_SIZE*GRID_SIZE)
+
+// Space left in sorted_index between captures, so that no pair from two
+// different captures falls inside the Theiler window
+#define CAPTURE_GAP (CORRELATION_THEILER_WINDOW + 1)
+
+// Reference points handed to the pool per job
+#define REFERENCES_PER_JOB 64
+
+// Range of C(r) the dimension is fitted over
+#define FIT_MIN_CORRELATION 1e-4
+#define FIT_MAX_CORRELATION 1e-1
+
+CorrelationWorker::CorrelationWorker(CorrelationDimension* estimator) 
+    : wxThread(wxTHREAD_JOINABLE) {
+    /**
+    *   Constructor for the worker thread
+    */
+    this->estimator = estimator;
+}
+
+wxThread::ExitCode CorrelationWorker::Entry() {
+    /**
+    *   Main loop of the worker thread.  Recomputes the correlation sum
+    *   every time new points have been collected.
+    */
+    while(estimator->waitForWork()) {
+        estimator->compute();
+    }
+    return 0;
+}
+
+CorrelationDimension::CorrelationDimension() 
+    : work_condition(work_mutex) {
+    /**
+    *   Constructor for the CorrelationDimension class.
+    *
+    *   Uses the Grassberger-Procaccia algorithm: C(r) is the fraction of
+    *   pairs of points on the trajectory that are closer than r, and the
+    *   correlation dimension is the slope of log C(r) against log r.
+    *
+    *   The trajectory is the first CORRELATION_MAX_POINTS samples of the
+    *   long capture record after the last clear.  The points are sorted into a grid
+    *   of cells once per computation so that the neighbours of a point
+    *   are found by only looking at the cells near it.  Pairs are counted
+    *   for every radius at once by binning the squared distance, and the
+    *   reference points are spread over the worker pool.
+    */
+    stopping = false;
+    clear_version = 0;
+    result_version = 0;
+    record_generation = ChaosRecord::getGeneration();
+    start_position = ChaosRecord::getEnd();
+    collected_end = start_position;
+    computed_end = start_position;
+    
+    for(int c = 0; c < 3; c++) {
+        sorted[c] = NULL;
+    }
+    chunks = NULL;
+    num_chunks = 0;
+    chunks_allocated = 0;
+    capture_start = NULL;
+    num_captures = 0;
+    captures_allocated = 0;
+    sorted_index = NULL;
+    cell_start = NULL;
+    thread_counts = NULL;
+    num_points = 0;
+    reference_step = 1;
+    num_references = 0;
+    
+    // Radii double every CORRELATION_RADII_PER_OCTAVE steps starting at 1
+    for(int i = 0; i < CORRELATION_NUM_RADII; i++) {
+        radii[i] = pow(2.0, double(i)/CORRELATION_RADII_PER_OCTAVE);
+    }
+    
+    // Smallest radius each squared integer distance fits inside.  The last
+    // entry catches everything past the largest radius.
+    int bin = 0;
+    for(int d2 = 0; d2 <= CORRELATION_MAX_RADIUS*CORRELATION_MAX_RADIUS; d2++) {
+        while(radii[bin]*radii[bin] < d2 - 0.001) {
+            bin++;
+        }
+        radius_bin[d2] = bin;
+    }
+    radius_bin[CORRELATION_MAX_RADIUS*CORRELATION_MAX_RADIUS + 1] = CORRELATION_NUM_RADII;
+    
+    result_points = 0;
+    dimension = 0;
+    for(int i = 0; i < CORRELATION_NUM_RADII; i++) {
+        correlation[i] = 0;
+    }
+    
+    worker = new CorrelationWorker(this);
+    worker->Create();
+    worker->Run();
+}
+
+CorrelationDimension::~CorrelationDimension() {
+    /**
+    *   Destructor for the CorrelationDimension class.
+    *   Stops the worker thread before freeing anything it could be using.
+    */
+    work_mutex.Lock();
+    stopping = true;
+    work_condition.Signal();
+    work_mutex.Unlock();
+    
+    worker->Wait();
+    delete worker;
+    
+    for(int c = 0; c < 3; c++) {
+        free(sorted[c]);
+    }
+    free(chunks);
+    free(capture_start);
+    free(sorted_index);
+    free(cell_start);
+    free(thread_counts);
+}
+
+void CorrelationDimension::update() {
+    /**
+    *   Extends the trajectory with anything recorded since the last call,
+    *   up to CORRELATION_MAX_POINTS.  Called from the GUI thread.
+    */
+    if(record_generation == ChaosRecord::getGeneration()) {
+        return;
+    }
+    record_generation = ChaosRecord::getGeneration();
+    
+    long long end = ChaosRecord::getEnd();
+    if(end > start_position + CORRELATION_MAX_POINTS) {
+        end = start_position + CORRELATION_MAX_POINTS;
+    }
+    
+    wxMutexLocker locker(work_mutex);
+    if(end != collected_end) {
+        collected_end = end;
+        work_condition.Signal();
+    }
+}
+
+void CorrelationDimension::clear() {
+    /**
+    *   Throws away the collected trajectory and the results.  The
+    *   version is changed with the results locked so that a computation
+    *   that is still running cannot publish afterwards.
+    */
+    result_mutex.Lock();
+    work_mutex.Lock();
+    start_position = ChaosRecord::getEnd();
+    collected_end = start_position;
+    computed_end = start_position;
+    clear_version++;
+    work_mutex.Unlock();
+    
+    result_points = 0;
+    dimension = 0;
+    for(int i = 0; i < CORRELATION_NUM_RADII; i++) {
+        correlation[i] = 0;
+    }
+    result_version++;
+    result_mutex.Unlock();
+}
+
+int CorrelationDimension::getNumCollected() {
+    /**
+    *   Returns the number of points collected so far that the record
+    *   still holds.  Called from the GUI thread, which is the only one that
+    *   changes the record.
+    */
+    wxMutexLocker locker(work_mutex);
+    long long first = start_position;
+    if(first < ChaosRecord::getStart()) first = ChaosRecord::getStart();
+    return (collected_end > first) ? (int)(collected_end - first) : 0;
+}
+
+bool CorrelationDimension::waitForWork() {
+    /**
+    *   Called by the worker.  Blocks until there are points that have not
+    *   been used yet.  Returns false when the worker should exit.
+    */
+    wxMutexLocker locker(work_mutex);
+    while(collected_end == computed_end && !stopping) {
+        work_condition.Wait();
+    }
+    return !stopping;
+}
+
+void CorrelationDimension::compute() {
+    /**
+    *   Called by the worker.  Sorts the trajectory into the grid, counts
+    *   the pairs on the worker pool and publishes C(r).  The record is
+    *   only locked while the chunks to read are looked up; it is held
+    *   while they are sorted so the GUI can keep appending captures, and
+    *   after that the worker only uses its own sorted copy.
+    */
+    work_mutex.Lock();
+    unsigned int version = clear_version;
+    long long first = start_position;
+    long long end = collected_end;
+    computed_end = end;
+    work_mutex.Unlock();
+    
+    ChaosRecord::lock();
+    if(first < ChaosRecord::getStart()) {
+        // The oldest part has been dropped to stay inside the memory limit
+        first = ChaosRecord::getStart();
+    }
+    if(end > ChaosRecord::getEnd()) {
+        end = ChaosRecord::getEnd();
+    }
+    num_points = (end > first) ? (int)(end - first) : 0;
+    if(num_points < 2*CORRELATION_THEILER_WINDOW + 2 || !takeSnapshot(first, end)) {
+        ChaosRecord::unlock();
+        return;
+    }
+    ChaosRecord::hold();
+    ChaosRecord::unlock();
+    
+    buildGrid();
+    
+    ChaosRecord::lock();
+    ChaosRecord::release();
+    ChaosRecord::unlock();
+    
+    // Spread the reference points evenly over the sorted points, this
+    // samples the attractor in proportion to how often it is visited
+    reference_step = num_points/CORRELATION_REFERENCE_POINTS;
+    if(reference_step < 1) reference_step = 1;
+    num_references = num_points/reference_step;
+    
+    int num_threads = ChaosWorkers::getNumThreads();
+    int num_counts = num_threads*(CORRELATION_NUM_RADII + 1);
+    thread_counts = (double*)realloc(thread_counts, num_counts*sizeof(double));
+    for(int i = 0; i < num_counts; i++) {
+        thread_counts[i] = 0;
+    }
+    
+    ChaosWorkers::run(this, (num_references + REFERENCES_PER_JOB - 1)/REFERENCES_PER_JOB);
+    
+    // Number of pairs that could have been counted, leaving out the ones
+    // inside the Theiler window of each reference point.  The window does
+    // not reach past the ends of the capture the point is in.
+    double total_pairs = 0;
+    for(int r = 0; r < num_references; r++) {
+        int i = sorted_index[r*reference_step];
+        int capture = findCapture(i);
+        int first = i - CORRELATION_THEILER_WINDOW;
+        int last = i + CORRELATION_THEILER_WINDOW;
+        if(first < capture_start[capture]) first = capture_start[capture];
+        if(last > capture_start[capture + 1] - CAPTURE_GAP - 1) last = capture_start[capture + 1] - CAPTURE_GAP - 1;
+        total_pairs += num_points - (last - first + 1);
+    }
+    
+    double sum = 0;
+    double results[CORRELATION_NUM_RADII];
+    for(int k = 0; k < CORRELATION_NUM_RADII; k++) {
+        for(int t = 0; t < num_threads; t++) {
+            sum += thread_counts[t*(CORRELATION_NUM_RADII + 1) + k];
+        }
+        results[k] = sum/total_pairs;
+    }
+    
+    wxMutexLocker locker(result_mutex);
+    if(version != clear_version) {
+        return;
+    }
+    for(int k = 0; k < CORRELATION_NUM_RADII; k++) {
+        correlation[k] = results[k];
+    }
+    result_points = num_points;
+    fitDimension();
+    result_version++;
+}
+
+bool CorrelationDimension::takeSnapshot(long long first, long long end) {
+    /**
+    *   Called with the record locked.  Notes which parts of which chunks
+    *   hold the num_points points from position first, and where each
+    *   capture among them starts.  Trajectory indexes count from first,
+    *   with CAPTURE_GAP added for every capture boundary passed, and
+    *   capture_start ends with the index one capture past the last.
+    *   Returns false if the record does not hold the points.
+    */
+    num_chunks = 0;
+    int first_chunk = ChaosRecord::findChunk(first);
+    if(first_chunk < 0) {
+        return false;
+    }
+    for(int k = first_chunk; k < ChaosRecord::getNumChunks() && ChaosRecord::getChunkStart(k) < end; k++) {
+        if(num_chunks == chunks_allocated) {
+            chunks_allocated = chunks_allocated ? 2*chunks_allocated : 32;
+            chunks = (CorrelationChunk*)realloc(chunks, chunks_allocated*sizeof(CorrelationChunk));
+        }
+        CorrelationChunk* chunk = &chunks[num_chunks++];
+        long long chunk_start = ChaosRecord::getChunkStart(k);
+        chunk->offset = (int)(chunk_start - first);
+        chunk->begin = (first > chunk_start) ? (int)(first - chunk_start) : 0;
+        chunk->end = ChaosRecord::getChunkPoints(k);
+        if(chunk_start + chunk->end > end) chunk->end = (int)(end - chunk_start);
+        for(int c = 0; c < 3; c++) {
+            chunk->channels[c] = ChaosRecord::getChunkChannel(k, c);
+        }
+    }
+    
+    num_captures = 0;
+    int record_captures = ChaosRecord::getNumCaptures();
+    for(int k = 0; k < record_captures; k++) {
+        long long start = ChaosRecord::getCaptureStart(k);
+        if(start >= end) break;
+        if(k + 1 < record_captures && ChaosRecord::getCaptureStart(k + 1) <= first) continue;
+        if(start < first) start = first;
+        if(num_captures + 2 > captures_allocated) {
+            captures_allocated = captures_allocated ? 2*captures_allocated : 64;
+            capture_start = (int*)realloc(capture_start, captures_allocated*sizeof(int));
+        }
+        capture_start[num_captures] = (int)(start - first) + num_captures*CAPTURE_GAP;
+        num_captures++;
+    }
+    if(num_captures == 0) {
+        return false;
+    }
+    capture_start[num_captures] = num_points + num_captures*CAPTURE_GAP;
+    return true;
+}
+
+void CorrelationDimension::buildGrid() {
+    /**
+    *   Sorts the points of the snapshot by grid cell with a counting sort,
+    *   reading the record one chunk at a time.  Afterwards the points of
+    *   cell c are cell_start[c] to cell_start[c+1]-1 and sorted_index
+    *   holds the trajectory index of each point.
+    */
+    if(cell_start == NULL) {
+        cell_start = (int*)malloc((GRID_CELLS + 1)*sizeof(int));
+    }
+    if(sorted_index == NULL) {
+        for(int c = 0; c < 3; c++) {
+            sorted[c] = (short*)malloc(CORRELATION_MAX_POINTS*sizeof(short));
+        }
+        sorted_index = (int*)malloc(CORRELATION_MAX_POINTS*sizeof(int));
+    }
+    
+    memset(cell_start, 0, (GRID_CELLS + 1)*sizeof(int));
+    for(int k = 0; k < num_chunks; k++) {
+        const short* x1 = chunks[k].channels[0];
+        const short* x2 = chunks[k].channels[1];
+        const short* x3 = chunks[k].channels[2];
+        for(int i = chunks[k].begin; i < chunks[k].end; i++) {
+            int cell = ((x1[i] >> CELL_SHIFT)*GRID_SIZE + (x2[i] >> CELL_SHIFT))*GRID_SIZE + (x3[i] >> CELL_SHIFT);
+            cell_start[cell + 1]++;
+        }
+    }
+    for(int c = 0; c < GRID_CELLS; c++) {
+        cell_start[c + 1] += cell_start[c];
+    }
+    
+    // Use the start of the next cell as a write position while filling,
+    // it ends up pointing at the start of its own cell again.  The index
+    // of each point is shifted by the gaps of the captures before it.
+    int capture = 0;
+    int next_capture = capture_start[1] - CAPTURE_GAP;
+    for(int k = 0; k < num_chunks; k++) {
+        const short* x1 = chunks[k].channels[0];
+        const short* x2 = chunks[k].channels[1];
+        const short* x3 = chunks[k].channels[2];
+        int offset = chunks[k].offset;
+        for(int i = chunks[k].begin; i < chunks[k].end; i++) {
+            while(offset + i >= next_capture && capture + 1 < num_captures) {
+                capture++;
+                next_capture = capture_start[capture + 1] - (capture + 1)*CAPTURE_GAP;
+            }
+            int cell = ((x1[i] >> CELL_SHIFT)*GRID_SIZE + (x2[i] >> CELL_SHIFT))*GRID_SIZE + (x3[i] >> CELL_SHIFT);
+            int j = cell_start[cell]++;
+            sorted[0][j] = x1[i];
+            sorted[1][j] = x2[i];
+            sorted[2][j] = x3[i];
+            sorted_index[j] = offset + i + capture*CAPTURE_GAP;
+        }
+    }
+    for(int c = GRID_CELLS; c > 0; c--) {
+        cell_start[c] = cell_start[c - 1];
+    }
+    cell_start[0] = 0;
+}
+
+int CorrelationDimension::findCapture(int index) {
+    /**
+    *   Returns the capture a trajectory index is in, by bisection
+    */
+    int low = 0;
+    int high = num_captures - 1;
+    while(low < high) {
+        int mid = (low + high + 1)/2;
+        if(capture_start[mid] <= index) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+void CorrelationDimension::runJob(int job, int thread) {
+    /**
+    *   Called on the worker pool.  Counts the neighbours of one block of
+    *   reference points and adds them to this thread's totals.
+    */
+    unsigned int histogram[CORRELATION_NUM_RADII + 1];
+    for(int k = 0; k <= CORRELATION_NUM_RADII; k++) {
+        histogram[k] = 0;
+    }
+    
+    int first = job*REFERENCES_PER_JOB;
+    int last = first + REFERENCES_PER_JOB;
+    if(last > num_references) last = num_references;
+    for(int r = first; r < last; r++) {
+        countNeighbours(r*reference_step, histogram);
+    }
+    
+    double* counts = thread_counts + thread*(CORRELATION_NUM_RADII + 1);
+    for(int k = 0; k <= CORRELATION_NUM_RADII; k++) {
+        counts[k] += histogram[k];
+    }
+}
+
+void CorrelationDimension::countNeighbours(int reference, unsigned int* histogram) {
+    /**
+    *   Adds every point within CORRELATION_MAX_RADIUS of the reference
+    *   point to the histogram bin of the smallest radius it is inside.
+    *   Cells that are entirely further away than the largest radius are
+    *   skipped.  Points outside the radius or inside the Theiler window
+    *   go into the extra bin at the end.  Captures are CAPTURE_GAP apart
+    *   in sorted_index, so the window never reaches into another capture.
+    */
+    const int max_d2 = CORRELATION_MAX_RADIUS*CORRELATION_MAX_RADIUS;
+    const int reach = (CORRELATION_MAX_RADIUS + CELL_SIZE - 1) >> CELL_SHIFT;
+    const short* x1 = sorted[0];
+    const short* x2 = sorted[1];
+    const short* x3 = sorted[2];
+    
+    int px = x1[reference];
+    int py = x2[reference];
+    int pz = x3[reference];
+    int pi = sorted_index[reference];
+    int cx = px >> CELL_SHIFT;
+    int cy = py >> CELL_SHIFT;
+    int cz = pz >> CELL_SHIFT;
+    
+    // Squared distance from the reference point to each slab of cells
+    int gap_x[2*reach + 1], gap_y[2*reach + 1], gap_z[2*reach + 1];
+    for(int o = -reach; o <= reach; o++) {
+        int gx = 0, gy = 0, gz = 0;
+        if(o < 0) {
+            gx = px - ((cx + o + 1) << CELL_SHIFT) + 1;
+            gy = py - ((cy + o + 1) << CELL_SHIFT) + 1;
+            gz = pz - ((cz + o + 1) << CELL_SHIFT) + 1;
+        } else if(o > 0) {
+            gx = ((cx + o) << CELL_SHIFT) - px;
+            gy = ((cy + o) << CELL_SHIFT) - py;
+            gz = ((cz + o) << CELL_SHIFT) - pz;
+        }
+        gap_x[o + reach] = gx*gx;
+        gap_y[o + reach] = gy*gy;
+        gap_z[o + reach] = gz*gz;
+    }
+    
+    for(int ox = -reach; ox <= reach; ox++) {
+        int gx = cx + ox;
+        if(gx < 0 || gx >= GRID_SIZE || gap_x[ox + reach] > max_d2) continue;
+        for(int oy = -reach; oy <= reach; oy++) {
+            int gy = cy + oy;
+            int dxy = gap_x[ox + reach] + gap_y[oy + reach];
+            if(gy < 0 || gy >= GRID_SIZE || dxy > max_d2) continue;
+            
+            // Cells along z are consecutive so the whole run is one range
+            int z_first = -reach, z_last = reach;
+            while(z_first <= 0 && (cz + z_first < 0 || dxy + gap_z[z_first + reach] > max_d2)) z_first++;
+            while(z_last >= 0 && (cz + z_last >= GRID_SIZE || dxy + gap_z[z_last + reach] > max_d2)) z_last--;
+            if(z_first > z_last) continue;
+            
+            int row = (gx*GRID_SIZE + gy)*GRID_SIZE + cz;
+            int start = cell_start[row + z_first];
+            int end = cell_start[row + z_last + 1];
+            
+            for(int j = start; j < end; j++) {
+                int dx = x1[j] - px;
+                int dy = x2[j] - py;
+                int dz = x3[j] - pz;
+                int d2 = dx*dx + dy*dy + dz*dz;
+                d2 = (d2 <= max_d2) ? d2 : max_d2 + 1;
+                unsigned int dt = sorted_index[j] - pi + CORRELATION_THEILER_WINDOW;
+                int bin = (dt <= 2*CORRELATION_THEILER_WINDOW) ? CORRELATION_NUM_RADII : radius_bin[d2];
+                histogram[bin]++;
+            }
+        }
+    }
+}
+
+void CorrelationDimension::fitDimension() {
+    /**
+    *   Fits a straight line to log C(r) against log r with least squares
+    *   over the radii where C(r) is inside the scaling region.  Below it
+    *   the estimate is dominated by noise and the ADC resolution, above
+    *   it by the size of the attractor.
+    */
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int n = 0;
+    for(int k = 0; k < CORRELATION_NUM_RADII; k++) {
+        if(correlation[k] >= FIT_MIN_CORRELATION && correlation[k] <= FIT_MAX_CORRELATION) {
+            double x = log(radii[k]);
+            double y = log(correlation[k]);
+            sx += x;
+            sy += y;
+            sxx += x*x;
+            sxy += x*y;
+            n++;
+        }
+    }
+    
+    if(n < 3) {
+        dimension = 0;
+        return;
+    }
+    dimension = (n*sxy - sx*sy)/(n*sxx - sx*sx);
+}
+
+void CorrelationDimension::lock() {
+    /**
+    *   Locks the results so they can be read
+    */
+    result_mutex.Lock();
+}
+
+void CorrelationDimension::unlock() {
+    /**
+    *   Unlocks the results
+    */
+    result_mutex.Unlock();
+}
+
+int CorrelationDimension::getNumPoints() {
+    /**
+    *   Returns the number of trajectory points the results are based on
+    */
+    return result_points;
+}
+
+float CorrelationDimension::getRadius(int index) {
+    /**
+    *   Returns a radius in ADC counts, index is 0 to CORRELATION_NUM_RADII-1
+    */
+    return radii[index];
+}
+
+double CorrelationDimension::getCorrelation(int index) {
+    /**
+    *   Returns C(r) for a radius, zero if no pairs were that close
+    */
+    return correlation[index];
+}
+
+float CorrelationDimension::getDimension() {
+    /**
+    *   Returns the estimated correlation dimension, zero if there are not
+    *   enough points in the scaling region to fit it yet
+    */
+    return dimension;
+}
+
+unsigned int CorrelationDimension::getResultVersion() {
+    /**
+    *   Returns a number that changes every time the results are published
+    *   or cleared.  Must be called between lock() and unlock().
+    */
+    return result_version;
+}
@@ -0,0 +1,137 @@
+/**
+ * \file CorrelationDimension.h
+ * \brief Headers for CorrelationDimension.cpp
+ */
+
+#ifndef CORRELATIONDIMENSION_H
+#define CORRELATIONDIMENSION_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include "ChaosWorkers.h"
+
+// Longest trajectory that is collected, in samples
+#define CORRELATION_MAX_POINTS 1000000
+
+// Number of points the neighbours are counted around
+#define CORRELATION_REFERENCE_POINTS 4000
+
+// Radii are spaced logarithmically from 1 to the maximum, in ADC counts
+#define CORRELATION_MAX_RADIUS 128
+#define CORRELATION_RADII_PER_OCTAVE 3
+#define CORRELATION_NUM_RADII (7*CORRELATION_RADII_PER_OCTAVE + 1)
+
+// Pairs closer than this in time within one capture are not counted
+// (Theiler window)
+#define CORRELATION_THEILER_WINDOW 32
+
+class CorrelationDimension;
+
+struct CorrelationChunk {
+    /**
+    *   Part of a record chunk used by a computation, taken while the
+    *   record is locked so it can be read after unlocking
+    */
+    const short* channels[3];
+    int offset;
+    int begin;
+    int end;
+};
+
+class CorrelationWorker : public wxThread
+{
+    /**
+    *   Thread that recomputes the correlation sum whenever enough new
+    *   points have been collected.  The counting itself is spread over
+    *   the worker pool.
+    */
+    public:
+        CorrelationWorker(CorrelationDimension* estimator);
+    protected:
+        ExitCode Entry();
+    private:
+        CorrelationDimension* estimator;
+};
+
+class CorrelationDimension : public ChaosTask
+{
+    public:
+        // class constructor
+        CorrelationDimension();
+        // class destructor
+        ~CorrelationDimension();
+        void update();
+        void clear();
+        int getNumCollected();
+        
+        // Results of the last computation, must be locked while read
+        void lock();
+        void unlock();
+        int getNumPoints();
+        float getRadius(int index);
+        double getCorrelation(int index);
+        float getDimension();
+        unsigned int getResultVersion();
+        
+        void runJob(int job, int thread);
+        
+    private:
+        friend class CorrelationWorker;
+        bool waitForWork();
+        void compute();
+        bool takeSnapshot(long long first, long long end);
+        void buildGrid();
+        int findCapture(int index);
+        void countNeighbours(int reference, unsigned int* histogram);
+        void fitDimension();
+        
+        CorrelationWorker* worker;
+        wxMutex work_mutex;
+        wxCondition work_condition;
+        wxMutex result_mutex;
+        bool stopping;
+        
+        // Changed by clear() so that results from before it are dropped
+        unsigned int clear_version;
+        
+        // Changed whenever the results are published or cleared
+        unsigned int result_version;
+        
+        // Part of the long capture record that is used, guarded by work_mutex.
+        // Positions are those of ChaosRecord.
+        unsigned int record_generation;
+        long long start_position;
+        long long collected_end;
+        long long computed_end;
+        
+        // Chunks of the record the computation reads and the start of each
+        // capture in them, see takeSnapshot()
+        CorrelationChunk* chunks;
+        int num_chunks;
+        int chunks_allocated;
+        int* capture_start;
+        int num_captures;
+        int captures_allocated;
+        
+        // Snapshot the worker computes on, sorted into grid cells
+        short* sorted[3];
+        int* sorted_index;
+        int* cell_start;
+        int num_points;
+        
+        // Squared distance to radius bin lookup
+        unsigned char radius_bin[CORRELATION_MAX_RADIUS*CORRELATION_MAX_RADIUS + 2];
+        float radii[CORRELATION_NUM_RADII];
+        
+        // Per thread pair counts for each radius bin
+        double* thread_counts;
+        int reference_step;
+        int num_references;
+        
+        // Published results
+        double correlation[CORRELATION_NUM_RADII];
+        int result_points;
+        float dimension;
+};
+
+#endif // CORRELATIONDIMENSION_H
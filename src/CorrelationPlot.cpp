@@ -0,0 +1,155 @@
+/**
+ * \file CorrelationPlot.cpp
+ * \brief Implements class for plotting the correlation sum
+ */
+
+#include <math.h>
+#include "CorrelationPlot.h"
+#include "ChaosCalibration.h"
+#include "ChaosCapture.h"
+
+CorrelationPlot::CorrelationPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name) 
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the correlation dimension plot.
+    *   Plots log C(r) against log r for the collected trajectory.  The
+    *   slope of the straight part of the curve is the correlation
+    *   dimension of the attractor.
+    */
+    side_gutter_size = 25;
+    bottom_gutter_size = 20;
+    graph_title = wxT("Correlation Dimension");
+    old_mdac = 0;
+    drawn_result = 0;
+    log_r_min = 0;
+    log_r_max = 1;
+    log_c_min = -1;
+    log_c_max = 0;
+}
+
+CorrelationPlot::~CorrelationPlot() {
+    /**
+    *   Deconstructor for the CorrelationPlot class
+    */
+}
+
+void CorrelationPlot::drawPlot() {
+    /**
+    *   Main drawing function for the CorrelationPlot class.
+    *
+    *   Hands any new capture to the estimator and draws the last C(r) it
+    *   computed.  The radius is shown in volts unless the settings ask
+    *   for ADC values.
+    */
+    // Start again if the circuit has changed
+    if(old_mdac != device_mdac_value) {
+        estimator.clear();
+        old_mdac = device_mdac_value;
+    }
+    
+    estimator.update();
+    
+    float r_scale = ChaosCalibration::getScale(ChaosCapture::X1);
+    
+    // Copy the results so the estimator is not held up while we draw
+    double log_r[CORRELATION_NUM_RADII];
+    double log_c[CORRELATION_NUM_RADII];
+    bool valid[CORRELATION_NUM_RADII];
+    
+    estimator.lock();
+    drawn_result = estimator.getResultVersion();
+    int num_points = estimator.getNumPoints();
+    float dimension = estimator.getDimension();
+    for(int i = 0; i < CORRELATION_NUM_RADII; i++) {
+        double c = estimator.getCorrelation(i);
+        valid[i] = c > 0;
+        log_r[i] = log10(estimator.getRadius(i)*r_scale);
+        log_c[i] = valid[i] ? log10(c) : 0;
+    }
+    estimator.unlock();
+    
+    // Axes are in half decades on r and whole decades on C(r)
+    log_r_min = floor(log_r[0]*2)/2;
+    log_r_max = ceil(log_r[CORRELATION_NUM_RADII - 1]*2)/2;
+    log_c_max = 0;
+    log_c_min = -1;
+    for(int i = 0; i < CORRELATION_NUM_RADII; i++) {
+        if(valid[i] && log_c[i] < log_c_min) {
+            log_c_min = floor(log_c[i]);
+        }
+    }
+    
+    if(r_scale == 1) {
+        graph_subtitle = wxT("log C(r) vs. log r (ADC)");
+    } else {
+        graph_subtitle = wxT("log C(r) vs. log r (V)");
+    }
+    if(dimension > 0) {
+        graph_note = wxString::Format(wxT("D2 = %.2f from %d points"), dimension, num_points);
+    } else {
+        graph_note = wxString::Format(wxT("collecting %d points"), estimator.getNumCollected());
+    }
+    
+    startDraw();
+    
+    drawYAxis(log_c_min, log_c_max, 1);
+    drawXAxis(log_r_min, log_r_max, 0.5);
+    
+    float x_scale = graph_width/(log_r_max - log_r_min);
+    float y_scale = graph_height/(log_c_max - log_c_min);
+    
+    //Use blue pen
+    wxPen bluePen(*wxBLUE, 2); // blue pen of width 2
+    wxBrush blueBrush(*wxBLUE_BRUSH);
+    buffer->SetPen(bluePen);
+    buffer->SetBrush(blueBrush);
+    
+    bool have_last = false;
+    int last_x = 0, last_y = 0;
+    for(int i = 0; i < CORRELATION_NUM_RADII; i++) {
+        if(!valid[i]) {
+            continue;
+        }
+        int x = (int)((log_r[i] - log_r_min)*x_scale) + side_gutter_size;
+        int y = (int)(graph_height - (log_c[i] - log_c_min)*y_scale) + top_gutter_size;
+        if(have_last) {
+            buffer->DrawLine(last_x, last_y, x, y);
+        }
+        buffer->DrawCircle(x, y, 2);
+        last_x = x;
+        last_y = y;
+        have_last = true;
+    }
+    
+    endDraw();
+}
+
+bool CorrelationPlot::needsRedraw() {
+    /**
+    *   C(r) is computed on a worker thread and arrives some time after the
+    *   capture that started it, so the plot is also drawn again when a new
+    *   result has been published since the last frame.
+    */
+    if(ChaosPlot::needsRedraw()) {
+        return true;
+    }
+    estimator.lock();
+    bool published = estimator.getResultVersion() != drawn_result;
+    estimator.unlock();
+    return published;
+}
+
+void CorrelationPlot::UpdateStatusBar(int m_x, int m_y) {
+    /**
+    *   Shows r and C(r) under the cursor in the status bar
+    */
+    if(statusBar && graph_width > 0 && graph_height > 0) {
+        float log_r = log_r_min + (m_x - side_gutter_size)*(log_r_max - log_r_min)/graph_width;
+        float log_c = log_c_min + (graph_height + top_gutter_size - m_y)*(log_c_max - log_c_min)/graph_height;
+        
+        statusBar->SetStatusText(wxString::Format(wxT("(r = %.3g, C = %.3g)"),
+                                        pow(10.0, log_r),
+                                        pow(10.0, log_c)), 3);
+    }
+}
@@ -0,0 +1,43 @@
+/**
+ * \file CorrelationPlot.h
+ * \brief Headers for CorrelationPlot.cpp
+ */
+
+#ifndef CORRELATIONPLOT_H
+#define CORRELATIONPLOT_H
+
+#include "ChaosPlot.h"
+#include "CorrelationDimension.h"
+
+class CorrelationPlot : public ChaosPlot
+{
+    public:
+        // class constructor
+        CorrelationPlot(wxWindow* parent, 
+                       wxWindowID id = wxID_ANY, 
+                       const wxPoint& pos = wxDefaultPosition, 
+                       const wxSize& size = wxDefaultSize, 
+                       long style = wxTAB_TRAVERSAL, 
+                       const wxString& name = wxT("panel"));
+        // class destructor
+        ~CorrelationPlot();
+        void drawPlot();
+        bool needsRedraw();
+    private:
+        void UpdateStatusBar(int m_x, int m_y);
+        
+        int old_mdac;
+        
+        // Range of the axes, in log10 units
+        float log_r_min;
+        float log_r_max;
+        float log_c_min;
+        float log_c_max;
+        
+        CorrelationDimension estimator;
+        
+        // Version of the results last drawn
+        unsigned int drawn_result;
+};
+
+#endif // CORRELATIONPLOT_H
@@ -0,0 +1,202 @@
+/**
+ * \file CrossSpectrum.cpp
+ * \brief Averaged cross spectra, phase and coherence between the channels
+ */
+
+#include <math.h>
+#include "CrossSpectrum.h"
+#include "libchaos.h"
+
+CrossSpectrum::CrossSpectrum() {
+    /**
+    *   Constructor for the CrossSpectrum class.
+    *
+    *   Each capture is cut into segments of CROSS_FFT_SIZE samples that
+    *   overlap by half, and the power of each channel and the cross
+    *   spectrum of each pair of channels are summed over every segment
+    *   since the last clear.  From the sums come the gain and phase from
+    *   one channel to another and their coherence, which only means
+    *   something once a number of segments have been averaged.
+    */
+    generation = ChaosCapture::getGeneration();
+    fft.setSize(CROSS_FFT_SIZE);
+    for(int i = 0; i < CROSS_FFT_SIZE; i++) {
+        window[i] = 0.5*(1 - cos(2*M_PI*i/CROSS_FFT_SIZE));
+    }
+    clear();
+}
+
+void CrossSpectrum::update() {
+    /**
+    *   Adds the segments of any capture that arrived since the last call
+    */
+    if(generation == ChaosCapture::getGeneration()) {
+        return;
+    }
+    generation = ChaosCapture::getGeneration();
+
+    int num_points = ChaosCapture::getNumPoints();
+    for(int start = 0; start + CROSS_FFT_SIZE <= num_points; start += CROSS_FFT_SIZE/2) {
+        addSegment(start);
+    }
+}
+
+void CrossSpectrum::addSegment(int start) {
+    /**
+    *   Transforms one segment of every channel and adds it to the sums.
+    *
+    *   The channels are real, so two of them are transformed at once as
+    *   the real and imaginary parts of one complex transform and split
+    *   apart afterwards.  All three channels take two transforms, and every
+    *   pair is worked out from them without transforming again.
+    */
+    const short* x1 = ChaosCapture::getChannel(ChaosCapture::X1) + start;
+    const short* x2 = ChaosCapture::getChannel(ChaosCapture::X2) + start;
+    const short* x3 = ChaosCapture::getChannel(ChaosCapture::X3) + start;
+
+    float mean1 = 0, mean2 = 0, mean3 = 0;
+    for(int i = 0; i < CROSS_FFT_SIZE; i++) {
+        mean1 += x1[i];
+        mean2 += x2[i];
+        mean3 += x3[i];
+    }
+    mean1 /= CROSS_FFT_SIZE;
+    mean2 /= CROSS_FFT_SIZE;
+    mean3 /= CROSS_FFT_SIZE;
+
+    for(int i = 0; i < CROSS_FFT_SIZE; i++) {
+        re[i] = (x1[i] - mean1)*window[i];
+        im[i] = (x2[i] - mean2)*window[i];
+    }
+    fft.forward(re, im);
+    splitSpectra(ChaosCapture::X1, ChaosCapture::X2);
+
+    for(int i = 0; i < CROSS_FFT_SIZE; i++) {
+        re[i] = (x3[i] - mean3)*window[i];
+        im[i] = 0;
+    }
+    fft.forward(re, im);
+    for(int k = 0; k < CROSS_BINS; k++) {
+        spectrum_re[ChaosCapture::X3][k] = re[k];
+        spectrum_im[ChaosCapture::X3][k] = im[k];
+    }
+
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        for(int k = 0; k < CROSS_BINS; k++) {
+            power[c][k] += spectrum_re[c][k]*spectrum_re[c][k] + spectrum_im[c][k]*spectrum_im[c][k];
+        }
+    }
+
+    // Pair p is channel p with the channel after it
+    for(int p = 0; p < CROSS_PAIRS; p++) {
+        int q = (p + 1) % ChaosCapture::NUM_CHANNELS;
+        const float* ar = spectrum_re[p];
+        const float* ai = spectrum_im[p];
+        const float* br = spectrum_re[q];
+        const float* bi = spectrum_im[q];
+        for(int k = 0; k < CROSS_BINS; k++) {
+            cross_re[p][k] += ar[k]*br[k] + ai[k]*bi[k];
+            cross_im[p][k] += ar[k]*bi[k] - ai[k]*br[k];
+        }
+    }
+    num_segments++;
+}
+
+void CrossSpectrum::splitSpectra(int first, int second) {
+    /**
+    *   Separates the transform of first + i*second, which is in re and im,
+    *   into the spectra of the two channels.  With Z the transform,
+    *   first is (Z[k] + conj(Z[N-k]))/2 and second is (Z[k] - conj(Z[N-k]))/2i.
+    */
+    for(int k = 0; k < CROSS_BINS; k++) {
+        int j = (CROSS_FFT_SIZE - k) & (CROSS_FFT_SIZE - 1);
+        spectrum_re[first][k] = 0.5f*(re[k] + re[j]);
+        spectrum_im[first][k] = 0.5f*(im[k] - im[j]);
+        spectrum_re[second][k] = 0.5f*(im[k] + im[j]);
+        spectrum_im[second][k] = 0.5f*(re[j] - re[k]);
+    }
+}
+
+void CrossSpectrum::clear() {
+    /**
+    *   Throws away the segments averaged so far
+    */
+    for(int k = 0; k < CROSS_BINS; k++) {
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            power[c][k] = 0;
+        }
+        for(int p = 0; p < CROSS_PAIRS; p++) {
+            cross_re[p][k] = 0;
+            cross_im[p][k] = 0;
+        }
+    }
+    num_segments = 0;
+}
+
+int CrossSpectrum::getNumSegments() {
+    /**
+    *   Returns the number of segments in the averages
+    */
+    return num_segments;
+}
+
+void CrossSpectrum::getCross(int from, int to, int bin, double* re, double* im) {
+    /**
+    *   Returns the summed cross spectrum conj(From)*To.  Only one order of
+    *   each pair is kept, the other order is its conjugate.
+    */
+    if((from + 1) % ChaosCapture::NUM_CHANNELS == to) {
+        *re = cross_re[from][bin];
+        *im = cross_im[from][bin];
+    } else {
+        *re = cross_re[to][bin];
+        *im = -cross_im[to][bin];
+    }
+}
+
+float CrossSpectrum::getGain(int from, int to, int bin) {
+    /**
+    *   Returns the gain in dB from one channel to another, worked out as
+    *   |S(from, to)|/S(from, from) so that noise only on the output
+    *   averages away
+    */
+    double cr, ci;
+    getCross(from, to, bin, &cr, &ci);
+    double magnitude = sqrt(cr*cr + ci*ci);
+    if(magnitude <= 0 || power[from][bin] <= 0) {
+        return -200;
+    }
+    return 20*log10(magnitude/power[from][bin]);
+}
+
+float CrossSpectrum::getPhase(int from, int to, int bin) {
+    /**
+    *   Returns the phase of one channel relative to another in degrees,
+    *   -180 to 180, positive where to leads from
+    */
+    double cr, ci;
+    getCross(from, to, bin, &cr, &ci);
+    return atan2(ci, cr)*180/M_PI;
+}
+
+float CrossSpectrum::getCoherence(int from, int to, int bin) {
+    /**
+    *   Returns the magnitude squared coherence between two channels, from
+    *   0 where they are unrelated to 1 where one is a linear function of
+    *   the other
+    */
+    double cr, ci;
+    getCross(from, to, bin, &cr, &ci);
+    double powers = power[from][bin]*power[to][bin];
+    if(powers <= 0) {
+        return 0;
+    }
+    return (cr*cr + ci*ci)/powers;
+}
+
+float CrossSpectrum::binToFrequency(float bin) {
+    /**
+    *   Converts a bin to a frequency in Hz
+    */
+    return bin*float(LIBCHAOS_SAMPLE_FREQUENCY)/CROSS_FFT_SIZE;
+}
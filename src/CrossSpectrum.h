@@ -0,0 +1,59 @@
+/**
+ * \file CrossSpectrum.h
+ * \brief Headers for CrossSpectrum.cpp
+ */
+
+#ifndef CROSSSPECTRUM_H
+#define CROSSSPECTRUM_H
+
+#include "ChaosCapture.h"
+#include "ChaosFFT.h"
+
+// Length of each segment the spectra are averaged over
+#define CROSS_FFT_SIZE 1024
+
+// Number of bins from DC up to half the sample frequency
+#define CROSS_BINS (CROSS_FFT_SIZE/2)
+
+// Pairs of different channels, (X, X'), (X', X'') and (X, X'')
+#define CROSS_PAIRS 3
+
+class CrossSpectrum
+{
+    public:
+        // class constructor
+        CrossSpectrum();
+        void update();
+        void clear();
+        int getNumSegments();
+        float getGain(int from, int to, int bin);
+        float getPhase(int from, int to, int bin);
+        float getCoherence(int from, int to, int bin);
+
+        static float binToFrequency(float bin);
+
+    private:
+        void addSegment(int start);
+        void splitSpectra(int first, int second);
+        void getCross(int from, int to, int bin, double* re, double* im);
+
+        unsigned int generation;
+        int num_segments;
+
+        ChaosFFT fft;
+        float window[CROSS_FFT_SIZE];
+        float re[CROSS_FFT_SIZE];
+        float im[CROSS_FFT_SIZE];
+
+        // Spectrum of each channel in the current segment
+        float spectrum_re[ChaosCapture::NUM_CHANNELS][CROSS_BINS];
+        float spectrum_im[ChaosCapture::NUM_CHANNELS][CROSS_BINS];
+
+        // Sums over every segment of the power of each channel and the
+        // cross spectrum conj(A)*B of each pair
+        double power[ChaosCapture::NUM_CHANNELS][CROSS_BINS];
+        double cross_re[CROSS_PAIRS][CROSS_BINS];
+        double cross_im[CROSS_PAIRS][CROSS_BINS];
+};
+
+#endif // CROSSSPECTRUM_H
@@ -0,0 +1,188 @@
+/**
+ * \file CrossSpectrumPlot.cpp
+ * \brief Implements class for plotting the gain, phase and coherence between two channels
+ */
+
+#include <math.h>
+#include "CrossSpectrumPlot.h"
+
+// Highest bin plotted, about 7 kHz, where the circuit has little power left
+#define CROSS_PLOT_BINS 100
+
+CrossSpectrumPlot::CrossSpectrumPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name)
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the cross spectrum plot.
+    *   Plots the gain, phase or coherence from one channel to another
+    *   against frequency, averaged over every capture since the MDAC last
+    *   changed.  Through an integrator stage the gain should fall by
+    *   20 dB a decade with the phase at -90 degrees.
+    */
+    side_gutter_size = 35;
+    bottom_gutter_size = 20;
+    old_mdac = 0;
+    quantity = GAIN;
+    y_min = -40;
+    y_max = 40;
+    setPair(0);
+    graph_title = wxT("Cross Spectrum");
+}
+
+CrossSpectrumPlot::~CrossSpectrumPlot() {
+    /**
+    *   Deconstructor for the CrossSpectrumPlot class
+    */
+}
+
+void CrossSpectrumPlot::drawPlot() {
+    /**
+    *   Main drawing function for the CrossSpectrumPlot class.
+    *
+    *   Adds any new capture to the averages and draws the chosen quantity
+    *   as a line through the bins.  The gain axis is fitted to the values
+    *   in steps of 10 dB, phase and coherence have fixed axes.
+    */
+    if(old_mdac != device_mdac_value) {
+        spectrum.clear();
+        old_mdac = device_mdac_value;
+    }
+
+    spectrum.update();
+
+    const wxChar* names[ChaosCapture::NUM_CHANNELS] = { wxT("X"), wxT("X'"), wxT("X''") };
+    float y_step;
+    if(quantity == GAIN) {
+        float low = 0, high = 0;
+        for(int k = 1; k < CROSS_PLOT_BINS; k++) {
+            float value = getValue(k);
+            if(value > -100) {
+                if(value < low) low = value;
+                if(value > high) high = value;
+            }
+        }
+        y_min = 10*floor(low/10);
+        y_max = 10*ceil(high/10);
+        if(y_max <= y_min) y_max = y_min + 10;
+        y_step = (y_max - y_min > 60) ? 20 : 10;
+        graph_subtitle = wxString::Format(wxT("Gain from %s to %s (dB) vs. Frequency (Hz)"),
+                                          names[from_channel], names[to_channel]);
+    } else if(quantity == PHASE) {
+        y_min = -180;
+        y_max = 180;
+        y_step = 90;
+        graph_subtitle = wxString::Format(wxT("Phase of %s relative to %s (degrees) vs. Frequency (Hz)"),
+                                          names[to_channel], names[from_channel]);
+    } else {
+        y_min = 0;
+        y_max = 1;
+        y_step = 0.25;
+        graph_subtitle = wxString::Format(wxT("Coherence of %s and %s vs. Frequency (Hz)"),
+                                          names[from_channel], names[to_channel]);
+    }
+    graph_note = wxString::Format(wxT("%d segments"), spectrum.getNumSegments());
+
+    startDraw();
+    drawYAxis(y_min, y_max, y_step);
+    drawXAxis(0, CrossSpectrum::binToFrequency(CROSS_PLOT_BINS), 1000);
+
+    if(spectrum.getNumSegments() > 0) {
+        wxPoint points[CROSS_PLOT_BINS - 1];
+        for(int k = 1; k < CROSS_PLOT_BINS; k++) {
+            points[k - 1] = wxPoint(binToX(k), valueToY(getValue(k)));
+        }
+        buffer->SetPen(wxPen(*wxBLUE, 1));
+        buffer->DrawLines(CROSS_PLOT_BINS - 1, points);
+    }
+
+    endDraw();
+}
+
+float CrossSpectrumPlot::getValue(int bin) {
+    /**
+    *   Returns the chosen quantity at a bin
+    */
+    if(quantity == GAIN) {
+        return spectrum.getGain(from_channel, to_channel, bin);
+    } else if(quantity == PHASE) {
+        return spectrum.getPhase(from_channel, to_channel, bin);
+    }
+    return spectrum.getCoherence(from_channel, to_channel, bin);
+}
+
+void CrossSpectrumPlot::setPair(int pair) {
+    /**
+    *   Chooses the channels, 0 is X to X', 1 is X' to X'' and 2 is X to X''
+    */
+    const int from[CROSS_PAIRS] = { ChaosCapture::X1, ChaosCapture::X2, ChaosCapture::X1 };
+    const int to[CROSS_PAIRS] = { ChaosCapture::X2, ChaosCapture::X3, ChaosCapture::X3 };
+    this->pair = pair;
+    from_channel = from[pair];
+    to_channel = to[pair];
+    invalidate();
+}
+
+int CrossSpectrumPlot::getPair() {
+    /**
+    *   Returns the pair of channels that is plotted
+    */
+    return pair;
+}
+
+void CrossSpectrumPlot::setQuantity(int quantity) {
+    /**
+    *   Chooses between the gain, phase and coherence
+    */
+    this->quantity = quantity;
+    invalidate();
+}
+
+int CrossSpectrumPlot::getQuantity() {
+    /**
+    *   Returns the quantity that is plotted
+    */
+    return quantity;
+}
+
+void CrossSpectrumPlot::reset() {
+    /**
+    *   Throws away the averages so far
+    */
+    spectrum.clear();
+    invalidate();
+}
+
+int CrossSpectrumPlot::binToX(int bin) {
+    /**
+    *   Converts a bin to an X coordinate on the graph
+    */
+    return side_gutter_size + bin*graph_width/CROSS_PLOT_BINS;
+}
+
+int CrossSpectrumPlot::valueToY(float value) {
+    /**
+    *   Converts a value of the plotted quantity to a Y coordinate, keeping
+    *   it on the graph
+    */
+    if(value < y_min) value = y_min;
+    if(value > y_max) value = y_max;
+    return top_gutter_size + (int)(graph_height*(1 - (value - y_min)/(y_max - y_min)));
+}
+
+void CrossSpectrumPlot::UpdateStatusBar(int m_x, int m_y) {
+    /**
+    *   Shows the frequency of the bin at the cursor with the gain, phase
+    *   and coherence there
+    */
+    if(statusBar && graph_width > 0 && spectrum.getNumSegments() > 0) {
+        int bin = (int)(float(m_x - side_gutter_size)*CROSS_PLOT_BINS/graph_width + 0.5f);
+        if(bin < 1) bin = 1;
+        if(bin >= CROSS_PLOT_BINS) bin = CROSS_PLOT_BINS - 1;
+
+        statusBar->SetStatusText(wxString::Format(wxT("%.0f Hz: %.1f dB, %.0f deg, coherence %.2f"),
+                                        CrossSpectrum::binToFrequency(bin),
+                                        spectrum.getGain(from_channel, to_channel, bin),
+                                        spectrum.getPhase(from_channel, to_channel, bin),
+                                        spectrum.getCoherence(from_channel, to_channel, bin)), 3);
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * \file CrossSpectrumPlot.h
+ * \brief Headers for CrossSpectrumPlot.cpp
+ */
+
+#ifndef CROSSSPECTRUMPLOT_H
+#define CROSSSPECTRUMPLOT_H
+
+#include "ChaosPlot.h"
+#include "CrossSpectrum.h"
+
+class CrossSpectrumPlot : public ChaosPlot
+{
+    public:
+        // What is plotted against frequency
+        enum Quantities {
+            GAIN = 0,
+            PHASE,
+            COHERENCE
+        };
+
+        // class constructor
+        CrossSpectrumPlot(wxWindow* parent,
+                       wxWindowID id = wxID_ANY,
+                       const wxPoint& pos = wxDefaultPosition,
+                       const wxSize& size = wxDefaultSize,
+                       long style = wxTAB_TRAVERSAL,
+                       const wxString& name = wxT("panel"));
+        // class destructor
+        ~CrossSpectrumPlot();
+        void drawPlot();
+        void setPair(int pair);
+        int getPair();
+        void setQuantity(int quantity);
+        int getQuantity();
+        void reset();
+    private:
+        float getValue(int bin);
+        int binToX(int bin);
+        int valueToY(float value);
+        void UpdateStatusBar(int m_x, int m_y);
+
+        int old_mdac;
+        int pair;
+        int quantity;
+        int from_channel;
+        int to_channel;
+        CrossSpectrum spectrum;
+
+        // Axis range of the last frame, used for the status bar
+        float y_min, y_max;
+};
+
+#endif // CROSSSPECTRUMPLOT_H
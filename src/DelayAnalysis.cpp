@@ -0,0 +1,402 @@
+/**
+ * \file DelayAnalysis.cpp
+ * \brief Chooses the delay for delay coordinate plots
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "DelayAnalysis.h"
+#include "ChaosCapture.h"
+#include "ChaosRecord.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Lags handed to the pool per job
+#define LAGS_PER_JOB 8
+
+// Lags either side a mutual information minimum must be lowest over
+#define MINIMUM_WINDOW 2
+
+DelayAnalysis::DelayAnalysis(int channel) {
+    /**
+    *   Constructor for the DelayAnalysis class.
+    *
+    *   A delay plot of x(t) against x(t - tau) works best when tau is long
+    *   enough for the two coordinates to carry different information but
+    *   short enough that they are still related.  Two standard measures
+    *   are computed for every lag up to DELAY_MAX_LAG and summed over all
+    *   of the captures recorded since the last clear():
+    *
+    *   The autocorrelation, from the power spectrum of each capture.  Its
+    *   first zero crossing is a common choice of tau.
+    *
+    *   The average mutual information, from a joint histogram of each
+    *   pair of samples a lag apart.  Its first minimum is usually the
+    *   better choice for chaotic signals since it also accounts for
+    *   nonlinear dependence.  The histograms of different lags are
+    *   independent so they are split over the worker pool, and within a
+    *   lag the histogram index of each pair is built eight at a time with
+    *   SSE2 before the counts are added.
+    */
+    this->channel = channel;
+    record_generation = ChaosRecord::getGeneration();
+    record_position = ChaosRecord::getEnd();
+    
+    samples = NULL;
+    capture_start = NULL;
+    num_new = 0;
+    captures_allocated = 0;
+    bins = NULL;
+    rows = NULL;
+    num_samples = 0;
+    samples_allocated = 0;
+    indexes = NULL;
+    index_threads = 0;
+    fft_re = NULL;
+    fft_im = NULL;
+    joint = (unsigned int*)malloc((DELAY_MAX_LAG + 1)*DELAY_BINS*DELAY_BINS*sizeof(unsigned int));
+    
+    clear();
+}
+
+DelayAnalysis::~DelayAnalysis() {
+    /**
+    *   Destructor for the DelayAnalysis class
+    */
+    free(samples);
+    free(capture_start);
+    free(bins);
+    free(rows);
+    free(indexes);
+    free(fft_re);
+    free(fft_im);
+    free(joint);
+}
+
+void DelayAnalysis::clear() {
+    /**
+    *   Throws away everything accumulated so far
+    */
+    num_captures = 0;
+    memset(joint, 0, (DELAY_MAX_LAG + 1)*DELAY_BINS*DELAY_BINS*sizeof(unsigned int));
+    for(int k = 0; k <= DELAY_MAX_LAG; k++) {
+        acf_sum[k] = 0;
+        acf_count[k] = 0;
+        mutual_information[k] = 0;
+    }
+    acf_lag = 0;
+    ami_lag = 0;
+}
+
+void DelayAnalysis::setChannel(int channel) {
+    /**
+    *   Sets the channel that is analysed and starts again
+    */
+    if(channel != this->channel) {
+        this->channel = channel;
+        clear();
+    }
+}
+
+int DelayAnalysis::getChannel() {
+    /**
+    *   Returns the channel that is analysed
+    */
+    return channel;
+}
+
+void DelayAnalysis::update() {
+    /**
+    *   Adds the captures recorded since the last call.  Only the new
+    *   captures are processed, everything else is kept as running sums.
+    */
+    if(record_generation == ChaosRecord::getGeneration()) {
+        return;
+    }
+    record_generation = ChaosRecord::getGeneration();
+    
+    readRecord();
+    if(num_new == 0) {
+        return;
+    }
+    
+    int threads = ChaosWorkers::getNumThreads();
+    if(threads != index_threads) {
+        indexes = (unsigned short*)realloc(indexes, threads*samples_allocated*sizeof(unsigned short));
+        index_threads = threads;
+    }
+    
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi16(DELAY_BINS - 1);
+    const __m128i row_size = _mm_set1_epi16(DELAY_BINS);
+    for(; i + 8 <= num_samples; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(samples + i));
+        __m128i b = _mm_and_si128(_mm_srai_epi16(s, DELAY_BIN_SHIFT), mask);
+        _mm_storeu_si128((__m128i*)(bins + i), b);
+        _mm_storeu_si128((__m128i*)(rows + i), _mm_mullo_epi16(b, row_size));
+    }
+#endif
+    for(; i < num_samples; i++) {
+        bins[i] = (samples[i] >> DELAY_BIN_SHIFT) & (DELAY_BINS - 1);
+        rows[i] = bins[i]*DELAY_BINS;
+    }
+    
+    for(int n = 0; n < num_new; n++) {
+        addAutocorrelation(samples + capture_start[n], capture_start[n + 1] - capture_start[n]);
+    }
+    ChaosWorkers::run(this, (DELAY_MAX_LAG + LAGS_PER_JOB)/LAGS_PER_JOB);
+    num_captures += num_new;
+    
+    findLags();
+}
+
+void DelayAnalysis::readRecord() {
+    /**
+    *   Copies the captures recorded since the last call out of the record,
+    *   one run at a time, so that each one is contiguous.  A capture the
+    *   reading starts part way through is skipped, as are captures too
+    *   short for the largest lag.
+    */
+    long long position = record_position;
+    if(position < ChaosRecord::getEnd() - DELAY_CATCH_UP) {
+        position = ChaosRecord::getEnd() - DELAY_CATCH_UP;
+    }
+    if(position < ChaosRecord::getStart()) {
+        position = ChaosRecord::getStart();
+    }
+    
+    num_new = 0;
+    num_samples = 0;
+    const short* data;
+    bool starts_capture;
+    int points;
+    while((points = ChaosRecord::getRun(position, channel, &data, &starts_capture)) > 0) {
+        position += points;
+        if(starts_capture) {
+            // Close the capture before, dropping it if it is too short
+            if(num_new > 0 && num_samples - capture_start[num_new - 1] <= DELAY_MAX_LAG + 1) {
+                num_new--;
+                num_samples = capture_start[num_new];
+            }
+            if(num_new + 2 > captures_allocated) {
+                captures_allocated = captures_allocated ? 2*captures_allocated : 16;
+                capture_start = (int*)realloc(capture_start, captures_allocated*sizeof(int));
+            }
+            capture_start[num_new++] = num_samples;
+        }
+        if(num_new == 0) {
+            continue;
+        }
+        if(num_samples + points > samples_allocated) {
+            samples_allocated = num_samples + points;
+            samples = (short*)realloc(samples, samples_allocated*sizeof(short));
+            bins = (unsigned short*)realloc(bins, samples_allocated*sizeof(unsigned short));
+            rows = (unsigned short*)realloc(rows, samples_allocated*sizeof(unsigned short));
+            index_threads = 0;
+        }
+        memcpy(samples + num_samples, data, points*sizeof(short));
+        num_samples += points;
+    }
+    record_position = position;
+    
+    if(num_new > 0 && num_samples - capture_start[num_new - 1] <= DELAY_MAX_LAG + 1) {
+        num_new--;
+        num_samples = capture_start[num_new];
+    }
+    if(num_new > 0) {
+        capture_start[num_new] = num_samples;
+    }
+}
+
+void DelayAnalysis::addAutocorrelation(const short* samples, int num_samples) {
+    /**
+    *   Adds the lagged products of one capture to the sums.  The capture
+    *   has its mean removed and is zero padded to at least twice its
+    *   length so that the inverse transform of its power spectrum gives
+    *   the linear rather than circular correlation.
+    */
+    int size = ChaosFFT::nextPowerOfTwo(2*num_samples);
+    if(size != fft.getSize()) {
+        fft.setSize(size);
+        fft_re = (float*)realloc(fft_re, size*sizeof(float));
+        fft_im = (float*)realloc(fft_im, size*sizeof(float));
+    }
+    
+    float mean = 0;
+    for(int i = 0; i < num_samples; i++) {
+        mean += samples[i];
+    }
+    mean /= num_samples;
+    
+    for(int i = 0; i < num_samples; i++) {
+        fft_re[i] = samples[i] - mean;
+        fft_im[i] = 0;
+    }
+    for(int i = num_samples; i < size; i++) {
+        fft_re[i] = 0;
+        fft_im[i] = 0;
+    }
+    
+    fft.forward(fft_re, fft_im);
+    for(int i = 0; i < size; i++) {
+        fft_re[i] = fft_re[i]*fft_re[i] + fft_im[i]*fft_im[i];
+        fft_im[i] = 0;
+    }
+    fft.inverse(fft_re, fft_im);
+    
+    for(int k = 0; k <= DELAY_MAX_LAG; k++) {
+        acf_sum[k] += fft_re[k];
+        acf_count[k] += num_samples - k;
+    }
+}
+
+void DelayAnalysis::runJob(int job, int thread) {
+    /**
+    *   Called on the worker pool.  Adds the new captures to the joint
+    *   histograms of a block of lags and recomputes their mutual
+    *   information from the totals.  Pairs are only made within a capture.
+    */
+    int first = job*LAGS_PER_JOB;
+    int last = first + LAGS_PER_JOB;
+    if(last > DELAY_MAX_LAG + 1) last = DELAY_MAX_LAG + 1;
+    
+    unsigned int row[DELAY_BINS];
+    unsigned int column[DELAY_BINS];
+    unsigned short* index = indexes + thread*samples_allocated;
+    
+    for(int k = first; k < last; k++) {
+        unsigned int* hist = joint + k*DELAY_BINS*DELAY_BINS;
+        for(int n = 0; n < num_new; n++) {
+            const unsigned short* row_offset = rows + capture_start[n];
+            const unsigned short* lagged = bins + capture_start[n] + k;
+            int count = capture_start[n + 1] - capture_start[n] - k;
+            
+            // The index of each pair is its row offset plus the lagged bin
+            int i = 0;
+#ifdef __SSE2__
+            for(; i + 8 <= count; i += 8) {
+                __m128i r = _mm_loadu_si128((const __m128i*)(row_offset + i));
+                __m128i b = _mm_loadu_si128((const __m128i*)(lagged + i));
+                _mm_storeu_si128((__m128i*)(index + i), _mm_add_epi16(r, b));
+            }
+#endif
+            for(; i < count; i++) {
+                index[i] = row_offset[i] + lagged[i];
+            }
+            for(i = 0; i < count; i++) {
+                hist[index[i]]++;
+            }
+        }
+        
+        // Marginals come from the joint histogram so they match it exactly
+        double total = 0;
+        for(int b = 0; b < DELAY_BINS; b++) {
+            row[b] = 0;
+            column[b] = 0;
+        }
+        for(int a = 0; a < DELAY_BINS; a++) {
+            for(int b = 0; b < DELAY_BINS; b++) {
+                row[a] += hist[a*DELAY_BINS + b];
+                column[b] += hist[a*DELAY_BINS + b];
+            }
+            total += row[a];
+        }
+        
+        // I = sum p(a,b) log2(p(a,b)/(p(a)p(b)))
+        double information = 0;
+        for(int a = 0; a < DELAY_BINS; a++) {
+            if(row[a] == 0) continue;
+            for(int b = 0; b < DELAY_BINS; b++) {
+                unsigned int n = hist[a*DELAY_BINS + b];
+                if(n == 0) continue;
+                information += n*log((double(n)*total)/(double(row[a])*column[b]));
+            }
+        }
+        mutual_information[k] = information/(total*log(2.0));
+    }
+}
+
+void DelayAnalysis::findLags() {
+    /**
+    *   Finds the first zero crossing of the autocorrelation and the first
+    *   minimum of the mutual information.  Either is left at zero if it
+    *   is not within DELAY_MAX_LAG.
+    */
+    acf_lag = 0;
+    for(int k = 1; k <= DELAY_MAX_LAG; k++) {
+        if(getAutocorrelation(k) <= 0) {
+            acf_lag = k;
+            break;
+        }
+    }
+    
+    // The histograms are noisy from lag to lag so a minimum has to be
+    // the smallest value within MINIMUM_WINDOW lags on either side
+    ami_lag = 0;
+    for(int k = 1; k <= DELAY_MAX_LAG - MINIMUM_WINDOW && ami_lag == 0; k++) {
+        ami_lag = k;
+        for(int j = k - MINIMUM_WINDOW; j <= k + MINIMUM_WINDOW; j++) {
+            if(j >= 0 && j != k && mutual_information[j] <= mutual_information[k]) {
+                ami_lag = 0;
+                break;
+            }
+        }
+    }
+}
+
+int DelayAnalysis::getNumCaptures() {
+    /**
+    *   Returns the number of captures the results are summed over
+    */
+    return num_captures;
+}
+
+float DelayAnalysis::getAutocorrelation(int lag) {
+    /**
+    *   Returns the autocorrelation at a lag, normalized to 1 at lag 0
+    */
+    if(acf_count[lag] == 0 || acf_sum[0] == 0) {
+        return 0;
+    }
+    return (acf_sum[lag]/acf_count[lag])/(acf_sum[0]/acf_count[0]);
+}
+
+float DelayAnalysis::getMutualInformation(int lag) {
+    /**
+    *   Returns the average mutual information at a lag in bits
+    */
+    return mutual_information[lag];
+}
+
+int DelayAnalysis::getAutocorrelationLag() {
+    /**
+    *   Returns the first zero crossing of the autocorrelation, or zero
+    */
+    return acf_lag;
+}
+
+int DelayAnalysis::getMutualInformationLag() {
+    /**
+    *   Returns the first minimum of the mutual information, or zero
+    */
+    return ami_lag;
+}
+
+int DelayAnalysis::getSuggestedLag() {
+    /**
+    *   Returns the suggested delay.  This is the first minimum of the
+    *   mutual information, or the first zero of the autocorrelation if
+    *   there is no minimum, or 1 if there is nothing to go on yet.
+    */
+    if(ami_lag > 0) {
+        return ami_lag;
+    }
+    if(acf_lag > 0) {
+        return acf_lag;
+    }
+    return 1;
+}
@@ -0,0 +1,89 @@
+/**
+ * \file DelayAnalysis.h
+ * \brief Headers for DelayAnalysis.cpp
+ */
+
+#ifndef DELAYANALYSIS_H
+#define DELAYANALYSIS_H
+
+#include "ChaosWorkers.h"
+#include "ChaosFFT.h"
+
+// Largest lag analysed, in samples
+#define DELAY_MAX_LAG 256
+
+// The 10-bit ADC values are binned 32 to a bin for the mutual information.
+// There can be at most 256 bins so a joint histogram index fits in 16 bits.
+#define DELAY_BIN_SHIFT 5
+#define DELAY_BINS (1024 >> DELAY_BIN_SHIFT)
+
+// Most recorded samples analysed in one update.  If the analysis falls
+// further behind than this the older captures are skipped.
+#define DELAY_CATCH_UP 65536
+
+class DelayAnalysis : public ChaosTask
+{
+    public:
+        // class constructor
+        DelayAnalysis(int channel = 0);
+        // class destructor
+        ~DelayAnalysis();
+        void update();
+        void clear();
+        void setChannel(int channel);
+        int getChannel();
+        int getNumCaptures();
+        float getAutocorrelation(int lag);
+        float getMutualInformation(int lag);
+        int getAutocorrelationLag();
+        int getMutualInformationLag();
+        int getSuggestedLag();
+        
+        void runJob(int job, int thread);
+        
+    private:
+        void readRecord();
+        void addAutocorrelation(const short* samples, int num_samples);
+        void findLags();
+        
+        int channel;
+        int num_captures;
+        
+        // Position in ChaosRecord up to which the captures have been added
+        unsigned int record_generation;
+        long long record_position;
+        
+        // New captures copied out of the record one after the other, with
+        // the start of each one and a last entry for the end
+        short* samples;
+        int* capture_start;
+        int num_new;
+        int captures_allocated;
+        
+        // Bin of each of those samples, and the offset of its row in a
+        // joint histogram
+        unsigned short* bins;
+        unsigned short* rows;
+        int num_samples;
+        int samples_allocated;
+        
+        // Histogram index of each pair of samples, one array per thread
+        unsigned short* indexes;
+        int index_threads;
+        
+        // Sums of the lagged products and how many went into each
+        ChaosFFT fft;
+        float* fft_re;
+        float* fft_im;
+        double acf_sum[DELAY_MAX_LAG + 1];
+        double acf_count[DELAY_MAX_LAG + 1];
+        
+        // Joint histogram of (x[i], x[i+lag]) for every lag
+        unsigned int* joint;
+        float mutual_information[DELAY_MAX_LAG + 1];
+        
+        int acf_lag;
+        int ami_lag;
+};
+
+#endif // DELAYANALYSIS_H
@@ -0,0 +1,122 @@
+/**
+ * \file DelayPlot.cpp
+ * \brief Implements class for plotting the delay selection measures
+ */
+
+#include "DelayPlot.h"
+
+// Names of the capture channels used in the title
+static const wxChar* channel_names[] = { wxT("X"), wxT("X'"), wxT("X''") };
+
+DelayPlot::DelayPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name) 
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the delay selection plot.
+    *   Plots the autocorrelation and the mutual information of one channel
+    *   against the lag and marks the suggested tau for delay plots.
+    */
+    side_gutter_size = 25;
+    bottom_gutter_size = 20;
+    old_mdac = 0;
+}
+
+DelayPlot::~DelayPlot() {
+    /**
+    *   Deconstructor for the DelayPlot class
+    */
+}
+
+void DelayPlot::drawPlot() {
+    /**
+    *   Main drawing function for the DelayPlot class.
+    *
+    *   The autocorrelation is drawn in blue and the mutual information,
+    *   scaled so that it is 1 at lag 0, in red.  The suggested tau is
+    *   marked with a green line.
+    */
+    if(old_mdac != device_mdac_value) {
+        analysis.clear();
+        old_mdac = device_mdac_value;
+    }
+    
+    analysis.update();
+    
+    int tau = analysis.getSuggestedLag();
+    graph_title = wxString::Format(wxT("Delay Selection for %s"), channel_names[analysis.getChannel()]);
+    graph_subtitle = wxT("Autocorrelation (blue), Mutual Information (red) vs. Lag (samples)");
+    graph_note = wxString::Format(wxT("tau = %d"), tau);
+    
+    startDraw();
+    drawYAxis(-1, 1, 0.5);
+    drawXAxis(0, DELAY_MAX_LAG, 32);
+    
+    if(analysis.getNumCaptures() > 0) {
+        float ami_scale = analysis.getMutualInformation(0);
+        if(ami_scale <= 0) ami_scale = 1;
+        
+        wxPoint acf_points[DELAY_MAX_LAG + 1];
+        wxPoint ami_points[DELAY_MAX_LAG + 1];
+        for(int k = 0; k <= DELAY_MAX_LAG; k++) {
+            acf_points[k] = wxPoint(lagToX(k), valueToY(analysis.getAutocorrelation(k)));
+            ami_points[k] = wxPoint(lagToX(k), valueToY(analysis.getMutualInformation(k)/ami_scale));
+        }
+        
+        buffer->SetPen(wxPen(*wxGREEN, 1));
+        buffer->DrawLine(lagToX(tau), top_gutter_size, lagToX(tau), top_gutter_size + graph_height);
+        
+        buffer->SetPen(wxPen(*wxBLUE, 2));
+        buffer->DrawLines(DELAY_MAX_LAG + 1, acf_points);
+        buffer->SetPen(wxPen(*wxRED, 2));
+        buffer->DrawLines(DELAY_MAX_LAG + 1, ami_points);
+    }
+    
+    endDraw();
+}
+
+void DelayPlot::setChannel(int channel) {
+    /**
+    *   Sets the channel that is analysed
+    */
+    analysis.setChannel(channel);
+    invalidate();
+}
+
+int DelayPlot::getChannel() {
+    /**
+    *   Returns the channel that is analysed
+    */
+    return analysis.getChannel();
+}
+
+int DelayPlot::lagToX(int lag) {
+    /**
+    *   Converts a lag to an X coordinate on the graph
+    */
+    return (lag*graph_width)/DELAY_MAX_LAG + side_gutter_size;
+}
+
+int DelayPlot::valueToY(float value) {
+    /**
+    *   Converts a value between -1 and 1 to a Y coordinate on the graph
+    */
+    if(value < -1) value = -1;
+    if(value > 1) value = 1;
+    return (int)(top_gutter_size + graph_height*(1 - value)/2);
+}
+
+void DelayPlot::UpdateStatusBar(int m_x, int m_y) {
+    /**
+    *   Shows the lag and both measures at the cursor in the status bar
+    */
+    if(statusBar && graph_width > 0 && analysis.getNumCaptures() > 0) {
+        int lag = ((m_x - side_gutter_size)*DELAY_MAX_LAG + graph_width/2)/graph_width;
+        if(lag < 0) lag = 0;
+        if(lag > DELAY_MAX_LAG) lag = DELAY_MAX_LAG;
+        
+        statusBar->SetStatusText(wxString::Format(wxT("(lag %d, ACF %.3f, AMI %.3f bits)"),
+                                        lag,
+                                        analysis.getAutocorrelation(lag),
+                                        analysis.getMutualInformation(lag)), 3);
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * \file DelayPlot.h
+ * \brief Headers for DelayPlot.cpp
+ */
+
+#ifndef DELAYPLOT_H
+#define DELAYPLOT_H
+
+#include "ChaosPlot.h"
+#include "DelayAnalysis.h"
+
+class DelayPlot : public ChaosPlot
+{
+    public:
+        // class constructor
+        DelayPlot(wxWindow* parent, 
+                       wxWindowID id = wxID_ANY, 
+                       const wxPoint& pos = wxDefaultPosition, 
+                       const wxSize& size = wxDefaultSize, 
+                       long style = wxTAB_TRAVERSAL, 
+                       const wxString& name = wxT("panel"));
+        // class destructor
+        ~DelayPlot();
+        void drawPlot();
+        void setChannel(int channel);
+        int getChannel();
+    private:
+        int lagToX(int lag);
+        int valueToY(float value);
+        void UpdateStatusBar(int m_x, int m_y);
+        
+        int old_mdac;
+        DelayAnalysis analysis;
+};
+
+#endif // DELAYPLOT_H
@@ -4,6 +4,8 @@
  */
 
 #include "FFTPlot.h"
+#include "FrequencyTracker.h"
+#include "ChaosSpectrum.h"
 
 FFTPlot::FFTPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
                        const wxSize& size, long style, const wxString& name) 
@@ -31,16 +33,23 @@ void FFTPlot::drawPlot() {
      * Draw the FFT Plot
      *
      * The FFT data is not collected by this function but is simply 
-     * draw by it. The main timer call to libchaos_readPlot() handles 
-     * the data collection and FFT calculation and then stores that 
-     * data. Calls to libchaos_getFFTPlotPoint() pull in the data from
-     * libchaos. From here, it's just plotting the points where we want 
-     * them.
+     * draw by it. The main timer calls ChaosSpectrum::update(), which
+     * takes the spectrum from libchaos or works it out in fixed point
+     * depending on the settings, and stores that data. From here, it's
+     * just plotting the points where we want them.  The fundamental found at the current MDAC value, if any,
+     * is marked with a red line.
      */
     // number of points to use in the graph
     const int points_to_graph  = 400;
     // number of data points used for FFT
-    const int N = 8192;
+    const int N = SPECTRUM_FFT_SIZE;
+    
+    float fundamental = FrequencyTracker::getFrequency(device_mdac_value, 0);
+    if(fundamental > 0) {
+        graph_note = wxString::Format(wxT("fundamental %.1f Hz"), fundamental);
+    } else {
+        graph_note = wxEmptyString;
+    }
     
     int x_axis_max = (int)(float(points_to_graph)/(N*1/float(LIBCHAOS_SAMPLE_FREQUENCY)));
     
@@ -53,11 +62,12 @@ void FFTPlot::drawPlot() {
     float x_scale = float(graph_width)/points_to_graph;
     float y_scale = graph_height/15.0;
 
-    libchaos_getFFTPlotPoint(&a_old, 1);
+    const float* spectrum = ChaosSpectrum::getSpectrum();
+    a_old = spectrum[1];
     a_old = graph_height + top_gutter_size - (a_old*y_scale);
     
     for(int i = 0; i < points_to_graph; i++) {
-        libchaos_getFFTPlotPoint(&a, i+2);
+        a = spectrum[i+2];
         a = graph_height + top_gutter_size - (a*y_scale);
         if ( a > graph_height + top_gutter_size ) {
             a = graph_height + top_gutter_size;
@@ -74,5 +84,12 @@ void FFTPlot::drawPlot() {
         a_old = a;
     }
     
+    // Point i of the graph is bin i+1
+    if(fundamental > 0) {
+        int x = (int)((FrequencyTracker::frequencyToBin(fundamental) - 1)*x_scale) + side_gutter_size;
+        buffer->SetPen(wxPen(*wxRED, 1));
+        buffer->DrawLine(x, top_gutter_size, x, graph_height + top_gutter_size);
+    }
+    
     endDraw();
 }
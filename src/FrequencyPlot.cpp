@@ -0,0 +1,188 @@
+/**
+ * \file FrequencyPlot.cpp
+ * \brief Implements class for plotting the fundamental frequency against the MDAC value
+ */
+
+#include "FrequencyPlot.h"
+#include "FrequencyTracker.h"
+#include "ChaosSettings.h"
+#include "ChaosCalibration.h"
+
+FrequencyPlot::FrequencyPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name)
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the frequency tracking plot.
+    *   Plots the fundamental frequency (blue) and its harmonics (green)
+    *   found at each MDAC value the device has been at, laid out like the
+    *   bifurcation so the two can be compared.
+    */
+    side_gutter_size = 40;
+    bottom_gutter_size = 30;
+    show_harmonics = false;
+    y_max = 1000;
+    graph_title = wxT("Frequency Tracking");
+}
+
+FrequencyPlot::~FrequencyPlot() {
+    /**
+    *   Deconstructor for the FrequencyPlot class
+    */
+}
+
+void FrequencyPlot::drawPlot() {
+    /**
+    *   Main drawing function for the FrequencyPlot class.
+    *
+    *   Draws every stored frequency as a point and the current MDAC value
+    *   as a line.  The frequency axis is scaled to the highest frequency
+    *   shown, rounded up to 500 Hz.
+    */
+    int shown = show_harmonics ? FREQUENCY_HARMONICS : 1;
+    float highest = 0;
+    for(int m = 0; m < FREQUENCY_MDAC_VALUES; m++) {
+        for(int h = 0; h < shown; h++) {
+            float frequency = FrequencyTracker::getFrequency(m, h);
+            if(frequency > highest) highest = frequency;
+        }
+    }
+    y_max = 500*(int(highest/500) + 1);
+    if(y_max < 1000) y_max = 1000;
+
+    wxString xaxis_title;
+    if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) {
+        xaxis_title = wxT("Mdac values");
+    } else {
+        xaxis_title = wxT("Resistance (Ohms)");
+    }
+    graph_subtitle = wxString::Format(wxT("%s (Hz) vs. %s"),
+                                      show_harmonics ? wxT("Fundamental and Harmonics") : wxT("Fundamental"),
+                                      xaxis_title.c_str());
+
+    startDraw();
+    drawYAxis(0, y_max, y_max/5);
+    if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) {
+        drawXAxis(FREQUENCY_MDAC_VALUES - 1, 0, -(FREQUENCY_MDAC_VALUES - 1)/4);
+    } else {
+        float min = ChaosCalibration::mdacToResistance(FREQUENCY_MDAC_VALUES - 1);
+        float max = ChaosCalibration::mdacToResistance(0);
+        drawXAxis(min, max, (max - min)/4);
+    }
+
+    wxPoint* points = raster.getPoints(FREQUENCY_MDAC_VALUES*FREQUENCY_HARMONICS);
+    int num_points = 0;
+    startRaster();
+    for(int m = 0; m < FREQUENCY_MDAC_VALUES; m++) {
+        for(int h = 1; h < shown; h++) {
+            float frequency = FrequencyTracker::getFrequency(m, h);
+            if(frequency > 0) {
+                points[num_points++] = wxPoint(mdacToX(m), frequencyToY(frequency));
+            }
+        }
+    }
+    raster.setColour(*wxGREEN);
+    drawPoints(points, num_points);
+
+    // The fundamental goes on top of the harmonics
+    num_points = 0;
+    for(int m = 0; m < FREQUENCY_MDAC_VALUES; m++) {
+        if(FrequencyTracker::hasFrequencies(m)) {
+            points[num_points++] = wxPoint(mdacToX(m), frequencyToY(FrequencyTracker::getFrequency(m, 0)));
+        }
+    }
+    raster.setColour(*wxBLUE);
+    drawPoints(points, num_points);
+    endRaster();
+
+    endDraw();
+}
+
+void FrequencyPlot::drawOverlay() {
+    /**
+    *   Draws the line for the current MDAC value on top of the points
+    */
+    if(device_connected) {
+        buffer->SetPen(wxPen(*wxRED, 1));
+        int x = mdacToX(device_mdac_value);
+        buffer->DrawLine(x, top_gutter_size, x, graph_height + top_gutter_size);
+    }
+}
+
+void FrequencyPlot::setShowHarmonics(bool show) {
+    /**
+    *   Shows or hides the harmonics of the fundamental
+    */
+    show_harmonics = show;
+    invalidate();
+}
+
+void FrequencyPlot::reset() {
+    /**
+    *   Throws away the frequencies found so far
+    */
+    FrequencyTracker::clear();
+    invalidate();
+}
+
+int FrequencyPlot::mdacToX(int mdac_value) {
+    /**
+    *   Converts an MDAC value to an X coordinate, the largest MDAC value
+    *   on the left as on the bifurcation
+    */
+    const int largest = FREQUENCY_MDAC_VALUES - 1;
+    if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) {
+        return side_gutter_size + (int)((float(largest - mdac_value)/largest)*graph_width);
+    } else {
+        float left = ChaosCalibration::mdacToResistance(largest);
+        float right = ChaosCalibration::mdacToResistance(0);
+        float resistance = ChaosCalibration::mdacToResistance(mdac_value);
+        return side_gutter_size + (int)(((resistance - left)/(right - left))*graph_width);
+    }
+}
+
+int FrequencyPlot::xToMdac(int x) {
+    /**
+    *   Converts an X coordinate to an MDAC value
+    */
+    const int largest = FREQUENCY_MDAC_VALUES - 1;
+    float fraction = float(x - side_gutter_size)/graph_width;
+    int mdac_value;
+    if(ChaosSettings::BifXAxis == ChaosSettings::MDAC_VALUES) {
+        mdac_value = largest - (int)(fraction*largest + 0.5f);
+    } else {
+        float left = ChaosCalibration::mdacToResistance(largest);
+        float right = ChaosCalibration::mdacToResistance(0);
+        mdac_value = ChaosCalibration::resistanceToMdac(left + fraction*(right - left));
+    }
+    if(mdac_value < 0) mdac_value = 0;
+    if(mdac_value > largest) mdac_value = largest;
+    return mdac_value;
+}
+
+int FrequencyPlot::frequencyToY(float frequency) {
+    /**
+    *   Converts a frequency in Hz to a Y coordinate
+    */
+    return top_gutter_size + (int)(graph_height*(1 - frequency/y_max));
+}
+
+void FrequencyPlot::UpdateStatusBar(int m_x, int m_y) {
+    /**
+    *   Shows the MDAC value and frequency at the cursor, and the
+    *   fundamental stored for that MDAC value if there is one
+    */
+    if(statusBar && graph_width > 0 && graph_height > 0) {
+        int mdac_value = xToMdac(m_x);
+        float frequency = y_max*(1 - float(m_y - top_gutter_size)/graph_height);
+        if(FrequencyTracker::hasFrequencies(mdac_value)) {
+            statusBar->SetStatusText(wxString::Format(wxT("(%d, %.0f Hz) f0 = %.1f Hz"),
+                                            mdac_value,
+                                            frequency,
+                                            FrequencyTracker::getFrequency(mdac_value, 0)), 3);
+        } else {
+            statusBar->SetStatusText(wxString::Format(wxT("(%d, %.0f Hz)"),
+                                            mdac_value,
+                                            frequency), 3);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/**
+ * \file FrequencyPlot.h
+ * \brief Headers for FrequencyPlot.cpp
+ */
+
+#ifndef FREQUENCYPLOT_H
+#define FREQUENCYPLOT_H
+
+#include "ChaosPlot.h"
+
+class FrequencyPlot : public ChaosPlot
+{
+    public:
+        // class constructor
+        FrequencyPlot(wxWindow* parent,
+                       wxWindowID id = wxID_ANY,
+                       const wxPoint& pos = wxDefaultPosition,
+                       const wxSize& size = wxDefaultSize,
+                       long style = wxTAB_TRAVERSAL,
+                       const wxString& name = wxT("panel"));
+        // class destructor
+        ~FrequencyPlot();
+        void drawPlot();
+        void setShowHarmonics(bool show);
+        void reset();
+    private:
+        int mdacToX(int mdac_value);
+        int xToMdac(int x);
+        int frequencyToY(float frequency);
+        void UpdateStatusBar(int m_x, int m_y);
+        void drawOverlay();
+
+        bool show_harmonics;
+
+        // Top of the frequency axis in the last frame, used for the status bar
+        float y_max;
+};
+
+#endif // FREQUENCYPLOT_H
@@ -0,0 +1,160 @@
+/**
+ * \file FrequencyTracker.cpp
+ * \brief Tracks the fundamental frequency and its harmonics against the MDAC value
+ */
+
+#include <stdlib.h>
+#include "FrequencyTracker.h"
+#include "ChaosSpectrum.h"
+#include "libchaos.h"
+
+// Lowest bin the fundamental is looked for in, the bins below hold the DC
+// level of the capture, which libchaos does not remove
+#define FREQUENCY_MIN_BIN 4
+
+// Bins either side of a multiple of the fundamental searched for a harmonic
+#define HARMONIC_SEARCH_BINS 3
+
+namespace FrequencyTracker {
+    /**
+    *   The frequencies found at each MDAC value and the spectrum they are
+    *   being found in.
+    */
+    float frequencies[FREQUENCY_MDAC_VALUES][FREQUENCY_HARMONICS];
+    bool measured[FREQUENCY_MDAC_VALUES];
+    const float* spectrum = NULL;
+    unsigned int spectrum_generation = 0;
+    unsigned int generation = 0;
+
+    int findPeak(int low, int high) {
+        /**
+        *   Returns the strongest bin from low to high, or -1 if it is not
+        *   higher than the bins either side of it.
+        */
+        if(low < 1) low = 1;
+        if(high > SPECTRUM_BINS - 2) high = SPECTRUM_BINS - 2;
+        if(low > high) {
+            return -1;
+        }
+
+        int peak = low;
+        for(int k = low + 1; k <= high; k++) {
+            if(spectrum[k] > spectrum[peak]) {
+                peak = k;
+            }
+        }
+        if(spectrum[peak] <= spectrum[peak-1] || spectrum[peak] <= spectrum[peak+1]) {
+            return -1;
+        }
+        return peak;
+    }
+
+    float interpolatePeak(int peak) {
+        /**
+        *   Fits a parabola through a peak bin and the bins either side of it
+        *   and returns where its top is, in fractional bins.  The spectrum is
+        *   in log power, where the top of a windowed sine is close to a
+        *   parabola, so this is good to a small fraction of a bin.
+        */
+        float a = spectrum[peak-1];
+        float b = spectrum[peak];
+        float c = spectrum[peak+1];
+        float denominator = a - 2*b + c;
+        if(denominator >= 0) {
+            return peak;
+        }
+        float offset = 0.5f*(a - c)/denominator;
+        if(offset > 0.5f) offset = 0.5f;
+        if(offset < -0.5f) offset = -0.5f;
+        return peak + offset;
+    }
+
+    void update() {
+        /**
+        *   Finds the fundamental in any new spectrum as its strongest peak,
+        *   then looks for each harmonic near its multiple of the fundamental.
+        *   The result replaces whatever was stored for the MDAC value.
+        */
+        if(spectrum_generation == ChaosSpectrum::getGeneration()) {
+            return;
+        }
+        spectrum_generation = ChaosSpectrum::getGeneration();
+
+        spectrum = ChaosSpectrum::getSpectrum();
+        int mdac_value = ChaosSpectrum::getMdacValue();
+        if(mdac_value < 0 || mdac_value >= FREQUENCY_MDAC_VALUES) {
+            return;
+        }
+
+        int peak = findPeak(FREQUENCY_MIN_BIN, SPECTRUM_BINS);
+        if(peak < 0) {
+            return;
+        }
+        float fundamental = interpolatePeak(peak);
+        frequencies[mdac_value][0] = binToFrequency(fundamental);
+
+        for(int h = 1; h < FREQUENCY_HARMONICS; h++) {
+            int centre = (int)(fundamental*(h + 1) + 0.5f);
+            peak = findPeak(centre - HARMONIC_SEARCH_BINS, centre + HARMONIC_SEARCH_BINS);
+            if(peak < 0) {
+                frequencies[mdac_value][h] = 0;
+            } else {
+                frequencies[mdac_value][h] = binToFrequency(interpolatePeak(peak));
+            }
+        }
+        measured[mdac_value] = true;
+        generation++;
+    }
+
+    void clear() {
+        /**
+        *   Throws away every stored frequency
+        */
+        for(int m = 0; m < FREQUENCY_MDAC_VALUES; m++) {
+            measured[m] = false;
+        }
+        generation++;
+    }
+
+    unsigned int getGeneration() {
+        /**
+        *   Returns a counter that changes whenever a frequency is stored
+        */
+        return generation;
+    }
+
+    bool hasFrequencies(int mdac_value) {
+        /**
+        *   Returns true if frequencies have been measured at an MDAC value
+        */
+        if(mdac_value < 0 || mdac_value >= FREQUENCY_MDAC_VALUES) {
+            return false;
+        }
+        return measured[mdac_value];
+    }
+
+    float getFrequency(int mdac_value, int harmonic) {
+        /**
+        *   Returns the frequency of a harmonic at an MDAC value in Hz,
+        *   0 if it has not been found
+        */
+        if(hasFrequencies(mdac_value) == false) {
+            return 0;
+        }
+        return frequencies[mdac_value][harmonic];
+    }
+
+    float binToFrequency(float bin) {
+        /**
+        *   Converts a fractional FFT bin to a frequency in Hz
+        */
+        return bin*float(LIBCHAOS_SAMPLE_FREQUENCY)/SPECTRUM_FFT_SIZE;
+    }
+
+    float frequencyToBin(float frequency) {
+        /**
+        *   Converts a frequency in Hz to a fractional FFT bin
+        */
+        return frequency*SPECTRUM_FFT_SIZE/float(LIBCHAOS_SAMPLE_FREQUENCY);
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * \file FrequencyTracker.h
+ * \brief Headers for FrequencyTracker.cpp
+ */
+
+#ifndef FREQUENCYTRACKER_H
+#define FREQUENCYTRACKER_H
+
+// Number of MDAC values frequencies are stored for
+#define FREQUENCY_MDAC_VALUES 4096
+
+// Frequencies stored per MDAC value, the fundamental and its harmonics
+#define FREQUENCY_HARMONICS 4
+
+namespace FrequencyTracker {
+    /**
+    *   Namespace holding the fundamental frequency and its harmonics found
+    *   at each MDAC value.  The spectrum is already worked out whenever the
+    *   MDAC value changes, so the peaks are found in ChaosSpectrum rather
+    *   than transforming the data again, and are kept per MDAC value like
+    *   the peaks of the bifurcation.
+    */
+
+    // Measures the newest spectrum, call after ChaosSpectrum::update()
+    extern void update();
+
+    // Throws away every stored frequency
+    extern void clear();
+
+    // Incremented every time a frequency is stored
+    extern unsigned int getGeneration();
+
+    // True if frequencies have been measured at an MDAC value
+    extern bool hasFrequencies(int mdac_value);
+
+    // Frequency in Hz of a harmonic at an MDAC value, 0 is the fundamental.
+    // Returns 0 for a harmonic that was not found.
+    extern float getFrequency(int mdac_value, int harmonic);
+
+    // Converts between FFT bins and frequencies in Hz
+    extern float binToFrequency(float bin);
+    extern float frequencyToBin(float frequency);
+}
+
+#endif // FREQUENCYTRACKER_H
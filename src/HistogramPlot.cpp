@@ -0,0 +1,165 @@
+/**
+ * \file HistogramPlot.cpp
+ * \brief Implements class for plotting the amplitude histogram of each channel
+ */
+
+#include <math.h>
+#include "HistogramPlot.h"
+#include "ChaosSettings.h"
+#include "ChaosCalibration.h"
+
+HistogramPlot::HistogramPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name)
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the amplitude histogram plot.
+    *   Plots the fraction of samples at each value of X (red), X' (blue)
+    *   and X'' (green) over every capture since the MDAC last changed.
+    */
+    side_gutter_size = 30;
+    bottom_gutter_size = 20;
+    old_mdac = 0;
+    log_scale = false;
+    x_min = 0;
+    x_max = 1;
+    y_min = 0;
+    y_max = 1;
+}
+
+HistogramPlot::~HistogramPlot() {
+    /**
+    *   Deconstructor for the HistogramPlot class
+    */
+}
+
+void HistogramPlot::drawPlot() {
+    /**
+    *   Main drawing function for the HistogramPlot class.
+    *
+    *   Counts any new capture and draws each channel as a line through its
+    *   bins.  Bins are placed with the calibration of their own channel so
+    *   the channels line up in volts.  On the log scale, empty bins are
+    *   drawn on the bottom of the graph.
+    */
+    if(old_mdac != device_mdac_value) {
+        histogram.clear();
+        old_mdac = device_mdac_value;
+    }
+
+    histogram.update();
+
+    unsigned long long num_samples = histogram.getNumSamples();
+    unsigned long long max_count = 0;
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        unsigned long long count = histogram.getMaxCount(c);
+        if(count > max_count) max_count = count;
+    }
+
+    x_min = ChaosCalibration::toUnits(ChaosCapture::X1, 0);
+    x_max = ChaosCalibration::toUnits(ChaosCapture::X1, HISTOGRAM_BINS);
+    double max_fraction = num_samples ? double(max_count)/num_samples : 1;
+    if(max_fraction <= 0) max_fraction = 1;
+
+    float y_step;
+    if(log_scale) {
+        y_min = num_samples ? floor(log10(1.0/num_samples)) : -1;
+        y_max = ceil(log10(max_fraction));
+        if(y_max <= y_min) y_max = y_min + 1;
+        y_step = (y_max - y_min > 8) ? 2 : 1;
+    } else {
+        y_min = 0;
+        y_max = max_fraction*1.05;
+        y_step = y_max/4;
+    }
+
+    graph_title = wxT("Amplitude Histogram");
+    graph_subtitle = wxString::Format(wxT("%s vs. %s, X (red), X' (blue), X'' (green)"),
+                                      log_scale ? wxT("log10 Fraction of Samples") : wxT("Fraction of Samples"),
+                                      ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC ? wxT("Value (ADC)") : wxT("Value (V)"));
+    graph_note = wxString::Format(wxT("%.0f samples"), (double)num_samples);
+
+    startDraw();
+    drawYAxis(y_min, y_max, y_step);
+    drawXAxis(x_min, x_max, (x_max - x_min)/6.0);
+
+    if(num_samples > 0) {
+        const wxColour* colours[ChaosCapture::NUM_CHANNELS] = { wxRED, wxBLUE, wxGREEN };
+        wxPoint points[HISTOGRAM_BINS];
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            const unsigned long long* counts = histogram.getCounts(c);
+            const float* values = ChaosCalibration::getTable(c);
+            for(int b = 0; b < HISTOGRAM_BINS; b++) {
+                points[b] = wxPoint(valueToX(values[b]), fractionToY(double(counts[b])/num_samples));
+            }
+            buffer->SetPen(wxPen(*colours[c], 1));
+            buffer->DrawLines(HISTOGRAM_BINS, points);
+        }
+    }
+
+    endDraw();
+}
+
+void HistogramPlot::setLogScale(bool log_scale) {
+    /**
+    *   Switches the Y axis between a linear and a log scale
+    */
+    this->log_scale = log_scale;
+    invalidate();
+}
+
+bool HistogramPlot::getLogScale() {
+    /**
+    *   Returns true if the Y axis is on a log scale
+    */
+    return log_scale;
+}
+
+void HistogramPlot::reset() {
+    /**
+    *   Throws away the counts so far
+    */
+    histogram.clear();
+    invalidate();
+}
+
+int HistogramPlot::valueToX(float value) {
+    /**
+    *   Converts a value in the current units to an X coordinate on the graph
+    */
+    return side_gutter_size + (int)((value - x_min)*graph_width/(x_max - x_min));
+}
+
+int HistogramPlot::fractionToY(double fraction) {
+    /**
+    *   Converts a fraction of the samples to a Y coordinate on the graph
+    */
+    double value = fraction;
+    if(log_scale) {
+        value = fraction > 0 ? log10(fraction) : y_min;
+    }
+    if(value < y_min) value = y_min;
+    return top_gutter_size + (int)(graph_height*(1 - (value - y_min)/(y_max - y_min)));
+}
+
+void HistogramPlot::UpdateStatusBar(int m_x, int m_y) {
+    /**
+    *   Shows the value at the cursor and the fraction of samples in the bin
+    *   of each channel at that value
+    */
+    if(statusBar && graph_width > 0 && histogram.getNumSamples() > 0) {
+        float value = x_min + float(m_x - side_gutter_size)*(x_max - x_min)/graph_width;
+        double fractions[ChaosCapture::NUM_CHANNELS];
+        for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+            int bin = (int)(ChaosCalibration::toAdc(c, value) + 0.5);
+            if(bin < 0) bin = 0;
+            if(bin >= HISTOGRAM_BINS) bin = HISTOGRAM_BINS - 1;
+            fractions[c] = double(histogram.getCounts(c)[bin])/histogram.getNumSamples();
+        }
+
+        statusBar->SetStatusText(wxString::Format(wxT("(%.3f, %.2e, %.2e, %.2e)"),
+                                        value,
+                                        fractions[0],
+                                        fractions[1],
+                                        fractions[2]), 3);
+    }
+}
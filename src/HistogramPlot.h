@@ -0,0 +1,42 @@
+/**
+ * \file HistogramPlot.h
+ * \brief Headers for HistogramPlot.cpp
+ */
+
+#ifndef HISTOGRAMPLOT_H
+#define HISTOGRAMPLOT_H
+
+#include "ChaosPlot.h"
+#include "AmplitudeHistogram.h"
+
+class HistogramPlot : public ChaosPlot
+{
+    public:
+        // class constructor
+        HistogramPlot(wxWindow* parent,
+                       wxWindowID id = wxID_ANY,
+                       const wxPoint& pos = wxDefaultPosition,
+                       const wxSize& size = wxDefaultSize,
+                       long style = wxTAB_TRAVERSAL,
+                       const wxString& name = wxT("panel"));
+        // class destructor
+        ~HistogramPlot();
+        void drawPlot();
+        void setLogScale(bool log_scale);
+        bool getLogScale();
+        void reset();
+    private:
+        int valueToX(float value);
+        int fractionToY(double fraction);
+        void UpdateStatusBar(int m_x, int m_y);
+
+        int old_mdac;
+        bool log_scale;
+        AmplitudeHistogram histogram;
+
+        // Axis ranges of the last frame, used for the status bar
+        float x_min, x_max;
+        double y_min, y_max;
+};
+
+#endif // HISTOGRAMPLOT_H
@@ -0,0 +1,184 @@
+/**
+ * \file PhosphorBuffer.cpp
+ * \brief Accumulates trajectories that glow and fade like a scope phosphor
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "PhosphorBuffer.h"
+#include "PlotRaster.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Brightness a pixel gains each time the trajectory crosses it, so that a
+// single pass is clearly visible and a few passes reach full brightness
+#define PHOSPHOR_HIT 0x4000
+
+PhosphorBuffer::PhosphorBuffer() {
+    /**
+    *   Constructor for the PhosphorBuffer class.
+    *
+    *   Every capture the whole buffer is dimmed by the persistence and the
+    *   new trajectory is added on top.  A path the circuit keeps following
+    *   stays bright, while an excursion that only happened once fades over
+    *   the next few seconds instead of vanishing with the next capture.
+    *
+    *   The colour map runs from a pale green for faint traces to a dark
+    *   green for the brightest ones, so it stands out on the light
+    *   background of the plots.
+    */
+    levels = NULL;
+    width = 0;
+    height = 0;
+    setPersistence(0.9);
+
+    for(int i = 0; i < PHOSPHOR_COLOURS; i++) {
+        float t = float(i)/(PHOSPHOR_COLOURS - 1);
+        unsigned char* colour = colour_map + 3*i;
+        if(t < 0.5) {
+            float u = 2*t;
+            colour[0] = (unsigned char)(200*(1 - u));
+            colour[1] = (unsigned char)(235 - 45*u);
+            colour[2] = (unsigned char)(200*(1 - u));
+        } else {
+            float u = 2*t - 1;
+            colour[0] = 0;
+            colour[1] = (unsigned char)(190 - 110*u);
+            colour[2] = 0;
+        }
+    }
+}
+
+PhosphorBuffer::~PhosphorBuffer() {
+    /**
+    *   Destructor for the PhosphorBuffer class
+    */
+    free(levels);
+}
+
+void PhosphorBuffer::resize(int width, int height) {
+    /**
+    *   Sets the size of the buffer in pixels.  It is only reallocated, and
+    *   cleared, when the size changes.
+    */
+    if(width < 0) width = 0;
+    if(height < 0) height = 0;
+    if(width == this->width && height == this->height) {
+        return;
+    }
+    levels = (unsigned short*)realloc(levels, (width*height > 0 ? width*height : 1)*sizeof(unsigned short));
+    this->width = width;
+    this->height = height;
+    clear();
+}
+
+void PhosphorBuffer::clear() {
+    /**
+    *   Turns every pixel dark
+    */
+    memset(levels, 0, width*height*sizeof(unsigned short));
+}
+
+void PhosphorBuffer::setPersistence(float persistence) {
+    /**
+    *   Sets the fraction of its brightness a pixel keeps at each decay,
+    *   between 0 and 1
+    */
+    if(persistence < 0) persistence = 0;
+    if(persistence > 65535/65536.0) persistence = 65535/65536.0;
+    decay_factor = (unsigned short)(persistence*65536);
+}
+
+void PhosphorBuffer::decay() {
+    /**
+    *   Dims every pixel by the persistence.  The brightness is scaled in
+    *   16 bit fixed point, which SSE2 does eight pixels at a time with one
+    *   multiply that keeps the high half of each product.
+    */
+    int num_pixels = width*height;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i factor = _mm_set1_epi16((short)decay_factor);
+    for(; i + 8 <= num_pixels; i += 8) {
+        __m128i level = _mm_loadu_si128((const __m128i*)(levels + i));
+        _mm_storeu_si128((__m128i*)(levels + i), _mm_mulhi_epu16(level, factor));
+    }
+#endif
+    for(; i < num_pixels; i++) {
+        levels[i] = (unsigned short)((levels[i]*(unsigned int)decay_factor) >> 16);
+    }
+}
+
+void PhosphorBuffer::addLines(const wxPoint* points, int num_points, int left, int top) {
+    /**
+    *   Brightens the pixels under lines joining the points, which are in
+    *   plot coordinates with the buffer's top left corner at (left, top).
+    *   Each pixel a segment shares with the one before is only brightened
+    *   once.
+    */
+    for(int i = 1; i < num_points; i++) {
+        int x0 = points[i-1].x - left;
+        int y0 = points[i-1].y - top;
+        int x1 = points[i].x - left;
+        int y1 = points[i].y - top;
+        bool joined = x0 >= 0 && x0 < width && y0 >= 0 && y0 < height;
+        if(PlotRaster::clipSegment(x0, y0, x1, y1, width, height)) {
+            addSegment(x0, y0, x1, y1, i == 1 || !joined);
+        }
+    }
+}
+
+void PhosphorBuffer::addSegment(int x0, int y0, int x1, int y1, bool first) {
+    /**
+    *   Brightens the pixels of a segment inside the buffer with Bresenham's
+    *   algorithm, skipping its first pixel unless first is set
+    */
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int step_x = x1 > x0 ? 1 : -1;
+    int step_y = y1 > y0 ? width : -width;
+
+    int steps, minor, step_major, step_minor;
+    if(dx >= dy) {
+        steps = dx;
+        minor = dy;
+        step_major = step_x;
+        step_minor = step_y;
+    } else {
+        steps = dy;
+        minor = dx;
+        step_major = step_y;
+        step_minor = step_x;
+    }
+
+    unsigned short* p = levels + y0*width + x0;
+    int error = steps/2;
+    for(int i = 0; i <= steps; i++) {
+        if(i > 0 || first) {
+            unsigned int level = *p + PHOSPHOR_HIT;
+            *p = level > 0xffff ? 0xffff : level;
+        }
+        p += step_major;
+        error -= minor;
+        if(error < 0) {
+            p += step_minor;
+            error += steps;
+        }
+    }
+}
+
+const unsigned short* PhosphorBuffer::getLevels() {
+    /**
+    *   Returns the brightness of every pixel, row by row
+    */
+    return levels;
+}
+
+const unsigned char* PhosphorBuffer::getColourMap() {
+    /**
+    *   Returns the RGB colour for each value of the top 8 bits of a level
+    */
+    return colour_map;
+}
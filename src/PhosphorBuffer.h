@@ -0,0 +1,41 @@
+/**
+ * \file PhosphorBuffer.h
+ * \brief Headers for PhosphorBuffer.cpp
+ */
+
+#ifndef PHOSPHORBUFFER_H
+#define PHOSPHORBUFFER_H
+
+#include <wx/gdicmn.h>
+
+// Entries in the colour map, one for each value of the top 8 bits of a level
+#define PHOSPHOR_COLOURS 256
+
+class PhosphorBuffer
+{
+    public:
+        PhosphorBuffer();
+        ~PhosphorBuffer();
+        void resize(int width, int height);
+        void clear();
+        void setPersistence(float persistence);
+        void decay();
+        void addLines(const wxPoint* points, int num_points, int left, int top);
+        const unsigned short* getLevels();
+        const unsigned char* getColourMap();
+
+    private:
+        void addSegment(int x0, int y0, int x1, int y1, bool first);
+
+        // Brightness of each pixel, 0 to 65535
+        unsigned short* levels;
+        int width;
+        int height;
+
+        // Fraction of the brightness kept at each decay, in 1/65536ths
+        unsigned short decay_factor;
+
+        unsigned char colour_map[3*PHOSPHOR_COLOURS];
+};
+
+#endif // PHOSPHORBUFFER_H
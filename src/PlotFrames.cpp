@@ -0,0 +1,65 @@
+/**
+ * \file PlotFrames.cpp
+ * \brief Draws a frame of several plots, rendering their traces in parallel
+ */
+
+#include "PlotFrames.h"
+
+PlotFrames::PlotFrames() {
+    /**
+    *   Constructor for the PlotFrames class.
+    *
+    *   In the split and quad views every visible plot is drawn on each
+    *   frame.  Drawing on a DC has to stay on the main thread, but the
+    *   traces are drawn into each plot's raster, which is plain memory.
+    *   PlotFrames runs each plot's drawPlot() deferred so its traces are
+    *   only recorded, renders all of the rasters at once on the worker
+    *   pool, then finishes the plots one after another.  Rendering the
+    *   traces then takes about as long as the slowest plot alone rather
+    *   than all of them added together.
+    */
+    num_plots = 0;
+}
+
+void PlotFrames::add(ChaosPlot* plot) {
+    /**
+    *   Adds a plot to be drawn in the next frame.  Plots past the limit
+    *   are drawn straight away.
+    */
+    if(num_plots == MAX_PLOT_FRAMES) {
+        plot->drawPlot();
+        return;
+    }
+    plots[num_plots++] = plot;
+}
+
+void PlotFrames::draw() {
+    /**
+    *   Draws every plot added since the last frame
+    */
+    if(num_plots == 0) {
+        return;
+    }
+    if(num_plots == 1) {
+        plots[0]->drawPlot();
+        num_plots = 0;
+        return;
+    }
+    for(int i = 0; i < num_plots; i++) {
+        plots[i]->setDeferred(true);
+        plots[i]->drawPlot();
+    }
+    ChaosWorkers::run(this, num_plots);
+    for(int i = 0; i < num_plots; i++) {
+        plots[i]->finishDraw();
+        plots[i]->setDeferred(false);
+    }
+    num_plots = 0;
+}
+
+void PlotFrames::runJob(int job, int thread) {
+    /**
+    *   Renders the traces of one plot on a worker thread
+    */
+    plots[job]->renderFrame();
+}
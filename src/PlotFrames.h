@@ -0,0 +1,31 @@
+/**
+ * \file PlotFrames.h
+ * \brief Headers for PlotFrames.cpp
+ */
+
+#ifndef PLOTFRAMES_H
+#define PLOTFRAMES_H
+
+#include "ChaosWorkers.h"
+#include "ChaosPlot.h"
+
+// Most plots that can be drawn together in one frame
+#define MAX_PLOT_FRAMES 8
+
+class PlotFrames : public ChaosTask
+{
+    public:
+        // class constructor
+        PlotFrames();
+        void add(ChaosPlot* plot);
+        void draw();
+
+        void runJob(int job, int thread);
+
+    private:
+        // Plots waiting to be drawn in the next frame
+        ChaosPlot* plots[MAX_PLOT_FRAMES];
+        int num_plots;
+};
+
+#endif // PLOTFRAMES_H
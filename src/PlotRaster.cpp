@@ -0,0 +1,563 @@
+/**
+ * \file PlotRaster.cpp
+ * \brief Draws plot traces straight into a buffer of pixels
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "PlotRaster.h"
+
+// Value of each component of the colour the buffer is cleared to.  Pixels
+// left in this colour are not copied to the plot.
+#define RASTER_KEY 1
+
+// Kinds of drawing recorded while deferred
+#define RASTER_LINES 0
+#define RASTER_SHADED_LINES 1
+#define RASTER_POINTS 2
+#define RASTER_LEVELS 3
+
+PlotRaster::PlotRaster() {
+    /**
+    *   Constructor for the PlotRaster class.
+    *
+    *   Drawing a trace one wxDC::DrawLine at a time goes through the
+    *   graphics system for every segment, which is most of the time taken
+    *   by plots of thousands of points.  PlotRaster draws the lines and
+    *   points into its own buffer of pixels instead and copies the result
+    *   onto the plot in a single bitmap at the end of the frame.  Pixels
+    *   that were not drawn keep a key colour and are masked out, so the
+    *   axes and grid underneath show through.
+    *
+    *   While deferred, drawing is only recorded and the pixels are left
+    *   alone until render(), which may then be called from a worker
+    *   thread.  Nothing render() does touches wxWidgets, so several plots
+    *   can be rendered at once.
+    */
+    pixels = NULL;
+    left = 0;
+    top = 0;
+    width = 0;
+    height = 0;
+    drawn = false;
+    clear_pending = false;
+    red = 0;
+    green = 0;
+    blue = 0;
+    points = NULL;
+    allocated_points = 0;
+    deferred = false;
+    commands = NULL;
+    num_commands = 0;
+    allocated_commands = 0;
+    recorded_points = NULL;
+    recorded_shades = NULL;
+    num_recorded = 0;
+    allocated_recorded = 0;
+    sprite_radius = -1;
+    sprite_red = 0;
+    sprite_green = 0;
+    sprite_blue = 0;
+    occupancy = NULL;
+    occupancy_epoch = 0;
+    occupancy_valid = false;
+}
+
+PlotRaster::~PlotRaster() {
+    /**
+    *   Destructor for the PlotRaster class
+    */
+    image.Destroy();
+    free(pixels);
+    free(points);
+    free(commands);
+    free(recorded_points);
+    free(recorded_shades);
+    free(occupancy);
+}
+
+bool PlotRaster::begin(int left, int top, int width, int height, bool keep) {
+    /**
+    *   Starts a frame covering the given area of the plot.  The buffer is
+    *   only reallocated when the size of the area changes.  While
+    *   deferred it is cleared by render() instead.
+    *
+    *   With keep, what was drawn in the last frame is left to be drawn
+    *   over, as long as the area has not moved or changed size.  Returns
+    *   true if it was kept.
+    */
+    if(width < 0) width = 0;
+    if(height < 0) height = 0;
+    bool resized = width != this->width || height != this->height;
+    if(resized) {
+        image.Destroy();
+        int size = width*height > 0 ? width*height : 1;
+        pixels = (unsigned char*)realloc(pixels, 3*size);
+        occupancy = (unsigned short*)realloc(occupancy, size*sizeof(unsigned short));
+        memset(occupancy, 0, size*sizeof(unsigned short));
+        occupancy_epoch = 0;
+        this->width = width;
+        this->height = height;
+        if(width > 0 && height > 0) {
+            image = wxImage(width, height, pixels, true);
+            image.SetMaskColour(RASTER_KEY, RASTER_KEY, RASTER_KEY);
+        }
+    }
+    keep = keep && !resized && left == this->left && top == this->top;
+    this->left = left;
+    this->top = top;
+    num_commands = 0;
+    num_recorded = 0;
+    if(!keep) {
+        if(deferred) {
+            clear_pending = true;
+        } else {
+            memset(pixels, RASTER_KEY, 3*width*height);
+        }
+        drawn = false;
+        occupancy_valid = false;
+    }
+    return keep;
+}
+
+void PlotRaster::end(wxDC* dc) {
+    /**
+    *   Copies everything drawn since begin() onto a DC
+    */
+    if(!drawn || width == 0 || height == 0) {
+        return;
+    }
+    wxBitmap bitmap(image);
+    dc->DrawBitmap(bitmap, left, top, true);
+}
+
+void PlotRaster::setColour(const wxColour& colour) {
+    /**
+    *   Sets the colour lines and points are drawn in.  A colour that
+    *   would be taken for the key is moved to black.
+    */
+    red = colour.Red();
+    green = colour.Green();
+    blue = colour.Blue();
+    if(red == RASTER_KEY && green == RASTER_KEY && blue == RASTER_KEY) {
+        red = green = blue = 0;
+    }
+}
+
+wxPoint* PlotRaster::getPoints(int num_points) {
+    /**
+    *   Returns an array of at least num_points points for the caller to
+    *   fill in and draw.  It is kept between frames.
+    */
+    if(num_points > allocated_points) {
+        points = (wxPoint*)realloc(points, num_points*sizeof(wxPoint));
+        allocated_points = num_points;
+    }
+    return points;
+}
+
+void PlotRaster::drawLines(const wxPoint* points, int num_points) {
+    /**
+    *   Draws lines joining the points in order, like wxDC::DrawLines.
+    *   Only when the points reach outside the area is each segment
+    *   clipped, so a trace that fits is drawn with no checks at all.
+    */
+    if(deferred) {
+        record(RASTER_LINES, points, NULL, num_points, 0, NULL, NULL);
+        return;
+    }
+    bool inside;
+    if(!findBounds(points, num_points, inside)) {
+        return;
+    }
+
+    for(int i = 1; i < num_points; i++) {
+        int x0 = points[i-1].x - left;
+        int y0 = points[i-1].y - top;
+        int x1 = points[i].x - left;
+        int y1 = points[i].y - top;
+        if(inside || clipSegment(x0, y0, x1, y1, width, height)) {
+            drawSegment(x0, y0, x1, y1);
+        }
+    }
+    occupancy_valid = false;
+    drawn = true;
+}
+
+void PlotRaster::drawShadedLines(const wxPoint* points, const unsigned char* shades, int num_points,
+                                 const unsigned char* colour_map) {
+    /**
+    *   Draws lines joining the points in order like drawLines(), each
+    *   segment in its own colour.  The shade of the point a segment starts
+    *   at picks one of 256 RGB colours from the colour map.
+    */
+    if(deferred) {
+        record(RASTER_SHADED_LINES, points, shades, num_points, 0, colour_map, NULL);
+        return;
+    }
+    bool inside;
+    if(!findBounds(points, num_points, inside)) {
+        return;
+    }
+
+    for(int i = 1; i < num_points; i++) {
+        int x0 = points[i-1].x - left;
+        int y0 = points[i-1].y - top;
+        int x1 = points[i].x - left;
+        int y1 = points[i].y - top;
+        if(inside || clipSegment(x0, y0, x1, y1, width, height)) {
+            const unsigned char* colour = colour_map + 3*shades[i-1];
+            red = colour[0];
+            green = colour[1];
+            blue = colour[2];
+            drawSegment(x0, y0, x1, y1);
+        }
+    }
+    occupancy_valid = false;
+    drawn = true;
+}
+
+bool PlotRaster::findBounds(const wxPoint* points, int num_points, bool& inside) {
+    /**
+    *   Finds the bounds of a line through the points.  Returns false if
+    *   there is nothing of it to draw, otherwise sets inside if it lies
+    *   wholly within the area and needs no clipping.
+    */
+    if(num_points < 2 || width == 0 || height == 0) {
+        return false;
+    }
+    int min_x = points[0].x, max_x = points[0].x;
+    int min_y = points[0].y, max_y = points[0].y;
+    for(int i = 1; i < num_points; i++) {
+        if(points[i].x < min_x) min_x = points[i].x;
+        if(points[i].x > max_x) max_x = points[i].x;
+        if(points[i].y < min_y) min_y = points[i].y;
+        if(points[i].y > max_y) max_y = points[i].y;
+    }
+    min_x -= left; max_x -= left;
+    min_y -= top; max_y -= top;
+    if(max_x < 0 || min_x >= width || max_y < 0 || min_y >= height) {
+        return false;
+    }
+    inside = min_x >= 0 && max_x < width && min_y >= 0 && max_y < height;
+    return true;
+}
+
+void PlotRaster::drawPoints(const wxPoint* points, int num_points, int radius) {
+    /**
+    *   Draws a disc of the given radius at each point, or a single pixel
+    *   for a radius of 0.
+    *
+    *   Discs are stamped from a sprite made once for the radius and
+    *   colour, a row at a time.  A point is skipped if the same sprite has
+    *   already been stamped at its pixel since anything else was drawn, as
+    *   it would not change anything.  Thousands of peaks of a periodic
+    *   orbit land on the same few pixels, so most of them cost a single
+    *   check.
+    */
+    if(deferred) {
+        record(RASTER_POINTS, points, NULL, num_points, radius, NULL, NULL);
+        return;
+    }
+    if(width == 0 || height == 0) {
+        return;
+    }
+    if(radius <= 0 || radius > SPRITE_MAX_RADIUS) {
+        for(int i = 0; i < num_points; i++) {
+            int x = points[i].x - left;
+            int y = points[i].y - top;
+            if(radius > 0) {
+                drawDisc(x, y, radius);
+            } else if(x >= 0 && x < width && y >= 0 && y < height) {
+                unsigned char* p = pixels + 3*(y*width + x);
+                p[0] = red;
+                p[1] = green;
+                p[2] = blue;
+            }
+        }
+        occupancy_valid = false;
+        drawn = true;
+        return;
+    }
+
+    makeSprite(radius);
+    if(!occupancy_valid) {
+        if(++occupancy_epoch == 0) {
+            memset(occupancy, 0, width*height*sizeof(unsigned short));
+            occupancy_epoch = 1;
+        }
+        occupancy_valid = true;
+    }
+    for(int i = 0; i < num_points; i++) {
+        int x = points[i].x - left;
+        int y = points[i].y - top;
+        if(x < 0 || x >= width || y < 0 || y >= height) {
+            // Part of the disc may still reach into the area
+            drawDisc(x, y, radius);
+            continue;
+        }
+        unsigned short* occupied = occupancy + y*width + x;
+        if(*occupied == occupancy_epoch) {
+            continue;
+        }
+        *occupied = occupancy_epoch;
+        if(x >= radius && x < width - radius && y >= radius && y < height - radius) {
+            stampSprite(x, y);
+        } else {
+            drawDisc(x, y, radius);
+        }
+    }
+    drawn = true;
+}
+
+void PlotRaster::drawLevels(const unsigned short* levels, const unsigned char* colour_map) {
+    /**
+    *   Colours every pixel of the area from a map of levels the same size
+    *   as the area.  The top 8 bits of a level pick one of 256 RGB colours
+    *   from the colour map.  Pixels at the lowest level are left alone.
+    */
+    if(deferred) {
+        record(RASTER_LEVELS, NULL, NULL, 0, 0, colour_map, levels);
+        return;
+    }
+    if(width == 0 || height == 0) {
+        return;
+    }
+    unsigned char* p = pixels;
+    int num_pixels = width*height;
+    for(int i = 0; i < num_pixels; i++, p += 3) {
+        int level = levels[i] >> 8;
+        if(level == 0) {
+            continue;
+        }
+        const unsigned char* colour = colour_map + 3*level;
+        p[0] = colour[0];
+        p[1] = colour[1];
+        p[2] = colour[2];
+    }
+    occupancy_valid = false;
+    drawn = true;
+}
+
+void PlotRaster::setDeferred(bool deferred) {
+    /**
+    *   Chooses whether drawing is carried out straight away or recorded
+    *   for render().  Change it between frames, not during one.
+    */
+    this->deferred = deferred;
+}
+
+void PlotRaster::render() {
+    /**
+    *   Clears the buffer and carries out the drawing recorded since
+    *   begin(), ready for end()
+    */
+    if(clear_pending) {
+        memset(pixels, RASTER_KEY, 3*width*height);
+        clear_pending = false;
+    }
+    bool was_deferred = deferred;
+    deferred = false;
+    for(int i = 0; i < num_commands; i++) {
+        const Command& command = commands[i];
+        red = command.red;
+        green = command.green;
+        blue = command.blue;
+        switch(command.type) {
+        case RASTER_LINES:
+            drawLines(recorded_points + command.first, command.num_points);
+            break;
+        case RASTER_SHADED_LINES:
+            drawShadedLines(recorded_points + command.first, recorded_shades + command.first,
+                            command.num_points, command.colour_map);
+            break;
+        case RASTER_POINTS:
+            drawPoints(recorded_points + command.first, command.num_points, command.radius);
+            break;
+        case RASTER_LEVELS:
+            drawLevels(command.levels, command.colour_map);
+            break;
+        }
+    }
+    deferred = was_deferred;
+    num_commands = 0;
+    num_recorded = 0;
+}
+
+void PlotRaster::record(int type, const wxPoint* points, const unsigned char* shades, int num_points,
+                        int radius, const unsigned char* colour_map, const unsigned short* levels) {
+    /**
+    *   Adds some drawing to the list for render(), along with the colour
+    *   it is to be drawn in
+    */
+    if(num_commands == allocated_commands) {
+        allocated_commands = allocated_commands ? 2*allocated_commands : 8;
+        commands = (Command*)realloc(commands, allocated_commands*sizeof(Command));
+    }
+    if(num_recorded + num_points > allocated_recorded) {
+        allocated_recorded = num_recorded + num_points;
+        recorded_points = (wxPoint*)realloc(recorded_points, allocated_recorded*sizeof(wxPoint));
+        recorded_shades = (unsigned char*)realloc(recorded_shades, allocated_recorded);
+    }
+    Command& command = commands[num_commands++];
+    command.type = type;
+    command.first = num_recorded;
+    command.num_points = num_points;
+    command.radius = radius;
+    command.red = red;
+    command.green = green;
+    command.blue = blue;
+    command.colour_map = colour_map;
+    command.levels = levels;
+    if(num_points > 0) {
+        memcpy(recorded_points + num_recorded, points, num_points*sizeof(wxPoint));
+        if(shades != NULL) {
+            memcpy(recorded_shades + num_recorded, shades, num_points);
+        }
+        num_recorded += num_points;
+    }
+}
+
+void PlotRaster::makeSprite(int radius) {
+    /**
+    *   Makes the sprite for a disc of the given radius in the current
+    *   colour, unless it is the one already made
+    */
+    if(radius == sprite_radius && red == sprite_red && green == sprite_green && blue == sprite_blue) {
+        return;
+    }
+    sprite_radius = radius;
+    sprite_red = red;
+    sprite_green = green;
+    sprite_blue = blue;
+    for(int dy = -radius; dy <= radius; dy++) {
+        sprite_half[dy + radius] = (int)sqrt(float(radius*radius - dy*dy));
+    }
+    for(int i = 0; i < 2*radius + 1; i++) {
+        sprite_row[3*i] = red;
+        sprite_row[3*i + 1] = green;
+        sprite_row[3*i + 2] = blue;
+    }
+    occupancy_valid = false;
+}
+
+void PlotRaster::stampSprite(int x, int y) {
+    /**
+    *   Copies the sprite into the buffer centred on a point at least its
+    *   radius inside the area
+    */
+    unsigned char* p = pixels + 3*((y - sprite_radius)*width + x);
+    for(int row = 0; row <= 2*sprite_radius; row++, p += 3*width) {
+        int half = sprite_half[row];
+        memcpy(p - 3*half, sprite_row, 3*(2*half + 1));
+    }
+}
+
+void PlotRaster::drawSegment(int x0, int y0, int x1, int y1) {
+    /**
+    *   Draws a segment that lies inside the area with Bresenham's
+    *   algorithm, stepping through the buffer by address
+    */
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int step_x = x1 > x0 ? 3 : -3;
+    int step_y = y1 > y0 ? 3*width : -3*width;
+
+    int steps, minor, step_major, step_minor;
+    if(dx >= dy) {
+        steps = dx;
+        minor = dy;
+        step_major = step_x;
+        step_minor = step_y;
+    } else {
+        steps = dy;
+        minor = dx;
+        step_major = step_y;
+        step_minor = step_x;
+    }
+
+    unsigned char* p = pixels + 3*(y0*width + x0);
+    int error = steps/2;
+    for(int i = 0; i <= steps; i++) {
+        p[0] = red;
+        p[1] = green;
+        p[2] = blue;
+        p += step_major;
+        error -= minor;
+        if(error < 0) {
+            p += step_minor;
+            error += steps;
+        }
+    }
+}
+
+bool PlotRaster::clipSegment(int& x0, int& y0, int& x1, int& y1, int width, int height) {
+    /**
+    *   Clips a segment to an area of width by height pixels with the
+    *   Liang-Barsky algorithm.  Returns false if none of it is inside.
+    */
+    float t0 = 0, t1 = 1;
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float p[4] = { -dx, dx, -dy, dy };
+    float q[4] = { float(x0), float(width - 1 - x0), float(y0), float(height - 1 - y0) };
+
+    for(int k = 0; k < 4; k++) {
+        if(p[k] == 0) {
+            if(q[k] < 0) {
+                return false;
+            }
+        } else {
+            float t = q[k]/p[k];
+            if(p[k] < 0) {
+                if(t > t1) return false;
+                if(t > t0) t0 = t;
+            } else {
+                if(t < t0) return false;
+                if(t < t1) t1 = t;
+            }
+        }
+    }
+
+    int start_x = x0, start_y = y0;
+    x0 = (int)floor(start_x + t0*dx + 0.5f);
+    y0 = (int)floor(start_y + t0*dy + 0.5f);
+    x1 = (int)floor(start_x + t1*dx + 0.5f);
+    y1 = (int)floor(start_y + t1*dy + 0.5f);
+
+    // Rounding can only ever push a point out by a pixel
+    if(x0 < 0) x0 = 0;
+    if(x0 >= width) x0 = width - 1;
+    if(x1 < 0) x1 = 0;
+    if(x1 >= width) x1 = width - 1;
+    if(y0 < 0) y0 = 0;
+    if(y0 >= height) y0 = height - 1;
+    if(y1 < 0) y1 = 0;
+    if(y1 >= height) y1 = height - 1;
+    return true;
+}
+
+void PlotRaster::drawDisc(int x, int y, int radius) {
+    /**
+    *   Fills a disc one row at a time, clipped to the area
+    */
+    for(int dy = -radius; dy <= radius; dy++) {
+        int row = y + dy;
+        if(row < 0 || row >= height) {
+            continue;
+        }
+        int half = (int)sqrt(float(radius*radius - dy*dy));
+        int start = x - half;
+        int end = x + half;
+        if(start < 0) start = 0;
+        if(end >= width) end = width - 1;
+        unsigned char* p = pixels + 3*(row*width + start);
+        for(int column = start; column <= end; column++) {
+            p[0] = red;
+            p[1] = green;
+            p[2] = blue;
+            p += 3;
+        }
+    }
+}
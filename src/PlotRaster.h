@@ -0,0 +1,100 @@
+/**
+ * \file PlotRaster.h
+ * \brief Headers for PlotRaster.cpp
+ */
+
+#ifndef PLOTRASTER_H
+#define PLOTRASTER_H
+
+#include <wx/wx.h>
+#include <wx/image.h>
+
+// Largest radius drawPoints() keeps a sprite for, larger discs are filled
+// a row at a time
+#define SPRITE_MAX_RADIUS 8
+
+class PlotRaster
+{
+    public:
+        PlotRaster();
+        ~PlotRaster();
+        bool begin(int left, int top, int width, int height, bool keep = false);
+        void end(wxDC* dc);
+        void setColour(const wxColour& colour);
+        wxPoint* getPoints(int num_points);
+        void drawLines(const wxPoint* points, int num_points);
+        void drawShadedLines(const wxPoint* points, const unsigned char* shades, int num_points,
+                             const unsigned char* colour_map);
+        void drawPoints(const wxPoint* points, int num_points, int radius);
+        void drawLevels(const unsigned short* levels, const unsigned char* colour_map);
+        void setDeferred(bool deferred);
+        void render();
+        static bool clipSegment(int& x0, int& y0, int& x1, int& y1, int width, int height);
+
+    private:
+        void record(int type, const wxPoint* points, const unsigned char* shades, int num_points,
+                    int radius, const unsigned char* colour_map, const unsigned short* levels);
+        bool findBounds(const wxPoint* points, int num_points, bool& inside);
+        void drawSegment(int x0, int y0, int x1, int y1);
+        void drawDisc(int x, int y, int radius);
+        void makeSprite(int radius);
+        void stampSprite(int x, int y);
+
+        // RGB pixels of the area drawn on, shared with image
+        unsigned char* pixels;
+        wxImage image;
+        int left;
+        int top;
+        int width;
+        int height;
+        bool drawn;
+        bool clear_pending;
+
+        // Colour being drawn in
+        unsigned char red;
+        unsigned char green;
+        unsigned char blue;
+
+        // Disc stamped at each point by drawPoints(), made again when the
+        // radius or colour changes.  Each row is the middle of sprite_row.
+        int sprite_radius;
+        unsigned char sprite_red;
+        unsigned char sprite_green;
+        unsigned char sprite_blue;
+        int sprite_half[2*SPRITE_MAX_RADIUS + 1];
+        unsigned char sprite_row[3*(2*SPRITE_MAX_RADIUS + 1)];
+
+        // Pixels the current sprite has been stamped on, marked with the
+        // epoch they were stamped in.  Moving to a new epoch empties it.
+        unsigned short* occupancy;
+        unsigned short occupancy_epoch;
+        bool occupancy_valid;
+
+        // Points the caller fills in before drawing them
+        wxPoint* points;
+        int allocated_points;
+
+        // Drawing recorded while deferred, for render() to carry out later.
+        // Points and shades are copied, levels and colour maps are not.
+        struct Command {
+            int type;
+            int first;
+            int num_points;
+            int radius;
+            unsigned char red;
+            unsigned char green;
+            unsigned char blue;
+            const unsigned char* colour_map;
+            const unsigned short* levels;
+        };
+        bool deferred;
+        Command* commands;
+        int num_commands;
+        int allocated_commands;
+        wxPoint* recorded_points;
+        unsigned char* recorded_shades;
+        int num_recorded;
+        int allocated_recorded;
+};
+
+#endif // PLOTRASTER_H
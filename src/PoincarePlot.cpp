@@ -0,0 +1,221 @@
+/**
+ * \file PoincarePlot.cpp
+ * \brief Implements class for plotting Poincare sections
+ */
+
+#include "PoincarePlot.h"
+#include "ChaosSettings.h"
+#include "ChaosCapture.h"
+#include "ChaosCalibration.h"
+
+// Names of the capture channels used in the titles
+static const wxChar* channel_names[] = { wxT("X"), wxT("X'"), wxT("X''") };
+
+PoincarePlot::PoincarePlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name) 
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the Poincare section plot.
+    *   The section is taken through a plane where one of the channels is
+    *   held at a fixed level, and the crossings are plotted using the
+    *   other two channels.  Return maps of the peaks are a special case
+    *   of this where the plane is X' = 0.
+    */
+    side_gutter_size = 15;
+    bottom_gutter_size = 20;
+    square = true;
+    zoomable_graph = true;
+    old_mdac = 0;
+    drawn_result = 0;
+    setPlane(ChaosCapture::X1, 512);
+    zoomDefault();
+}
+
+PoincarePlot::~PoincarePlot() {
+    /**
+    *   Deconstructor for the PoincarePlot class
+    */
+}
+
+void PoincarePlot::updateTitles() {
+    /**
+    *   Sets the title and subtitle for the current plane and units
+    */
+    int u = (plane_axis == ChaosCapture::X1) ? ChaosCapture::X2 : ChaosCapture::X1;
+    int v = (plane_axis == ChaosCapture::X3) ? ChaosCapture::X2 : ChaosCapture::X3;
+    
+    graph_title = wxT("Poincare Section");
+    if(ChaosSettings::YAxisLabels != ChaosSettings::Y_AXIS_ADC) {
+        graph_subtitle = wxString::Format(wxT("%s (V) vs. %s (V) at %s = %.2f V"),
+                                          channel_names[v], channel_names[u],
+                                          channel_names[plane_axis],
+                                          ChaosCalibration::toUnits(plane_axis, plane_level));
+    } else {
+        graph_subtitle = wxString::Format(wxT("%s (ADC) vs. %s (ADC) at %s = %d"),
+                                          channel_names[v], channel_names[u],
+                                          channel_names[plane_axis], plane_level);
+    }
+}
+
+void PoincarePlot::drawPlot() {
+    /**
+    *   Main drawing function for the PoincarePlot class.
+    *
+    *   Hands any new capture to the worker thread and draws the crossings
+    *   it has accumulated so far.
+    */
+    int x,y;
+    unsigned int hits;
+    
+    // Start again if the circuit has changed
+    if(old_mdac != device_mdac_value) {
+        section.clear();
+        old_mdac = device_mdac_value;
+    }
+    
+    section.update();
+    
+    startDraw();
+    updateTitles();
+    
+    float x_min, x_max;
+    float y_min, y_max;
+    int u = (plane_axis == ChaosCapture::X1) ? ChaosCapture::X2 : ChaosCapture::X1;
+    int v = (plane_axis == ChaosCapture::X3) ? ChaosCapture::X2 : ChaosCapture::X3;
+    y_min = ChaosCalibration::toUnits(v, smallest_y_value);
+    y_max = ChaosCalibration::toUnits(v, largest_y_value);
+    x_min = ChaosCalibration::toUnits(u, smallest_x_value);
+    x_max = ChaosCalibration::toUnits(u, largest_x_value);
+    
+    drawYAxis(y_min, y_max, (y_max-y_min)/3.0);
+    drawXAxis(x_min, x_max, (x_max-x_min)/3.0);
+
+    // Draw the crossings that are inside the window in blue
+    section.lock();
+    drawn_result = section.getResultVersion();
+    ReturnMapAccumulator* accumulator = section.getAccumulator();
+    unsigned int max_hits = accumulator->getMaxHits();
+    wxPoint* points = raster.getPoints(accumulator->getNumPoints());
+    unsigned char* levels = getPointLevels(accumulator->getNumPoints());
+    int num_points = 0;
+    for(int i = 0; i < accumulator->getNumPoints(); i++) {
+        accumulator->getPoint(i, &x, &y, &hits);
+        if(x > smallest_x_value && x < largest_x_value &&
+           y > smallest_y_value && y < largest_y_value) {
+            points[num_points] = wxPoint(valueToX(x), valueToY(y));
+            if(density_map) {
+                levels[num_points] = densityLevel(hits, max_hits);
+            }
+            num_points++;
+        }
+    }
+    section.unlock();
+    
+    startRaster();
+    if(density_map) {
+        drawDensityPoints(points, levels, num_points);
+    } else {
+        raster.setColour(*wxBLUE);
+        drawPoints(points, num_points);
+    }
+    endRaster();
+    
+    endDraw();
+}
+
+bool PoincarePlot::needsRedraw() {
+    /**
+    *   The crossings are accumulated on a worker thread, so the plot is
+    *   also drawn again when the worker has changed them since the last
+    *   frame.  Otherwise a new plane would stay empty while paused.
+    */
+    if(ChaosPlot::needsRedraw()) {
+        return true;
+    }
+    section.lock();
+    bool changed = section.getResultVersion() != drawn_result;
+    section.unlock();
+    return changed;
+}
+
+void PoincarePlot::setPlane(int axis, int level) {
+    /**
+    *   Sets the plane to <axis> = level, where axis is one of the capture
+    *   channels and level is in ADC units.  Crossings are counted when the
+    *   channel goes up through the level.
+    */
+    plane_axis = axis;
+    plane_level = level;
+    
+    float normal[3] = { 0, 0, 0 };
+    normal[axis] = 1;
+    section.setPlane(normal[0], normal[1], normal[2], level);
+    
+    // Plot the two remaining channels, in order
+    int u = (axis == ChaosCapture::X1) ? ChaosCapture::X2 : ChaosCapture::X1;
+    int v = (axis == ChaosCapture::X3) ? ChaosCapture::X2 : ChaosCapture::X3;
+    section.setPlaneCoordinates(u, v);
+    invalidate();
+}
+
+int PoincarePlot::getPlaneAxis() {
+    /**
+    *   Returns the channel held fixed by the plane
+    */
+    return plane_axis;
+}
+
+int PoincarePlot::getPlaneLevel() {
+    /**
+    *   Returns the level of the plane in ADC units
+    */
+    return plane_level;
+}
+
+int PoincarePlot::xToValue(int x) {
+    /**
+    *   Converts an x point on the graph to an ADC value.
+    *   This is a very important function that is used by the parent class
+    *   (ChaosPlot) for zooming.
+    */
+    if ( graph_width == 0) {
+        return 1;
+    }
+    return ((x - side_gutter_size)*(largest_x_value - smallest_x_value))/graph_width + smallest_x_value;
+}
+
+int PoincarePlot::valueToX(int value) {
+    /**
+    *   Converts an ADC value to an X coordinate on the graph.
+    */
+    return (((value - smallest_x_value)*graph_width)/(largest_x_value - smallest_x_value)) + side_gutter_size;
+}
+
+int PoincarePlot::yToValue(int y) {
+    /**
+    *   Converts a y point on the graph to an ADC value.
+    *   This is a very important function that is used by the parent class
+    *   (ChaosPlot) for zooming.
+    */
+    if ( graph_height == 0) {
+        return 1;
+    }
+    return (((top_gutter_size + graph_height) - y)*(largest_y_value - smallest_y_value))/graph_height + smallest_y_value;
+}
+
+int PoincarePlot::valueToY(int value) {
+    /**
+    *   Converts an ADC value to a Y coordinate on the graph.
+    */
+    return (graph_height-((value-smallest_y_value)*graph_height)/(largest_y_value - smallest_y_value)) + top_gutter_size;
+}
+
+void PoincarePlot::zoomDefault() {
+    /**
+    *   Resets the zoom to the default values.
+    */
+    largest_x_value = 1024;
+    smallest_x_value = 0;
+    smallest_y_value = 0;
+    largest_y_value = 1024;
+}
@@ -1,41 +1,47 @@
 /**
- * \file Return2Plot.h
- * \brief Headers for Return2Plot.cpp
+ * \file PoincarePlot.h
+ * \brief Headers for PoincarePlot.cpp
  */
- 
-#ifndef RETURN2PLOT_H
-#define RETURN2PLOT_H
+
+#ifndef POINCAREPLOT_H
+#define POINCAREPLOT_H
 
 #include "ChaosPlot.h"
 #include "libchaos.h"
+#include "PoincareSection.h"
 
-#define NUM_POINTS 600
-class Return2Plot : public ChaosPlot
+class PoincarePlot : public ChaosPlot
 {
     public:
         // class constructor
-        Return2Plot(wxWindow* parent, 
+        PoincarePlot(wxWindow* parent, 
                        wxWindowID id = wxID_ANY, 
                        const wxPoint& pos = wxDefaultPosition, 
                        const wxSize& size = wxDefaultSize, 
                        long style = wxTAB_TRAVERSAL, 
                        const wxString& name = wxT("panel"));
         // class destructor
-        ~Return2Plot();
+        ~PoincarePlot();
         void drawPlot();
+        bool needsRedraw();
+        void setPlane(int axis, int level);
+        int getPlaneAxis();
+        int getPlaneLevel();
     private:
         int xToValue(int x);
         int yToValue(int y);
         int valueToX(int value);
         int valueToY(int value);
+        void zoomDefault();
+        void updateTitles();
         
         int old_mdac;
-        int old_x_range;
-        int old_y_range;
-        int points[NUM_POINTS][2];
-        int point_count;
+        int plane_axis;
+        int plane_level;
+        PoincareSection section;
         
-        void zoomDefault();
+        // Version of the crossings last drawn
+        unsigned int drawn_result;
 };
 
-#endif
+#endif // POINCAREPLOT_H
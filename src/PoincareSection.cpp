@@ -0,0 +1,290 @@
+/**
+ * \file PoincareSection.cpp
+ * \brief Finds the crossings of the trajectory with a plane in a worker thread
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "PoincareSection.h"
+#include "ChaosCapture.h"
+
+PoincareWorker::PoincareWorker(PoincareSection* section) 
+    : wxThread(wxTHREAD_JOINABLE) {
+    /**
+    *   Constructor for the worker thread
+    */
+    this->section = section;
+}
+
+wxThread::ExitCode PoincareWorker::Entry() {
+    /**
+    *   Main loop of the worker thread.  Sleeps until the GUI thread hands
+    *   over a capture, processes it and goes back to sleep.
+    */
+    while(section->waitForWork()) {
+        section->processCapture();
+    }
+    return 0;
+}
+
+PoincareSection::PoincareSection() 
+    : work_condition(work_mutex) {
+    /**
+    *   Constructor for the PoincareSection class.
+    *
+    *   A Poincare section is the set of points where the trajectory in
+    *   (X, X', X'') space crosses a plane in one direction.  Every capture
+    *   is handed to a worker thread which finds the crossings, interpolates
+    *   them between samples and accumulates them.  The default plane is
+    *   X = 512 with the points plotted in (X', X'').
+    */
+    stopping = false;
+    work_pending = false;
+    generation = ChaosCapture::getGeneration();
+    plane_version = 0;
+    result_version = 0;
+    
+    plane[0] = 1;
+    plane[1] = 0;
+    plane[2] = 0;
+    plane[3] = 512;
+    u_channel = ChaosCapture::X2;
+    v_channel = ChaosCapture::X3;
+    
+    for(int c = 0; c < 3; c++) {
+        pending[c] = NULL;
+        channels[c] = NULL;
+    }
+    pending_points = 0;
+    pending_allocated = 0;
+    channels_allocated = 0;
+    channel_points = 0;
+    distance = NULL;
+    crossing = NULL;
+    scratch_allocated = 0;
+    
+    worker = new PoincareWorker(this);
+    worker->Create();
+    worker->Run();
+}
+
+PoincareSection::~PoincareSection() {
+    /**
+    *   Destructor for the PoincareSection class.
+    *   Stops the worker thread before freeing anything it could be using.
+    */
+    work_mutex.Lock();
+    stopping = true;
+    work_condition.Signal();
+    work_mutex.Unlock();
+    
+    worker->Wait();
+    delete worker;
+    
+    for(int c = 0; c < 3; c++) {
+        free(pending[c]);
+        free(channels[c]);
+    }
+    free(distance);
+    free(crossing);
+}
+
+void PoincareSection::update() {
+    /**
+    *   Hands any capture that arrived since the last call to the worker.
+    *   Called from the GUI thread, this only copies the capture.
+    */
+    if(generation == ChaosCapture::getGeneration()) {
+        return;
+    }
+    generation = ChaosCapture::getGeneration();
+    
+    int points = ChaosCapture::getNumPoints();
+    
+    work_mutex.Lock();
+    if(points > pending_allocated) {
+        for(int c = 0; c < 3; c++) {
+            pending[c] = (short*)realloc(pending[c], points*sizeof(short));
+        }
+        pending_allocated = points;
+    }
+    for(int c = 0; c < 3; c++) {
+        memcpy(pending[c], ChaosCapture::getChannel(c), points*sizeof(short));
+    }
+    pending_points = points;
+    work_pending = true;
+    work_condition.Signal();
+    work_mutex.Unlock();
+}
+
+bool PoincareSection::waitForWork() {
+    /**
+    *   Called by the worker.  Blocks until there is a capture to process
+    *   and swaps it into the worker's arrays.  Returns false when the
+    *   worker should exit.
+    */
+    wxMutexLocker locker(work_mutex);
+    while(!work_pending && !stopping) {
+        work_condition.Wait();
+    }
+    if(stopping) {
+        return false;
+    }
+    
+    // Swap the pending capture with the worker's arrays
+    for(int c = 0; c < 3; c++) {
+        short* tmp = channels[c];
+        channels[c] = pending[c];
+        pending[c] = tmp;
+    }
+    int tmp_allocated = channels_allocated;
+    channels_allocated = pending_allocated;
+    pending_allocated = tmp_allocated;
+    channel_points = pending_points;
+    
+    work_pending = false;
+    return true;
+}
+
+void PoincareSection::processCapture() {
+    /**
+    *   Called by the worker.  Makes sure the scratch arrays are big
+    *   enough for the capture and finds its crossings.
+    */
+    int num_points = channel_points;
+    
+    if(num_points > scratch_allocated) {
+        distance = (float*)realloc(distance, num_points*sizeof(float));
+        crossing = (unsigned char*)realloc(crossing, num_points);
+        scratch_allocated = num_points;
+    }
+    
+    findCrossings(num_points);
+}
+
+void PoincareSection::findCrossings(int num_points) {
+    /**
+    *   Finds the points where the trajectory crosses the plane going from
+    *   the negative to the positive side.
+    *
+    *   The signed distance to the plane and the crossing flags are computed
+    *   in two straight passes over the contiguous channel arrays without
+    *   any branches so the compiler can vectorize them.  Crossings are rare
+    *   so the final pass that interpolates them only does real work a few
+    *   times per capture.
+    */
+    // Take a copy of the plane so that it may be changed while we work
+    work_mutex.Lock();
+    float a = plane[0];
+    float b = plane[1];
+    float c = plane[2];
+    float d = plane[3];
+    int u = u_channel;
+    int v = v_channel;
+    unsigned int version = plane_version;
+    work_mutex.Unlock();
+    
+    const short* x1 = channels[ChaosCapture::X1];
+    const short* x2 = channels[ChaosCapture::X2];
+    const short* x3 = channels[ChaosCapture::X3];
+    
+    // Signed distance from the plane
+    for(int i = 0; i < num_points; i++) {
+        distance[i] = a*x1[i] + b*x2[i] + c*x3[i] - d;
+    }
+    
+    // Flag upward crossings between sample i-1 and i
+    crossing[0] = 0;
+    for(int i = 1; i < num_points; i++) {
+        crossing[i] = (distance[i-1] < 0) & (distance[i] >= 0);
+    }
+    
+    // Interpolate the crossings and accumulate them
+    const short* u_data = channels[u];
+    const short* v_data = channels[v];
+    
+    wxMutexLocker locker(result_mutex);
+    if(version != plane_version) {
+        // The plane changed while we were working
+        return;
+    }
+    for(int i = 1; i < num_points; i++) {
+        if(crossing[i]) {
+            float t = distance[i-1]/(distance[i-1] - distance[i]);
+            int pu = (int)(u_data[i-1] + t*(u_data[i] - u_data[i-1]) + 0.5);
+            int pv = (int)(v_data[i-1] + t*(v_data[i] - v_data[i-1]) + 0.5);
+            accumulator.addPoint(pu, pv);
+        }
+    }
+    result_version++;
+}
+
+void PoincareSection::clear() {
+    /**
+    *   Throws away the accumulated crossings.  Any capture the worker is
+    *   currently processing is dropped as well.
+    */
+    work_mutex.Lock();
+    result_mutex.Lock();
+    plane_version++;
+    result_version++;
+    accumulator.clear();
+    result_mutex.Unlock();
+    work_mutex.Unlock();
+}
+
+void PoincareSection::setPlane(float a, float b, float c, float d) {
+    /**
+    *   Sets the plane a*X + b*X' + c*X'' = d (ADC units) and clears the
+    *   accumulated crossings.
+    */
+    work_mutex.Lock();
+    plane[0] = a;
+    plane[1] = b;
+    plane[2] = c;
+    plane[3] = d;
+    work_mutex.Unlock();
+    clear();
+}
+
+void PoincareSection::setPlaneCoordinates(int u_channel, int v_channel) {
+    /**
+    *   Sets the channels used as the horizontal and vertical coordinates
+    *   of the crossing points.
+    */
+    work_mutex.Lock();
+    this->u_channel = u_channel;
+    this->v_channel = v_channel;
+    work_mutex.Unlock();
+    clear();
+}
+
+void PoincareSection::lock() {
+    /**
+    *   Locks the accumulated crossings so that they can be read
+    */
+    result_mutex.Lock();
+}
+
+void PoincareSection::unlock() {
+    /**
+    *   Unlocks the accumulated crossings
+    */
+    result_mutex.Unlock();
+}
+
+ReturnMapAccumulator* PoincareSection::getAccumulator() {
+    /**
+    *   Returns the accumulated crossings.  Must be called between lock()
+    *   and unlock().
+    */
+    return &accumulator;
+}
+
+unsigned int PoincareSection::getResultVersion() {
+    /**
+    *   Returns a number that changes every time the accumulated crossings
+    *   change.  Must be called between lock() and unlock().
+    */
+    return result_version;
+}
@@ -0,0 +1,88 @@
+/**
+ * \file PoincareSection.h
+ * \brief Headers for PoincareSection.cpp
+ */
+
+#ifndef POINCARESECTION_H
+#define POINCARESECTION_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include "ReturnMapAccumulator.h"
+
+class PoincareSection;
+
+class PoincareWorker : public wxThread
+{
+    /**
+    *   Thread that finds plane crossings for a PoincareSection so that the
+    *   work stays off of the GUI thread.
+    */
+    public:
+        PoincareWorker(PoincareSection* section);
+    protected:
+        ExitCode Entry();
+    private:
+        PoincareSection* section;
+};
+
+class PoincareSection
+{
+    public:
+        // class constructor
+        PoincareSection();
+        // class destructor
+        ~PoincareSection();
+        void update();
+        void clear();
+        void setPlane(float a, float b, float c, float d);
+        void setPlaneCoordinates(int u_channel, int v_channel);
+        
+        // The accumulated crossings must be locked while they are read
+        void lock();
+        void unlock();
+        ReturnMapAccumulator* getAccumulator();
+        unsigned int getResultVersion();
+        
+    private:
+        friend class PoincareWorker;
+        bool waitForWork();
+        void processCapture();
+        void findCrossings(int num_points);
+    
+        PoincareWorker* worker;
+        wxMutex work_mutex;
+        wxCondition work_condition;
+        wxMutex result_mutex;
+        bool stopping;
+        bool work_pending;
+        unsigned int generation;
+        
+        // Plane a*X + b*X' + c*X'' = d and the channels used for its axes
+        float plane[4];
+        int u_channel;
+        int v_channel;
+        
+        // Changed whenever the plane changes so stale results are dropped
+        unsigned int plane_version;
+        
+        // Changed whenever the accumulated crossings change
+        unsigned int result_version;
+        
+        // Capture copied for the worker, one contiguous array per channel
+        short* pending[3];
+        int pending_points;
+        int pending_allocated;
+        
+        // Worker's own copy of the capture and its scratch space
+        short* channels[3];
+        int channels_allocated;
+        int channel_points;
+        float* distance;
+        unsigned char* crossing;
+        int scratch_allocated;
+        
+        ReturnMapAccumulator accumulator;
+};
+
+#endif // POINCARESECTION_H
@@ -0,0 +1,462 @@
+/**
+ * \file RecurrenceMatrix.cpp
+ * \brief Computes the recurrence matrix of a capture
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "RecurrenceMatrix.h"
+#include "ChaosCapture.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Rows of the matrix handed to the pool per job
+#define ROWS_PER_JOB 32
+
+// Columns are done in blocks of 32 words (1024 points) so that the
+// points they are compared against stay in the cache for a whole band
+#define BLOCK_WORDS 32
+
+// Rows of the image handed to the pool per job
+#define PIXELS_PER_JOB 8
+
+// Coordinate used to pad the point arrays, far from every real point
+#define PADDING_VALUE 1e6f
+
+RecurrenceWorker::RecurrenceWorker(RecurrenceMatrix* matrix) 
+    : wxThread(wxTHREAD_JOINABLE) {
+    /**
+    *   Constructor for the worker thread
+    */
+    this->matrix = matrix;
+}
+
+wxThread::ExitCode RecurrenceWorker::Entry() {
+    /**
+    *   Main loop of the worker thread
+    */
+    while(matrix->waitForWork()) {
+        matrix->process();
+    }
+    return 0;
+}
+
+RecurrenceMatrix::RecurrenceMatrix() 
+    : work_condition(work_mutex) {
+    /**
+    *   Constructor for the RecurrenceMatrix class.
+    *
+    *   Entry (i,j) of the recurrence matrix is set when points i and j of
+    *   the capture are closer than the threshold in (X, X', X'') space.
+    *   The matrix is stored one bit per entry.  Each new capture is
+    *   handed to a worker thread which computes the matrix in bands of
+    *   rows on the worker pool and then shrinks it to an image the size
+    *   of the plot, where each pixel is the fraction of the entries it
+    *   covers that are set.
+    */
+    stopping = false;
+    generation = ChaosCapture::getGeneration();
+    
+    for(int c = 0; c < 3; c++) {
+        pending[c] = NULL;
+        points[c] = NULL;
+    }
+    pending_points = 0;
+    pending_allocated = 0;
+    capture_pending = false;
+    requested_threshold = RECURRENCE_DEFAULT_THRESHOLD;
+    requested_size = 0;
+    
+    num_points = 0;
+    points_allocated = 0;
+    threshold = RECURRENCE_DEFAULT_THRESHOLD;
+    
+    matrix = NULL;
+    words_per_row = 0;
+    matrix_allocated = 0;
+    thread_hits = NULL;
+    phase = PHASE_MATRIX;
+    
+    work_image = NULL;
+    work_size = 0;
+    work_allocated = 0;
+    image = NULL;
+    image_size = 0;
+    image_allocated = 0;
+    image_version = 0;
+    image_points = 0;
+    recurrence_rate = 0;
+    
+    worker = new RecurrenceWorker(this);
+    worker->Create();
+    worker->Run();
+}
+
+RecurrenceMatrix::~RecurrenceMatrix() {
+    /**
+    *   Destructor for the RecurrenceMatrix class.
+    *   Stops the worker thread before freeing anything it could be using.
+    */
+    work_mutex.Lock();
+    stopping = true;
+    work_condition.Signal();
+    work_mutex.Unlock();
+    
+    worker->Wait();
+    delete worker;
+    
+    for(int c = 0; c < 3; c++) {
+        free(pending[c]);
+        free(points[c]);
+    }
+    free(matrix);
+    free(thread_hits);
+    free(work_image);
+    free(image);
+}
+
+void RecurrenceMatrix::update() {
+    /**
+    *   Hands any capture that arrived since the last call to the worker.
+    *   If the worker is still busy the capture replaces the one waiting.
+    */
+    if(generation == ChaosCapture::getGeneration()) {
+        return;
+    }
+    generation = ChaosCapture::getGeneration();
+    
+    int count = ChaosCapture::getNumPoints();
+    
+    wxMutexLocker locker(work_mutex);
+    if(count > pending_allocated) {
+        for(int c = 0; c < 3; c++) {
+            pending[c] = (short*)realloc(pending[c], count*sizeof(short));
+        }
+        pending_allocated = count;
+    }
+    for(int c = 0; c < 3; c++) {
+        memcpy(pending[c], ChaosCapture::getChannel(c), count*sizeof(short));
+    }
+    pending_points = count;
+    capture_pending = true;
+    work_condition.Signal();
+}
+
+void RecurrenceMatrix::setThreshold(int threshold) {
+    /**
+    *   Sets the recurrence threshold in ADC counts
+    */
+    wxMutexLocker locker(work_mutex);
+    requested_threshold = threshold;
+    work_condition.Signal();
+}
+
+int RecurrenceMatrix::getThreshold() {
+    /**
+    *   Returns the recurrence threshold in ADC counts
+    */
+    wxMutexLocker locker(work_mutex);
+    return requested_threshold;
+}
+
+void RecurrenceMatrix::setImageSize(int size) {
+    /**
+    *   Sets the width and height of the image in pixels.  The matrix is
+    *   kept so only the image has to be redone when the plot is resized.
+    */
+    wxMutexLocker locker(work_mutex);
+    if(size != requested_size) {
+        requested_size = size;
+        work_condition.Signal();
+    }
+}
+
+bool RecurrenceMatrix::waitForWork() {
+    /**
+    *   Called by the worker.  Blocks until there is a new capture, a new
+    *   threshold or a new image size.  Returns false when the worker
+    *   should exit.
+    */
+    wxMutexLocker locker(work_mutex);
+    while(!stopping && !capture_pending && requested_threshold == threshold && 
+          (requested_size == work_size || num_points == 0)) {
+        work_condition.Wait();
+    }
+    return !stopping;
+}
+
+void RecurrenceMatrix::process() {
+    /**
+    *   Called by the worker.  Recomputes the matrix if the capture or the
+    *   threshold changed, then rebuilds the image and publishes it.
+    */
+    bool new_matrix = false;
+    
+    work_mutex.Lock();
+    if(capture_pending) {
+        num_points = pending_points;
+        words_per_row = (num_points + 31)/32;
+        
+        // Pad to whole words so the kernel never needs a partial load
+        int padded = words_per_row*32;
+        if(padded > points_allocated) {
+            for(int c = 0; c < 3; c++) {
+                points[c] = (float*)realloc(points[c], padded*sizeof(float));
+            }
+            points_allocated = padded;
+        }
+        for(int c = 0; c < 3; c++) {
+            for(int i = 0; i < num_points; i++) {
+                points[c][i] = pending[c][i];
+            }
+            for(int i = num_points; i < padded; i++) {
+                points[c][i] = PADDING_VALUE;
+            }
+        }
+        capture_pending = false;
+        new_matrix = true;
+    }
+    if(threshold != requested_threshold) {
+        threshold = requested_threshold;
+        new_matrix = true;
+    }
+    int size = requested_size;
+    work_mutex.Unlock();
+    
+    if(num_points == 0) {
+        return;
+    }
+    
+    int num_threads = ChaosWorkers::getNumThreads();
+    if(new_matrix) {
+        if(num_points*words_per_row > matrix_allocated) {
+            matrix_allocated = num_points*words_per_row;
+            matrix = (unsigned int*)realloc(matrix, matrix_allocated*sizeof(unsigned int));
+        }
+        thread_hits = (double*)realloc(thread_hits, num_threads*sizeof(double));
+        for(int t = 0; t < num_threads; t++) {
+            thread_hits[t] = 0;
+        }
+        
+        phase = PHASE_MATRIX;
+        ChaosWorkers::run(this, (num_points + ROWS_PER_JOB - 1)/ROWS_PER_JOB);
+    }
+    
+    if(size <= 0) {
+        return;
+    }
+    if(size*size > work_allocated) {
+        work_allocated = size*size;
+        work_image = (unsigned char*)realloc(work_image, work_allocated);
+    }
+    work_size = size;
+    
+    phase = PHASE_IMAGE;
+    ChaosWorkers::run(this, (size + PIXELS_PER_JOB - 1)/PIXELS_PER_JOB);
+    
+    double hits = 0;
+    for(int t = 0; t < num_threads; t++) {
+        hits += thread_hits[t];
+    }
+    
+    // Swap the finished image in for the one being shown
+    wxMutexLocker locker(result_mutex);
+    unsigned char* tmp = image;
+    image = work_image;
+    work_image = tmp;
+    int tmp_allocated = image_allocated;
+    image_allocated = work_allocated;
+    work_allocated = tmp_allocated;
+    image_size = size;
+    image_points = num_points;
+    recurrence_rate = hits/(double(num_points)*num_points);
+    image_version++;
+}
+
+void RecurrenceMatrix::runJob(int job, int thread) {
+    /**
+    *   Called on the worker pool.  Does one band of matrix rows or one
+    *   band of image rows depending on the phase.
+    */
+    if(phase == PHASE_MATRIX) {
+        int first = job*ROWS_PER_JOB;
+        int last = first + ROWS_PER_JOB;
+        if(last > num_points) last = num_points;
+        computeRows(first, last, thread);
+    } else {
+        int first = job*PIXELS_PER_JOB;
+        int last = first + PIXELS_PER_JOB;
+        if(last > work_size) last = work_size;
+        downsampleRows(first, last);
+    }
+}
+
+void RecurrenceMatrix::computeRows(int first_row, int last_row, int thread) {
+    /**
+    *   Computes rows first_row to last_row-1 of the matrix.
+    *
+    *   Each group of 4 columns is one vector compare of squared distances
+    *   against the squared threshold and the compare mask becomes 4 bits
+    *   of the row, so a word takes 8 compares and no branches.
+    */
+    const float* x1 = points[0];
+    const float* x2 = points[1];
+    const float* x3 = points[2];
+    float limit = float(threshold)*threshold;
+    
+    for(int block = 0; block < words_per_row; block += BLOCK_WORDS) {
+        int block_end = block + BLOCK_WORDS;
+        if(block_end > words_per_row) block_end = words_per_row;
+        
+        for(int i = first_row; i < last_row; i++) {
+            unsigned int* row = matrix + i*words_per_row;
+#ifdef __SSE2__
+            __m128 px = _mm_set1_ps(x1[i]);
+            __m128 py = _mm_set1_ps(x2[i]);
+            __m128 pz = _mm_set1_ps(x3[i]);
+            __m128 eps = _mm_set1_ps(limit);
+            for(int w = block; w < block_end; w++) {
+                unsigned int bits = 0;
+                for(int k = 0; k < 8; k++) {
+                    int j = w*32 + 4*k;
+                    __m128 dx = _mm_sub_ps(_mm_loadu_ps(x1 + j), px);
+                    __m128 dy = _mm_sub_ps(_mm_loadu_ps(x2 + j), py);
+                    __m128 dz = _mm_sub_ps(_mm_loadu_ps(x3 + j), pz);
+                    __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), 
+                                                      _mm_mul_ps(dy, dy)), 
+                                           _mm_mul_ps(dz, dz));
+                    bits |= (unsigned int)_mm_movemask_ps(_mm_cmple_ps(d2, eps)) << (4*k);
+                }
+                row[w] = bits;
+            }
+#else
+            float px = x1[i];
+            float py = x2[i];
+            float pz = x3[i];
+            for(int w = block; w < block_end; w++) {
+                unsigned int bits = 0;
+                for(int b = 0; b < 32; b++) {
+                    int j = w*32 + b;
+                    float dx = x1[j] - px;
+                    float dy = x2[j] - py;
+                    float dz = x3[j] - pz;
+                    bits |= (unsigned int)(dx*dx + dy*dy + dz*dz <= limit) << b;
+                }
+                row[w] = bits;
+            }
+#endif
+        }
+    }
+    
+    // Count the recurrences for the recurrence rate
+    unsigned int hits = 0;
+    for(int i = first_row; i < last_row; i++) {
+        const unsigned int* row = matrix + i*words_per_row;
+        for(int w = 0; w < words_per_row; w++) {
+            hits += __builtin_popcount(row[w]);
+        }
+    }
+    thread_hits[thread] += hits;
+}
+
+int RecurrenceMatrix::countBits(const unsigned int* row, int first, int last) {
+    /**
+    *   Counts the set bits in columns first to last-1 of a row
+    */
+    int first_word = first >> 5;
+    int last_word = (last - 1) >> 5;
+    unsigned int first_mask = ~0u << (first & 31);
+    unsigned int last_mask = ~0u >> (31 - ((last - 1) & 31));
+    
+    if(first_word == last_word) {
+        return __builtin_popcount(row[first_word] & first_mask & last_mask);
+    }
+    int count = __builtin_popcount(row[first_word] & first_mask);
+    for(int w = first_word + 1; w < last_word; w++) {
+        count += __builtin_popcount(row[w]);
+    }
+    return count + __builtin_popcount(row[last_word] & last_mask);
+}
+
+void RecurrenceMatrix::downsampleRows(int first_pixel, int last_pixel) {
+    /**
+    *   Fills image rows first_pixel to last_pixel-1.  Each pixel covers a
+    *   block of the matrix and is set to the square root of the fraction
+    *   of the block that is set, so sparse structure stays visible.  Time
+    *   runs upwards so row 0 of the matrix is the bottom of the image.
+    */
+    int size = work_size;
+    for(int py = first_pixel; py < last_pixel; py++) {
+        int r0 = (int)((long long)py*num_points/size);
+        int r1 = (int)((long long)(py + 1)*num_points/size);
+        if(r1 <= r0) r1 = r0 + 1;
+        
+        unsigned char* out = work_image + (size - 1 - py)*size;
+        for(int px = 0; px < size; px++) {
+            int c0 = (int)((long long)px*num_points/size);
+            int c1 = (int)((long long)(px + 1)*num_points/size);
+            if(c1 <= c0) c1 = c0 + 1;
+            
+            int count = 0;
+            for(int r = r0; r < r1; r++) {
+                count += countBits(matrix + r*words_per_row, c0, c1);
+            }
+            float fraction = float(count)/((r1 - r0)*(c1 - c0));
+            out[px] = (unsigned char)(255*sqrt(fraction) + 0.5);
+        }
+    }
+}
+
+void RecurrenceMatrix::lock() {
+    /**
+    *   Locks the image so it can be read
+    */
+    result_mutex.Lock();
+}
+
+void RecurrenceMatrix::unlock() {
+    /**
+    *   Unlocks the image
+    */
+    result_mutex.Unlock();
+}
+
+unsigned int RecurrenceMatrix::getImageVersion() {
+    /**
+    *   Returns a number that changes every time a new image is published.
+    *   Must be called between lock() and unlock().
+    */
+    return image_version;
+}
+
+int RecurrenceMatrix::getImageSize() {
+    /**
+    *   Returns the width and height of the image, zero if there is none yet
+    */
+    return image_size;
+}
+
+const unsigned char* RecurrenceMatrix::getImage() {
+    /**
+    *   Returns the image, one byte per pixel from 0 (no recurrences) to
+    *   255 (every entry set), top row first
+    */
+    return image;
+}
+
+int RecurrenceMatrix::getNumPoints() {
+    /**
+    *   Returns the number of points in the capture the image is of
+    */
+    return image_points;
+}
+
+float RecurrenceMatrix::getRecurrenceRate() {
+    /**
+    *   Returns the fraction of the matrix that is set
+    */
+    return recurrence_rate;
+}
@@ -0,0 +1,109 @@
+/**
+ * \file RecurrenceMatrix.h
+ * \brief Headers for RecurrenceMatrix.cpp
+ */
+
+#ifndef RECURRENCEMATRIX_H
+#define RECURRENCEMATRIX_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include "ChaosWorkers.h"
+
+// Default distance below which two points count as a recurrence, in ADC counts
+#define RECURRENCE_DEFAULT_THRESHOLD 30
+
+class RecurrenceMatrix;
+
+class RecurrenceWorker : public wxThread
+{
+    /**
+    *   Thread that recomputes the recurrence matrix and its image off of
+    *   the GUI thread.  The work itself is spread over the worker pool.
+    */
+    public:
+        RecurrenceWorker(RecurrenceMatrix* matrix);
+    protected:
+        ExitCode Entry();
+    private:
+        RecurrenceMatrix* matrix;
+};
+
+class RecurrenceMatrix : public ChaosTask
+{
+    public:
+        // class constructor
+        RecurrenceMatrix();
+        // class destructor
+        ~RecurrenceMatrix();
+        void update();
+        void setThreshold(int threshold);
+        int getThreshold();
+        void setImageSize(int size);
+        
+        // The image must be locked while it is read
+        void lock();
+        void unlock();
+        unsigned int getImageVersion();
+        int getImageSize();
+        const unsigned char* getImage();
+        int getNumPoints();
+        float getRecurrenceRate();
+        
+        void runJob(int job, int thread);
+        
+    private:
+        friend class RecurrenceWorker;
+        bool waitForWork();
+        void process();
+        void computeRows(int first_row, int last_row, int thread);
+        void downsampleRows(int first_pixel, int last_pixel);
+        int countBits(const unsigned int* row, int first, int last);
+        
+        RecurrenceWorker* worker;
+        wxMutex work_mutex;
+        wxCondition work_condition;
+        wxMutex result_mutex;
+        bool stopping;
+        unsigned int generation;
+        
+        // Requests from the GUI thread, guarded by work_mutex
+        short* pending[3];
+        int pending_points;
+        int pending_allocated;
+        bool capture_pending;
+        int requested_threshold;
+        int requested_size;
+        
+        // Trajectory as padded floats so the kernel can load 4 at a time
+        float* points[3];
+        int num_points;
+        int points_allocated;
+        int threshold;
+        
+        // Bit packed matrix, bit b of word w of a row is column 32*w + b
+        unsigned int* matrix;
+        int words_per_row;
+        int matrix_allocated;
+        double* thread_hits;
+        
+        // Which part of the work runJob() is doing
+        enum {
+            PHASE_MATRIX = 0,
+            PHASE_IMAGE
+        };
+        int phase;
+        
+        // Image being built and the one shown, one density byte per pixel
+        unsigned char* work_image;
+        int work_size;
+        int work_allocated;
+        unsigned char* image;
+        int image_size;
+        int image_allocated;
+        unsigned int image_version;
+        int image_points;
+        float recurrence_rate;
+};
+
+#endif // RECURRENCEMATRIX_H
@@ -0,0 +1,154 @@
+/**
+ * \file RecurrencePlot.cpp
+ * \brief Implements class for drawing recurrence plots
+ */
+
+#include "RecurrencePlot.h"
+#include "ChaosSettings.h"
+#include "ChaosCalibration.h"
+#include "ChaosCapture.h"
+
+RecurrencePlot::RecurrencePlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name) 
+                       : ChaosPlot(parent, id, pos, size, style, name) {
+    /**
+    *   Constructor for the recurrence plot.
+    *   Point (i,j) is dark when the trajectory at time i comes back within
+    *   the threshold of where it was at time j.  Periodic orbits show up
+    *   as diagonal lines, chaos as short broken ones and intermittency as
+    *   blocks.
+    */
+    side_gutter_size = 25;
+    bottom_gutter_size = 20;
+    square = true;
+    graph_title = wxT("Recurrence Plot");
+    image_version = 0;
+    image_points = 0;
+    recurrence_rate = 0;
+    
+    // Same white to dark blue ramp as the density maps
+    for(int i = 0; i < 256; i++) {
+        float t = i/255.0;
+        colour_map[i][0] = (unsigned char)(255 - 255*t);
+        colour_map[i][1] = (unsigned char)(255 - 255*t);
+        colour_map[i][2] = (unsigned char)(255 - 115*t);
+    }
+}
+
+RecurrencePlot::~RecurrencePlot() {
+    /**
+    *   Deconstructor for the RecurrencePlot class
+    */
+}
+
+void RecurrencePlot::drawPlot() {
+    /**
+    *   Main drawing function for the RecurrencePlot class.
+    *
+    *   Hands any new capture to the recurrence matrix and draws the last
+    *   image it made.  The image is only turned into a bitmap when a new
+    *   one is ready.
+    */
+    recurrence.update();
+    updateImage();
+    
+    int threshold = recurrence.getThreshold();
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        graph_subtitle = wxString::Format(wxT("Time (ms) vs. Time (ms), threshold %d (ADC)"), threshold);
+    } else {
+        graph_subtitle = wxString::Format(wxT("Time (ms) vs. Time (ms), threshold %.3f V"),
+                                          threshold*ChaosCalibration::getScale(ChaosCapture::X1));
+    }
+    graph_note = wxString::Format(wxT("%.2f%% recurrent"), 100*recurrence_rate);
+    
+    startDraw();
+    
+    // Ask for an image that fills the graph, it arrives on a later frame
+    recurrence.setImageSize(graph_width);
+    
+    float t_max = image_points*1000.0/LIBCHAOS_SAMPLE_FREQUENCY;
+    if(t_max > 0) {
+        drawYAxis(0, t_max, t_max/4);
+        drawXAxis(0, t_max, t_max/4);
+    }
+    
+    if(image_bitmap.Ok()) {
+        buffer->DrawBitmap(image_bitmap, side_gutter_size, top_gutter_size + 1);
+    }
+    
+    endDraw();
+}
+
+bool RecurrencePlot::needsRedraw() {
+    /**
+    *   The image is made on a worker thread, after a new capture, a new
+    *   threshold or a new image size, so the plot is also drawn again
+    *   when an image newer than the one shown has been published.  The
+    *   version is written by the worker, so it is read with the image
+    *   locked.
+    */
+    if(ChaosPlot::needsRedraw()) {
+        return true;
+    }
+    recurrence.lock();
+    bool published = recurrence.getImageVersion() != image_version;
+    recurrence.unlock();
+    return published;
+}
+
+void RecurrencePlot::updateImage() {
+    /**
+    *   Turns a new image from the recurrence matrix into a bitmap
+    */
+    recurrence.lock();
+    if(recurrence.getImageVersion() == image_version || recurrence.getImageSize() == 0) {
+        recurrence.unlock();
+        return;
+    }
+    image_version = recurrence.getImageVersion();
+    image_points = recurrence.getNumPoints();
+    recurrence_rate = recurrence.getRecurrenceRate();
+    
+    int size = recurrence.getImageSize();
+    const unsigned char* density = recurrence.getImage();
+    wxImage img(size, size, false);
+    unsigned char* rgb = img.GetData();
+    for(int i = 0; i < size*size; i++) {
+        rgb[3*i] = colour_map[density[i]][0];
+        rgb[3*i + 1] = colour_map[density[i]][1];
+        rgb[3*i + 2] = colour_map[density[i]][2];
+    }
+    recurrence.unlock();
+    
+    image_bitmap = wxBitmap(img);
+}
+
+void RecurrencePlot::setThreshold(int threshold) {
+    /**
+    *   Sets the recurrence threshold in ADC counts
+    */
+    recurrence.setThreshold(threshold);
+    invalidate();
+}
+
+int RecurrencePlot::getThreshold() {
+    /**
+    *   Returns the recurrence threshold in ADC counts
+    */
+    return recurrence.getThreshold();
+}
+
+void RecurrencePlot::UpdateStatusBar(int m_x, int m_y) {
+    /**
+    *   Shows the two times under the cursor in the status bar
+    */
+    if(statusBar && graph_width > 0) {
+        float t_max = image_points*1000.0/LIBCHAOS_SAMPLE_FREQUENCY;
+        float t1 = (m_x - side_gutter_size)*t_max/graph_width;
+        float t2 = (graph_height + top_gutter_size - m_y)*t_max/graph_height;
+        
+        statusBar->SetStatusText(wxString::Format(wxT("(%.3f ms,%.3f ms)"),
+                                        t1,
+                                        t2), 3);
+    }
+}
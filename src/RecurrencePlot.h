@@ -0,0 +1,45 @@
+/**
+ * \file RecurrencePlot.h
+ * \brief Headers for RecurrencePlot.cpp
+ */
+
+#ifndef RECURRENCEPLOT_H
+#define RECURRENCEPLOT_H
+
+#include "ChaosPlot.h"
+#include "libchaos.h"
+#include "RecurrenceMatrix.h"
+
+class RecurrencePlot : public ChaosPlot
+{
+    public:
+        // class constructor
+        RecurrencePlot(wxWindow* parent, 
+                       wxWindowID id = wxID_ANY, 
+                       const wxPoint& pos = wxDefaultPosition, 
+                       const wxSize& size = wxDefaultSize, 
+                       long style = wxTAB_TRAVERSAL, 
+                       const wxString& name = wxT("panel"));
+        // class destructor
+        ~RecurrencePlot();
+        void drawPlot();
+        bool needsRedraw();
+        void setThreshold(int threshold);
+        int getThreshold();
+    private:
+        void updateImage();
+        void UpdateStatusBar(int m_x, int m_y);
+        
+        RecurrenceMatrix recurrence;
+        
+        // Bitmap of the last image from the matrix
+        wxBitmap image_bitmap;
+        unsigned int image_version;
+        int image_points;
+        float recurrence_rate;
+        
+        // Colours for each density byte
+        unsigned char colour_map[256][3];
+};
+
+#endif // RECURRENCEPLOT_H
@@ -0,0 +1,164 @@
+/**
+ * \file ReturnMapAccumulator.cpp
+ * \brief Implements a hit counting store for return map points
+ */
+
+#include <stdlib.h>
+#include "ReturnMapAccumulator.h"
+
+// Starting size of the hash table and its log2
+#define INITIAL_TABLE_SIZE 4096
+#define INITIAL_TABLE_BITS 12
+
+ReturnMapAccumulator::ReturnMapAccumulator() {
+    /**
+    *   Constructor for the ReturnMapAccumulator class.
+    *
+    *   Return map points are integer ADC pairs on a 1024x1024 grid.  Each
+    *   pair is packed into a single key and stored in an open addressing
+    *   hash table so that checking whether a point has been seen before is
+    *   a constant time operation no matter how many points are stored.
+    *   Every point keeps a hit count so the map can be drawn as a density.
+    */
+    table_size = INITIAL_TABLE_SIZE;
+    hash_shift = 32 - INITIAL_TABLE_BITS;
+    table = (int*)malloc(table_size*sizeof(int));
+    keys = (unsigned int*)malloc((table_size/2)*sizeof(unsigned int));
+    counts = (unsigned int*)malloc((table_size/2)*sizeof(unsigned int));
+    clear();
+}
+
+ReturnMapAccumulator::~ReturnMapAccumulator() {
+    /**
+    *   Destructor for the ReturnMapAccumulator class
+    */
+    free(table);
+    free(keys);
+    free(counts);
+}
+
+void ReturnMapAccumulator::clear() {
+    /**
+    *   Removes all of the stored points.  The table keeps its current size
+    *   so that refilling it does not have to grow it again.
+    */
+    for(int i = 0; i < table_size; i++) {
+        table[i] = -1;
+    }
+    num_points = 0;
+    num_hits = 0;
+    max_hits = 0;
+}
+
+unsigned int ReturnMapAccumulator::hashKey(unsigned int key) {
+    /**
+    *   Spreads a packed (x,y) key over the table using a multiplicative
+    *   hash.  The top bits of the product depend on every bit of the key,
+    *   so they are the ones kept and neighbouring points on the grid end
+    *   up in different slots.
+    */
+    return (key*2654435761u) >> hash_shift;
+}
+
+void ReturnMapAccumulator::addPoint(int x, int y) {
+    /**
+    *   Adds a point to the return map.  If the point is already stored its
+    *   hit count is incremented, otherwise it is inserted with a count of 1.
+    *   Points outside of the ADC range are clamped onto the grid.
+    */
+    if(x < 0) x = 0;
+    if(x >= RETURN_MAP_GRID_SIZE) x = RETURN_MAP_GRID_SIZE - 1;
+    if(y < 0) y = 0;
+    if(y >= RETURN_MAP_GRID_SIZE) y = RETURN_MAP_GRID_SIZE - 1;
+
+    unsigned int key = (x << 10) | y;
+    unsigned int slot = hashKey(key);
+
+    // Linear probing until we find the point or an empty slot
+    while(table[slot] != -1) {
+        int index = table[slot];
+        if(keys[index] == key) {
+            counts[index]++;
+            num_hits++;
+            if(counts[index] > max_hits) {
+                max_hits = counts[index];
+            }
+            return;
+        }
+        slot = (slot + 1) & (table_size - 1);
+    }
+
+    // New point, keep the table at most half full
+    if(num_points >= table_size/2) {
+        grow();
+        slot = hashKey(key);
+        while(table[slot] != -1) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+    }
+
+    keys[num_points] = key;
+    counts[num_points] = 1;
+    table[slot] = num_points;
+    num_points++;
+    num_hits++;
+    if(max_hits == 0) {
+        max_hits = 1;
+    }
+}
+
+void ReturnMapAccumulator::grow() {
+    /**
+    *   Doubles the size of the hash table and re-inserts all of the points.
+    *   The grid only holds 1024*1024 distinct points so the table can never
+    *   grow past twice that.
+    */
+    table_size *= 2;
+    hash_shift--;
+    table = (int*)realloc(table, table_size*sizeof(int));
+    keys = (unsigned int*)realloc(keys, (table_size/2)*sizeof(unsigned int));
+    counts = (unsigned int*)realloc(counts, (table_size/2)*sizeof(unsigned int));
+
+    for(int i = 0; i < table_size; i++) {
+        table[i] = -1;
+    }
+
+    for(int i = 0; i < num_points; i++) {
+        unsigned int slot = hashKey(keys[i]);
+        while(table[slot] != -1) {
+            slot = (slot + 1) & (table_size - 1);
+        }
+        table[slot] = i;
+    }
+}
+
+int ReturnMapAccumulator::getNumPoints() {
+    /**
+    *   Returns the number of distinct points that have been stored
+    */
+    return num_points;
+}
+
+unsigned int ReturnMapAccumulator::getNumHits() {
+    /**
+    *   Returns the total number of points added, including repeats
+    */
+    return num_hits;
+}
+
+unsigned int ReturnMapAccumulator::getMaxHits() {
+    /**
+    *   Returns the hit count of the most visited point
+    */
+    return max_hits;
+}
+
+void ReturnMapAccumulator::getPoint(int index, int* x, int* y, unsigned int* hits) {
+    /**
+    *   Gets a stored point and its hit count.  Index must be between 0 and
+    *   getNumPoints()-1.
+    */
+    *x = keys[index] >> 10;
+    *y = keys[index] & (RETURN_MAP_GRID_SIZE - 1);
+    *hits = counts[index];
+}
@@ -0,0 +1,46 @@
+/**
+ * \file ReturnMapAccumulator.h
+ * \brief Headers for ReturnMapAccumulator.cpp
+ */
+
+#ifndef RETURNMAPACCUMULATOR_H
+#define RETURNMAPACCUMULATOR_H
+
+// Size of one side of the ADC grid the return map points live on
+#define RETURN_MAP_GRID_SIZE 1024
+
+class ReturnMapAccumulator
+{
+    public:
+        // class constructor
+        ReturnMapAccumulator();
+        // class destructor
+        ~ReturnMapAccumulator();
+        void clear();
+        void addPoint(int x, int y);
+        int getNumPoints();
+        unsigned int getNumHits();
+        unsigned int getMaxHits();
+        void getPoint(int index, int* x, int* y, unsigned int* hits);
+
+    private:
+        void grow();
+        unsigned int hashKey(unsigned int key);
+
+        // Open addressing table holding indexes into the point arrays
+        int* table;
+        int table_size;
+
+        // 32 less log2 of table_size, the hash keeps the bits above it
+        int hash_shift;
+
+        // Densely packed points so that drawing only walks what is stored
+        unsigned int* keys;
+        unsigned int* counts;
+        int num_points;
+
+        unsigned int num_hits;
+        unsigned int max_hits;
+};
+
+#endif // RETURNMAPACCUMULATOR_H
@@ -0,0 +1,219 @@
+/**
+ * \file ReturnMapEngine.cpp
+ * \brief Streaming generator for return maps and delay embeddings
+ */
+
+#include "ReturnMapEngine.h"
+#include "ChaosCapture.h"
+#include "ChaosRecord.h"
+
+ReturnMapEngine::ReturnMapEngine(int mode, int lag) {
+    /**
+    *   Constructor for the ReturnMapEngine class.
+    *
+    *   The engine turns the capture stream into pairs of values and
+    *   accumulates them.  In PEAK_RETURN mode the pairs are
+    *   (Peak(n), Peak(n+k)), in DELAY_EMBEDDING mode they are
+    *   (X(t), X(t+tau)).  Both are the same operation on a stream of
+    *   events, either peaks or raw samples, so the only state needed is a
+    *   ring buffer of the last lag events.  The events are read from
+    *   ChaosRecord, so every capture since the last update is fed even if
+    *   several arrived in between.
+    */
+    channel = ChaosCapture::X1;
+    record_generation = ChaosRecord::getGeneration();
+    record_position = ChaosRecord::getEnd();
+    this->mode = mode;
+    setLag(lag);
+}
+
+ReturnMapEngine::~ReturnMapEngine() {
+    /**
+    *   Destructor for the ReturnMapEngine class
+    */
+}
+
+void ReturnMapEngine::clear() {
+    /**
+    *   Throws away all of the accumulated pairs
+    */
+    accumulator.clear();
+    recent_count = 0;
+    resetStream();
+}
+
+void ReturnMapEngine::resetStream() {
+    /**
+    *   Forgets the events seen so far.  Captures are not continuous in
+    *   time, so pairs are never made across two different captures.
+    */
+    history_pos = 0;
+    history_count = 0;
+    
+    // Start by looking for a trough so that a capture starting part way
+    // through a peak does not produce a short peak
+    rising = false;
+    extreme = 0x7fffffff;
+}
+
+void ReturnMapEngine::update() {
+    /**
+    *   Feeds everything recorded since the last call, one run of the record
+    *   at a time.  The stream starts again at the start of every capture.
+    *   This is cheap to call every frame, it does nothing if there is no
+    *   new data.
+    */
+    if(record_generation == ChaosRecord::getGeneration()) {
+        return;
+    }
+    record_generation = ChaosRecord::getGeneration();
+    
+    if(record_position < ChaosRecord::getStart()) {
+        record_position = ChaosRecord::getStart();
+    }
+    const short* data;
+    bool capture_start;
+    int num_points;
+    while((num_points = ChaosRecord::getRun(record_position, channel, &data, &capture_start)) > 0) {
+        if(capture_start) {
+            resetStream();
+            recent_count = 0;
+        }
+        feed(data, num_points);
+        record_position += num_points;
+    }
+}
+
+void ReturnMapEngine::feed(const short* data, int num_points) {
+    /**
+    *   Processes one run of samples from a capture.  Peaks are found with
+    *   a small amount of hysteresis so that noise on top of a slow peak
+    *   does not produce several peaks.
+    */
+    if(mode == DELAY_EMBEDDING) {
+        for(int i = 0; i < num_points; i++) {
+            addEvent(data[i]);
+        }
+        return;
+    }
+    
+    for(int i = 0; i < num_points; i++) {
+        int value = data[i];
+        if(rising) {
+            if(value > extreme) {
+                extreme = value;
+            } else if(value < extreme - PEAK_HYSTERESIS) {
+                addEvent(extreme);
+                rising = false;
+                extreme = value;
+            }
+        } else {
+            if(value < extreme) {
+                extreme = value;
+            } else if(value > extreme + PEAK_HYSTERESIS) {
+                rising = true;
+                extreme = value;
+            }
+        }
+    }
+}
+
+void ReturnMapEngine::addEvent(int value) {
+    /**
+    *   Adds a peak or sample to the stream.  Once lag events have been seen
+    *   every new event is paired with the one lag events before it.
+    */
+    if(history_count >= lag) {
+        // history_pos holds the oldest event once the ring is full
+        int previous = history[history_pos];
+        accumulator.addPoint(previous, value);
+        
+        if(recent_count < RETURN_MAP_RECENT_PAIRS) {
+            recent[recent_count][0] = previous;
+            recent[recent_count][1] = value;
+            recent_count++;
+        }
+    } else {
+        history_count++;
+    }
+    
+    history[history_pos] = value;
+    history_pos++;
+    if(history_pos >= lag) {
+        history_pos = 0;
+    }
+}
+
+void ReturnMapEngine::setMode(int mode) {
+    /**
+    *   Switches between peak return maps and delay embeddings
+    */
+    if(this->mode != mode) {
+        this->mode = mode;
+        clear();
+    }
+}
+
+void ReturnMapEngine::setLag(int lag) {
+    /**
+    *   Sets k (peaks) or tau (samples) and clears the accumulated pairs
+    */
+    if(lag < 1) lag = 1;
+    if(lag > RETURN_MAP_MAX_LAG) lag = RETURN_MAP_MAX_LAG;
+    this->lag = lag;
+    clear();
+}
+
+void ReturnMapEngine::setChannel(int channel) {
+    /**
+    *   Selects the capture channel the events are taken from
+    */
+    if(this->channel != channel) {
+        this->channel = channel;
+        clear();
+    }
+}
+
+int ReturnMapEngine::getChannel() {
+    /**
+    *   Returns the capture channel the events are taken from
+    */
+    return channel;
+}
+
+int ReturnMapEngine::getMode() {
+    /**
+    *   Returns PEAK_RETURN or DELAY_EMBEDDING
+    */
+    return mode;
+}
+
+int ReturnMapEngine::getLag() {
+    /**
+    *   Returns the current k or tau
+    */
+    return lag;
+}
+
+ReturnMapAccumulator* ReturnMapEngine::getAccumulator() {
+    /**
+    *   Returns the accumulated pairs
+    */
+    return &accumulator;
+}
+
+int ReturnMapEngine::getNumRecentPairs() {
+    /**
+    *   Returns the number of pairs kept from the latest capture
+    */
+    return recent_count;
+}
+
+void ReturnMapEngine::getRecentPair(int index, int* x, int* y) {
+    /**
+    *   Gets one of the first pairs of the latest capture in time order.
+    *   These are used to follow the trajectory on the return map.
+    */
+    *x = recent[index][0];
+    *y = recent[index][1];
+}
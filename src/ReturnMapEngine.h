@@ -0,0 +1,72 @@
+/**
+ * \file ReturnMapEngine.h
+ * \brief Headers for ReturnMapEngine.cpp
+ */
+
+#ifndef RETURNMAPENGINE_H
+#define RETURNMAPENGINE_H
+
+#include "ReturnMapAccumulator.h"
+
+// Largest lag (in peaks or samples) the engine can be asked for
+#define RETURN_MAP_MAX_LAG 512
+
+// Number of pairs from the latest capture kept for following the map
+#define RETURN_MAP_RECENT_PAIRS 64
+
+// Amount (ADC) a signal must fall below a maximum before it counts as a peak
+#define PEAK_HYSTERESIS 4
+
+class ReturnMapEngine
+{
+    public:
+        enum {
+            PEAK_RETURN = 0,
+            DELAY_EMBEDDING
+        };
+        
+        // class constructor
+        ReturnMapEngine(int mode = PEAK_RETURN, int lag = 1);
+        // class destructor
+        ~ReturnMapEngine();
+        void clear();
+        void update();
+        void setMode(int mode);
+        void setLag(int lag);
+        void setChannel(int channel);
+        int getMode();
+        int getLag();
+        int getChannel();
+        ReturnMapAccumulator* getAccumulator();
+        int getNumRecentPairs();
+        void getRecentPair(int index, int* x, int* y);
+        
+    private:
+        void feed(const short* data, int num_points);
+        void addEvent(int value);
+        void resetStream();
+    
+        int mode;
+        int lag;
+        int channel;
+        ReturnMapAccumulator accumulator;
+        
+        // Position in ChaosRecord up to which the events have been fed
+        unsigned int record_generation;
+        long long record_position;
+        
+        // Ring buffer of the last lag events (peaks or samples)
+        int history[RETURN_MAP_MAX_LAG];
+        int history_pos;
+        int history_count;
+        
+        // Peak detector state
+        bool rising;
+        int extreme;
+        
+        // First pairs of the latest capture
+        int recent[RETURN_MAP_RECENT_PAIRS][2];
+        int recent_count;
+};
+
+#endif // RETURNMAPENGINE_H
@@ -0,0 +1,292 @@
+/**
+ * \file ReturnMapPlot.cpp
+ * \brief Implements class for plotting return maps and delay embeddings
+ */
+
+#include "ReturnMapPlot.h"
+#include "ChaosSettings.h"
+#include "ChaosCalibration.h"
+
+ReturnMapPlot::ReturnMapPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
+                       const wxSize& size, long style, const wxString& name,
+                       int mode, int lag) 
+                       : ChaosPlot(parent, id, pos, size, style, name),
+                         engine(mode, lag) {
+    /**
+    *   Constructor for the return map plot.
+    *   This class inherits from the ChaosPlot class and redefines various
+    *   settings and drawing functions to create a return map of the data
+    *   collected from the Chaos Unit.  The map is either Peak(n+k) vs.
+    *   Peak(n) or X(t+tau) vs. X(t) depending on the mode, and k or tau
+    *   can be changed while the plot is displayed.
+    */
+    side_gutter_size = 15;
+    bottom_gutter_size = 20;
+    square = true;
+    updateTitles();
+    Connect( wxID_ANY, wxEVT_LEFT_DCLICK,
+                    (wxObjectEventFunction) &ReturnMapPlot::OnDblClick );
+                    
+    // Create timer
+    timer1 = new wxTimer();
+    timer1->SetOwner(this, ID_TIMER1);
+    timer1->Stop();
+    timer_ticks = 0;
+    
+    Connect( ID_TIMER1, wxEVT_TIMER,
+                    (wxObjectEventFunction) &ReturnMapPlot::timer1Timer );
+    zoomable_graph = true;
+    old_mdac = 0;
+    zoomDefault();
+    
+    delay_analysis = NULL;
+    if(mode == ReturnMapEngine::DELAY_EMBEDDING) {
+        delay_analysis = new DelayAnalysis(engine.getChannel());
+    }
+}
+
+ReturnMapPlot::~ReturnMapPlot() {
+    /**
+    *   Deconstructor for the ReturnMapPlot class
+    */
+    timer1->Stop();
+    delete timer1;
+    delete delay_analysis;
+}
+
+void ReturnMapPlot::updateTitles() {
+    /**
+    *   Sets the title and subtitle for the current mode, lag and units
+    */
+    wxString units;
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        units = wxT("ADC");
+    } else {
+        units = wxT("V");
+    }
+    
+    int lag = engine.getLag();
+    if(engine.getMode() == ReturnMapEngine::DELAY_EMBEDDING) {
+        graph_title = wxT("Delay Embedding");
+        graph_subtitle = wxString::Format(wxT("X(t+%d) (%s) vs. X(t) (%s)"), 
+                                          lag, units.c_str(), units.c_str());
+    } else {
+        if(lag == 1) {
+            graph_title = wxT("First Return Map");
+        } else if(lag == 2) {
+            graph_title = wxT("Second Return Map");
+        } else {
+            graph_title = wxString::Format(wxT("Return Map (k = %d)"), lag);
+        }
+        graph_subtitle = wxString::Format(wxT("Peak(n+%d) (%s) vs. Peak(n) (%s)"), 
+                                          lag, units.c_str(), units.c_str());
+    }
+}
+
+void ReturnMapPlot::drawPlot() {
+    /**
+    *   Main drawing function for the ReturnMapPlot class.
+    *
+    *   Draws the axis on the graph.
+    *   Draws the y=x line across the graph (useful for analyzing return maps)
+    *   Plots the accumulated pairs of peaks or samples
+    */
+    int x,y;
+    unsigned int hits;
+    
+    // Clear the accumulated points if the circuit has changed.  The whole
+    // ADC grid is stored, so zooming does not require collecting again.
+    if(old_mdac != device_mdac_value) {
+        engine.clear();
+        if(delay_analysis) {
+            delay_analysis->clear();
+        }
+        old_mdac = device_mdac_value;
+    }
+    
+    // Feed any new capture to the engine
+    engine.update();
+    if(delay_analysis) {
+        delay_analysis->update();
+    }
+    
+    startDraw();
+    updateTitles();
+    
+    float x_min, x_max;
+    float y_min, y_max;
+    int channel = engine.getChannel();
+    y_min = ChaosCalibration::toUnits(channel, smallest_y_value);
+    y_max = ChaosCalibration::toUnits(channel, largest_y_value);
+    x_min = ChaosCalibration::toUnits(channel, smallest_x_value);
+    x_max = ChaosCalibration::toUnits(channel, largest_x_value);
+    
+    drawYAxis(y_min, y_max, (y_max-y_min)/3.0);
+              
+    drawXAxis(x_min, x_max, (x_max-x_min)/3.0);
+    
+    buffer->DrawLine(side_gutter_size,graph_height+top_gutter_size,
+                     side_gutter_size+graph_width,top_gutter_size);
+
+    // Draw the points that are inside the window in blue
+    ReturnMapAccumulator* accumulator = engine.getAccumulator();
+    unsigned int max_hits = accumulator->getMaxHits();
+    wxPoint* points = raster.getPoints(accumulator->getNumPoints());
+    unsigned char* levels = getPointLevels(accumulator->getNumPoints());
+    int num_points = 0;
+    for(int i = 0; i < accumulator->getNumPoints(); i++) {
+        accumulator->getPoint(i, &x, &y, &hits);
+        if(x > smallest_x_value && x < largest_x_value &&
+           y > smallest_y_value && y < largest_y_value) {
+            points[num_points] = wxPoint(valueToX(x), valueToY(y));
+            if(density_map) {
+                levels[num_points] = densityLevel(hits, max_hits);
+            }
+            num_points++;
+        }
+    }
+    
+    startRaster();
+    if(density_map) {
+        drawDensityPoints(points, levels, num_points);
+    } else {
+        raster.setColour(*wxBLUE);
+        drawPoints(points, num_points);
+    }
+    endRaster();
+    
+    endDraw();
+}
+
+void ReturnMapPlot::drawOverlay() {
+    /**
+    *   Follows the return plot on top of the points
+    */
+    followReturnPlot();
+}
+
+void ReturnMapPlot::OnDblClick(wxMouseEvent& evt) {
+    /**
+    *   Event handler for the graph double click.
+    *   Enables or disables the return map following
+    */
+    if(timer1->IsRunning()) {
+        timer1->Stop();
+        timer_ticks = 0;
+    } else {
+        timer1->Start(ChaosSettings::UpdatePeriod);
+    }
+    invalidate();
+}
+
+void ReturnMapPlot::followReturnPlot() {
+    /**
+    *   Draws lines to follow the return plot and show if it is behaving
+    *   periodically or chaotically.  This is done by following a point to
+    *   the y=x line, mirroring it and drawing a line between the 3 points.
+    */
+    int line_count = timer_ticks % 20;
+    int x,y;
+    
+    //Use green pen
+    wxPen greenPen(*wxGREEN, 1);
+    buffer->SetPen(greenPen);
+    
+    for(int i = 0; i < engine.getNumRecentPairs() && i < line_count; i++) {
+        engine.getRecentPair(i, &x, &y);
+        buffer->DrawLine(valueToX(x), valueToY(x), valueToX(x), valueToY(y));
+        buffer->DrawLine(valueToX(x), valueToY(y), valueToX(y), valueToY(y));
+    }
+}
+
+void ReturnMapPlot::timer1Timer(wxTimerEvent& event) {
+    /**
+    *   Event handler for timer1.
+    *   Increments timer_ticks so that we know how many return map points to follow.
+    */
+    timer_ticks++;
+    invalidate();
+}
+
+void ReturnMapPlot::setLag(int lag) {
+    /**
+    *   Sets k for return maps or tau (in samples) for delay embeddings.
+    *   The accumulated points are cleared.
+    */
+    engine.setLag(lag);
+    updateTitles();
+    invalidate();
+}
+
+int ReturnMapPlot::getLag() {
+    /**
+    *   Returns k for return maps or tau (in samples) for delay embeddings
+    */
+    return engine.getLag();
+}
+
+int ReturnMapPlot::getMode() {
+    /**
+    *   Returns PEAK_RETURN or DELAY_EMBEDDING
+    */
+    return engine.getMode();
+}
+
+int ReturnMapPlot::getSuggestedLag() {
+    /**
+    *   Returns the tau suggested by the delay analysis of the captures
+    *   seen so far.  Return maps just keep their current k.
+    */
+    if(delay_analysis) {
+        return delay_analysis->getSuggestedLag();
+    }
+    return engine.getLag();
+}
+
+int ReturnMapPlot::xToValue(int x) {
+    /**
+    *   Converts an x point on the graph to an ADC value.
+    *   This is a very important function that is used by the parent class
+    *   (ChaosPlot) for zooming.
+    */
+    if ( graph_width == 0) {
+        return 1;
+    }
+    return ((x - side_gutter_size)*(largest_x_value - smallest_x_value))/graph_width + smallest_x_value;
+}
+
+int ReturnMapPlot::valueToX(int value) {
+    /**
+    *   Converts an ADC value to an X coordinate on the graph.
+    */
+    return (((value - smallest_x_value)*graph_width)/(largest_x_value - smallest_x_value)) + side_gutter_size;
+}
+
+int ReturnMapPlot::yToValue(int y) {
+    /**
+    *   Converts a y point on the graph to an ADC value.
+    *   This is a very important function that is used by the parent class
+    *   (ChaosPlot) for zooming.
+    */
+    if ( graph_height == 0) {
+        return 1;
+    }
+    return (((top_gutter_size + graph_height) - y)*(largest_y_value - smallest_y_value))/graph_height + smallest_y_value;
+}
+
+int ReturnMapPlot::valueToY(int value) {
+    /**
+    *   Converts an ADC value to a Y coordinate on the graph.
+    */
+    return (graph_height-((value-smallest_y_value)*graph_height)/(largest_y_value - smallest_y_value)) + top_gutter_size;
+}
+
+void ReturnMapPlot::zoomDefault() {
+    /**
+    *   Resets the zoom to the default values.
+    */
+    largest_x_value = 1024;
+    smallest_x_value = 0;
+    smallest_y_value = 0;
+    largest_y_value = 1024;
+}
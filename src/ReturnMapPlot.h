@@ -0,0 +1,59 @@
+/**
+ * \file ReturnMapPlot.h
+ * \brief Headers for ReturnMapPlot.cpp
+ */
+
+#ifndef RETURNMAPPLOT_H
+#define RETURNMAPPLOT_H
+
+#include "ChaosPlot.h"
+#include "libchaos.h"
+#include "ReturnMapEngine.h"
+#include "DelayAnalysis.h"
+
+class ReturnMapPlot : public ChaosPlot
+{
+    public:
+        // class constructor
+        ReturnMapPlot(wxWindow* parent, 
+                       wxWindowID id = wxID_ANY, 
+                       const wxPoint& pos = wxDefaultPosition, 
+                       const wxSize& size = wxDefaultSize, 
+                       long style = wxTAB_TRAVERSAL, 
+                       const wxString& name = wxT("panel"),
+                       int mode = ReturnMapEngine::PEAK_RETURN,
+                       int lag = 1);
+        // class destructor
+        ~ReturnMapPlot();
+        void drawPlot();
+        void setLag(int lag);
+        int getLag();
+        int getMode();
+        int getSuggestedLag();
+    private:
+        void OnDblClick(wxMouseEvent& evt);
+        void followReturnPlot();
+        void drawOverlay();
+        void timer1Timer(wxTimerEvent& event);
+        void updateTitles();
+
+        wxTimer *timer1;
+        int timer_ticks;
+        int xToValue(int x);
+        int yToValue(int y);
+        int valueToX(int value);
+        int valueToY(int value);
+        
+        void zoomDefault();
+        
+        int old_mdac;
+        ReturnMapEngine engine;
+        
+        // Only used by delay embeddings to suggest tau
+        DelayAnalysis* delay_analysis;
+        enum {
+            ID_TIMER1 = 1000,
+        };
+};
+
+#endif // RETURNMAPPLOT_H
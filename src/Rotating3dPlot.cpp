@@ -3,33 +3,86 @@
  * \brief Implements class for a rotating 3d plot
  */
 
+#include <stdlib.h>
+#include <math.h>
 #include "Rotating3dPlot.h"
 #include "ChaosSettings.h"
+#include "ChaosCapture.h"
+#include "ChaosChannels.h"
+#include "ChaosRecord.h"
+
+// Time between steps of the automatic rotation in milliseconds, and the
+// number of steps it takes to go all the way round
+#define ROTATION_PERIOD 40
+#define ROTATION_STEPS 125
+
+// Steps the rotation slider splits a turn into
+#define SLIDER_STEPS 25
+
+// Radians the view turns for each pixel the mouse is dragged
+#define DRAG_RADIANS 0.01f
+
+// Length of the guide drawn along each axis, in ADC counts
+#define GUIDE_LENGTH 300
+
+// Most samples of the long record drawn as the trajectory
+#define TRAJECTORY_POINTS 131072
+
+static const float pi = 3.14159265f;
 
 Rotating3dPlot::Rotating3dPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
-                       const wxSize& size, long style, const wxString& name) 
+                       const wxSize& size, long style, const wxString& name)
                        : ChaosPlot(parent, id, pos, size, style, name) {
     /**
-    *   Constructor for the rotating 3d plot. Initializes all settings and 
+    *   Constructor for the rotating 3d plot. Initializes all settings and
     *   creates a timer to control the rotation.
+    *
+    *   Dragging with the mouse turns the view and the wheel zooms it, so
+    *   the zooming rectangle of the other plots is not used.
     */
     side_gutter_size = 20;
     bottom_gutter_size = 0;
-    smallest_x_value = -218;
-    smallest_y_value = 0;
-    largest_x_value = 1024;
-    largest_y_value = 1024;
-    
+    x_channel = ChaosCapture::X1;
+    y_channel = ChaosCapture::X2;
+    z_channel = ChaosCapture::X3;
+    perspective = false;
+    rotating = false;
+    centre[0] = centre[1] = centre[2] = 409;
+    centre_valid = false;
+    centre_generation = 0;
+    shades = NULL;
+    allocated_shades = 0;
+    zoomDefault();
+
+    // Near parts of the trajectory are a dark red, far ones fade towards
+    // the background
+    for(int i = 0; i < VIEW_SHADES; i++) {
+        float t = float(i)/(VIEW_SHADES - 1);
+        colour_map[3*i] = (unsigned char)(255 - 85*t);
+        colour_map[3*i + 1] = (unsigned char)(210*(1 - t));
+        colour_map[3*i + 2] = (unsigned char)(210*(1 - t));
+    }
+
     // Create timer
     timer1 = new wxTimer();
     timer1->SetOwner(this, ID_TIMER1);
-    timer1->Start(200);
-    
+    timer1->Start(ROTATION_PERIOD);
+
     Connect( ID_TIMER1, wxEVT_TIMER,
                     (wxObjectEventFunction) &Rotating3dPlot::timer1Timer );
+    Connect( wxID_ANY, wxEVT_LEFT_DOWN,
+                    (wxObjectEventFunction) &Rotating3dPlot::OnRotateStart );
+    Connect( wxID_ANY, wxEVT_MOTION,
+                    (wxObjectEventFunction) &Rotating3dPlot::OnRotateMove );
+    Connect( wxID_ANY, wxEVT_LEFT_UP,
+                    (wxObjectEventFunction) &Rotating3dPlot::OnRotateEnd );
+    Connect( wxID_ANY, wxEVT_MOUSEWHEEL,
+                    (wxObjectEventFunction) &Rotating3dPlot::OnWheel );
+    Connect( wxID_ANY, wxEVT_MOUSE_CAPTURE_LOST,
+                    (wxObjectEventFunction) &Rotating3dPlot::OnCaptureLost );
     graph_title = wxT("Rotating Phase Portrait");
-    graph_subtitle = wxT("-X' (V) vs. X (V)");
-    zoomable_graph = true;
+    graph_subtitle = wxT("X, X', X'' (V)");
+    zoomable_graph = false;
 }
 
 // class destructor
@@ -37,138 +90,282 @@ Rotating3dPlot::~Rotating3dPlot() {
     /**
     *   Deconstructor for the Rotating3dPlot class
     */
+    timer1->Stop();
+    delete timer1;
+    free(shades);
 }
 
 void Rotating3dPlot::drawPlot() {
     /**
     *   Main drawing function for the ChaosPlot classes.
     *
-    *   Draws a rotating 3d plot by graphing xdot vs the formula:
-    *       x*cos(a*n) + x''*sin(a*n)
+    *   Draws the trajectory through the three chosen channels as seen from
+    *   the current orientation.  The rotation, projection and scaling are
+    *   built into one matrix for the frame, which takes every sample to
+    *   the plot along with a shade for its depth.  The trajectory is then
+    *   drawn through the raster with each segment coloured by its shade.
     *
-    *   In order to get this to look like it is rotating around it's axis
-    *   instead of around the outside of a merry-go-round, we must subtract
-    *   the bias from our ADC values before we calculate the rotation.
-    *   bias = 2V/5V*1024 = 409
-    */
-    const float a = 2*3.14159/25;
-    const int bias = 409;
-    int x1,x2,x1_old,x2_old,x3;
-    
-    startDraw();
-    float y_min, y_max;
-    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-        graph_subtitle = wxT("-X' (V) vs. X (V)");
-        y_min = smallest_y_value*3.3/1024;
-        y_max = largest_y_value*3.3/1024;
-    } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-        graph_subtitle = wxT("-X' (V) vs. X (V)");
-        y_min = smallest_y_value*3.3/1024 - 1.2;
-        y_max = largest_y_value*3.3/1024 - 1.2;
-    } else {
-        graph_subtitle = wxT("-X' (ADC) vs. X (ADC)");
-        y_min = smallest_y_value;
-        y_max = largest_y_value;
+    *   When all three channels come from the device the trajectory is the
+    *   newest TRAJECTORY_POINTS samples of the long record, otherwise it is
+    *   the current capture, as derived channels are not recorded.
+    */
+    const wxChar* units = wxT("V");
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        units = wxT("ADC");
     }
-
-    drawYAxis(y_min, y_max, (y_max-y_min)/4.0);
+    graph_subtitle = wxString::Format(wxT("%s, %s, %s (%s)"),
+                                      ChaosChannels::getName(x_channel).c_str(),
+                                      ChaosChannels::getName(y_channel).c_str(),
+                                      ChaosChannels::getName(z_channel).c_str(), units);
+    graph_note = wxEmptyString;
+    startDraw();
 
     if(device_connected == false) {
         endDraw();
         return;
     }
-    
-    //Use red pen
-    wxPen pen(*wxRED, 1); // red pen of width 1
-    buffer->SetPen(pen);
-    
-    // Get first plot point
-    libchaos_getPlotPoint(&x1,&x2,&x3, 0);
-    
-    // x1 = x*cos(a*n)+x3*sin(a*n), but we have to subtract the bias from it
-    // so that it rotates around the origin, we then add bias so it is visible
-    x1 = valueToX(int((x1 - bias)*cos(a*timer_ticks) + (x3-bias)*sin(a*timer_ticks))+bias);
-    x2 = valueToY(x2);
-    x1_old = x1;
-    x2_old = x2;
-    
-    // Repeat the above math for all the other points and graph them.
-    for(int i = 1; i < libchaos_getNumPlotPoints(); i++) {
-        libchaos_getPlotPoint(&x1,&x2,&x3, i);
-        x1 = valueToX(int((x1 - bias)*cos(a*timer_ticks) + (x3-bias)*sin(a*timer_ticks))+bias);
-        x2 = valueToY(x2);
-        if(x1 > side_gutter_size && 
-           x2 < (graph_height + top_gutter_size) && x2 > top_gutter_size && 
-           x1_old > side_gutter_size && 
-           x2_old < (graph_height + top_gutter_size) && x2_old > top_gutter_size) {
-            buffer->DrawLine(x1_old,x2_old,x1,x2);
-        }
-        x1_old = x1;
-        x2_old = x2;
+    updateCentre();
+
+    int size = graph_width < graph_height ? graph_width : graph_height;
+    view.setCentre(centre[0], centre[1], centre[2]);
+    view.setRotation(yaw, pitch);
+    view.setProjection(perspective);
+    view.setViewport(side_gutter_size + graph_width/2.0f, top_gutter_size + graph_height/2.0f,
+                     zoom*size/1000.0f);
+    view.update();
+
+    startRaster();
+    drawGuides();
+    int num_points;
+    if(x_channel < ChaosCapture::NUM_CHANNELS && y_channel < ChaosCapture::NUM_CHANNELS &&
+       z_channel < ChaosCapture::NUM_CHANNELS && ChaosRecord::getEnd() > ChaosRecord::getStart()) {
+        num_points = drawRecord();
+    } else {
+        num_points = drawCapture();
     }
-    
+    endRaster();
+    graph_note = wxString::Format(wxT("%d points"), num_points);
+
     // Display buffer
     endDraw();
 }
 
-int Rotating3dPlot::valueToX(int value) {
+void Rotating3dPlot::reserve(int num_points) {
     /**
-    *   Converts an ADC value to an X coordinate on the graph. 
-    *   This function does not attempt to rotate the point, that is handled
-    *   in the actual drawing function.
+    *   Makes sure there is room for the shades of num_points points
     */
-    return (((value - smallest_x_value)*graph_width)/(largest_x_value - smallest_x_value)) + side_gutter_size;
+    if(num_points > allocated_shades) {
+        shades = (unsigned char*)realloc(shades, num_points);
+        allocated_shades = num_points;
+    }
 }
 
-int Rotating3dPlot::valueToY(int value) {
+int Rotating3dPlot::drawCapture() {
     /**
-    *   Converts an ADC value to a Y coordinate on the graph.
+    *   Draws the trajectory of the current capture.  Returns the number
+    *   of points drawn.
     */
-    return (graph_height-((value-smallest_y_value)*graph_height)/(largest_y_value - smallest_y_value))  + top_gutter_size;
+    int num_points = ChaosCapture::getNumPoints();
+    reserve(num_points);
+    wxPoint* points = raster.getPoints(num_points);
+    view.transform(ChaosChannels::getChannel(x_channel),
+                   ChaosChannels::getChannel(y_channel),
+                   ChaosChannels::getChannel(z_channel),
+                   num_points, points, shades);
+    raster.drawShadedLines(points, shades, num_points, colour_map);
+    return num_points;
 }
 
+int Rotating3dPlot::drawRecord() {
+    /**
+    *   Draws the trajectory of the newest TRAJECTORY_POINTS samples of the
+    *   long record.  The record is walked one run at a time, each run
+    *   transformed straight from the chunk it is held in.  Captures are not
+    *   continuous with each other, so the line is broken where each one
+    *   starts.  Returns the number of points drawn.
+    */
+    long long end = ChaosRecord::getEnd();
+    long long position = end - TRAJECTORY_POINTS;
+    if(position < ChaosRecord::getStart()) {
+        position = ChaosRecord::getStart();
+    }
+    int num_points = (int)(end - position);
+    reserve(num_points);
+    wxPoint* points = raster.getPoints(num_points);
 
-int Rotating3dPlot::xToValue(int x) {
+    int n = 0;
+    int line_start = 0;
+    while(n < num_points) {
+        const short* x;
+        const short* y;
+        const short* z;
+        bool capture_start;
+        int run = ChaosRecord::getRun(position, x_channel, &x, &capture_start);
+        if(run == 0) {
+            break;
+        }
+        ChaosRecord::getRun(position, y_channel, &y, &capture_start);
+        ChaosRecord::getRun(position, z_channel, &z, &capture_start);
+        if(capture_start && n > line_start) {
+            raster.drawShadedLines(points + line_start, shades + line_start, n - line_start, colour_map);
+            line_start = n;
+        }
+        view.transform(x, y, z, run, points + n, shades + n);
+        n += run;
+        position += run;
+    }
+    if(n > line_start) {
+        raster.drawShadedLines(points + line_start, shades + line_start, n - line_start, colour_map);
+    }
+    return n;
+}
+
+void Rotating3dPlot::drawOverlay() {
     /**
-    *   Converts an x point on the graph to an ADC value.
-    *   This is a very important function that is used by the parent class
-    *   (ChaosPlot) for zooming.
+    *   Names the guides on top of the trajectory
     */
-    if ( graph_width == 0) {
-        return 1;
+    ChaosPlot::drawOverlay();
+    if(device_connected == false) {
+        return;
+    }
+    const int channels[3] = { x_channel, y_channel, z_channel };
+    for(int axis = 0; axis < 3; axis++) {
+        float end[3] = { centre[0], centre[1], centre[2] };
+        end[axis] += GUIDE_LENGTH;
+        wxPoint label = view.transformPoint(end[0], end[1], end[2]);
+        buffer->DrawText(ChaosChannels::getName(channels[axis]), label.x + 2, label.y - 7);
     }
-    return ((x - side_gutter_size)*(largest_x_value - smallest_x_value))/graph_width + smallest_x_value;
 }
 
-int Rotating3dPlot::yToValue(int y) {
+void Rotating3dPlot::updateCentre() {
     /**
-    *   Converts a y point on the graph to an ADC value.
-    *   This is a very important function that is used by the parent class
-    *   (ChaosPlot) for zooming.
+    *   Moves the centre of the view a quarter of the way to the mean of
+    *   each new capture.  The mean of a chaotic trajectory wanders a
+    *   little from capture to capture, and easing towards it keeps the
+    *   view from shaking.
     */
-    if ( graph_height == 0) {
-        return 1;
+    if(centre_valid && centre_generation == ChaosCapture::getGeneration()) {
+        return;
+    }
+    centre_generation = ChaosCapture::getGeneration();
+
+    int num_points = ChaosCapture::getNumPoints();
+    if(num_points == 0) {
+        return;
+    }
+    const int channels[3] = { x_channel, y_channel, z_channel };
+    for(int axis = 0; axis < 3; axis++) {
+        const short* data = ChaosChannels::getChannel(channels[axis]);
+        long long sum = 0;
+        for(int i = 0; i < num_points; i++) {
+            sum += data[i];
+        }
+        float mean = float(sum)/num_points;
+        centre[axis] = centre_valid ? centre[axis] + 0.25f*(mean - centre[axis]) : mean;
+    }
+    centre_valid = true;
+}
+
+void Rotating3dPlot::drawGuides() {
+    /**
+    *   Draws a short grey line from the centre along each channel so the
+    *   orientation of the view can be seen
+    */
+    raster.setColour(*wxLIGHT_GREY);
+    wxPoint origin = view.transformPoint(centre[0], centre[1], centre[2]);
+    for(int axis = 0; axis < 3; axis++) {
+        float end[3] = { centre[0], centre[1], centre[2] };
+        end[axis] += GUIDE_LENGTH;
+        wxPoint guide[2] = { origin, view.transformPoint(end[0], end[1], end[2]) };
+        raster.drawLines(guide, 2);
     }
-    return ((graph_height + top_gutter_size - y)*(largest_y_value - smallest_y_value))/graph_height + smallest_y_value;
 }
 
 void Rotating3dPlot::zoomDefault() {
     /**
-    *   Resets the zoom to the default values.
+    *   Resets the view to look along the third channel, unzoomed.
     */
-    largest_x_value = 1024;
-    smallest_x_value = -218;
-    smallest_y_value = 0;
-    largest_y_value = 1024;
+    yaw = 0;
+    pitch = 0;
+    zoom = 1;
+    invalidate();
 }
 
 void Rotating3dPlot::timer1Timer(wxTimerEvent& event) {
     /**
     *   Event handler for the rotation timer.
-    *   Timer for rotating the graph. All we need to do here is keep track
-    *   of the ticks.
+    *   Turns the view a step about the vertical axis and asks for a new
+    *   frame.  The view is left alone while it is being turned with the
+    *   mouse.
+    */
+    if(rotating) {
+        return;
+    }
+    yaw += 2*pi/ROTATION_STEPS;
+    if(yaw > 2*pi) {
+        yaw -= 2*pi;
+    }
+    invalidate();
+}
+
+void Rotating3dPlot::OnRotateStart(wxMouseEvent& evt) {
+    /**
+    *   Event handler for the mouse down on the plot, starts turning the
+    *   view with the mouse
+    */
+    rotating = true;
+    rotate_last = evt.GetPosition();
+    CaptureMouse();
+}
+
+void Rotating3dPlot::OnRotateMove(wxMouseEvent& evt) {
+    /**
+    *   Event handler for the mouse moving over the plot.  Dragging across
+    *   turns the view about the vertical axis and dragging up and down
+    *   tilts it, up to looking straight down or up.
+    */
+    if(rotating == false) {
+        return;
+    }
+    wxPoint position = evt.GetPosition();
+    yaw += DRAG_RADIANS*(position.x - rotate_last.x);
+    pitch += DRAG_RADIANS*(position.y - rotate_last.y);
+    if(pitch > pi/2) pitch = pi/2;
+    if(pitch < -pi/2) pitch = -pi/2;
+    rotate_last = position;
+    invalidate();
+}
+
+void Rotating3dPlot::OnRotateEnd(wxMouseEvent& evt) {
+    /**
+    *   Event handler for the mouse up on the plot, stops turning the view
+    */
+    rotating = false;
+    if(HasCapture()) {
+        ReleaseMouse();
+    }
+}
+
+void Rotating3dPlot::OnCaptureLost(wxMouseCaptureLostEvent& evt) {
+    /**
+    *   Event handler for losing the mouse in the middle of a drag, for
+    *   instance when switching to another window.  Stops turning the view.
     */
-    timer_ticks++;
+    rotating = false;
+}
+
+void Rotating3dPlot::OnWheel(wxMouseEvent& evt) {
+    /**
+    *   Event handler for the mouse wheel, zooms in or out by a tenth for
+    *   each notch
+    */
+    if(evt.GetWheelDelta() == 0) {
+        return;
+    }
+    zoom *= pow(1.1f, float(evt.GetWheelRotation())/evt.GetWheelDelta());
+    if(zoom < 0.1f) zoom = 0.1f;
+    if(zoom > 20) zoom = 20;
+    invalidate();
 }
 
 void Rotating3dPlot::setPause(bool paused) {
@@ -179,15 +376,46 @@ void Rotating3dPlot::setPause(bool paused) {
     if(paused == true) {
         timer1->Stop();
     } else {
-        timer1->Start(200);
+        timer1->Start(ROTATION_PERIOD);
     }
 }
 
+void Rotating3dPlot::setPerspective(bool perspective) {
+    /**
+    *   Chooses between a perspective and an orthographic projection
+    */
+    this->perspective = perspective;
+    invalidate();
+}
+
+void Rotating3dPlot::setChannels(int x_channel, int y_channel, int z_channel) {
+    /**
+    *   Sets the channels drawn across, up and into the graph.  The view
+    *   centres itself again on the new channels.
+    */
+    this->x_channel = x_channel;
+    this->y_channel = y_channel;
+    this->z_channel = z_channel;
+    centre_valid = false;
+    invalidate();
+}
+
+int Rotating3dPlot::getChannel(int axis) {
+    /**
+    *   Returns the channel drawn along an axis, 0 across, 1 up and 2 into
+    *   the graph
+    */
+    if(axis == 0) return x_channel;
+    if(axis == 1) return y_channel;
+    return z_channel;
+}
+
 void Rotating3dPlot::setRotation(int rotation) {
     /**
-    *   Sets the rotation of the graph to a specified number. This number
-    *   (between 1 and 25) represents the steps through a full rotation
-    *   of the graph.
+    *   Sets the rotation of the graph about the vertical axis to a
+    *   specified number. This number (between 0 and 25) represents the
+    *   steps through a full rotation of the graph.
     */
-    timer_ticks = rotation;
+    yaw = rotation*2*pi/SLIDER_STEPS;
+    invalidate();
 }
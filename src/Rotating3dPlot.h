@@ -8,6 +8,7 @@
 
 #include "ChaosPlot.h" // inheriting class's header file
 #include "libchaos.h"
+#include "ViewTransform.h"
 
 class Rotating3dPlot : public ChaosPlot
 {
@@ -24,21 +25,56 @@ class Rotating3dPlot : public ChaosPlot
         void drawPlot();
         void setPause(bool paused);
         void setRotation(int rotation);
+        void setPerspective(bool perspective);
+        void setChannels(int x_channel, int y_channel, int z_channel);
+        int getChannel(int axis);
     
     private:
-        int xToValue(int x);
-        int yToValue(int y);
-        int valueToX(int value);
-        int valueToY(int value);
         void zoomDefault();
+        void updateCentre();
+        void reserve(int num_points);
+        int drawCapture();
+        int drawRecord();
+        void drawGuides();
+        void drawOverlay();
         void timer1Timer(wxTimerEvent& event);
+        void OnRotateStart(wxMouseEvent& evt);
+        void OnRotateMove(wxMouseEvent& evt);
+        void OnRotateEnd(wxMouseEvent& evt);
+        void OnCaptureLost(wxMouseCaptureLostEvent& evt);
+        void OnWheel(wxMouseEvent& evt);
         
         wxTimer *timer1;
-        unsigned int timer_ticks;
+        
+        // Orientation of the view in radians and how far it is zoomed in
+        float yaw;
+        float pitch;
+        float zoom;
+        bool perspective;
+        ViewTransform view;
+        
+        // Last mouse position while the view is being dragged round
+        bool rotating;
+        wxPoint rotate_last;
+        
+        // Point the view turns about, following the middle of the captures
+        float centre[3];
+        bool centre_valid;
+        unsigned int centre_generation;
+        
+        // Depth shade of each point and the colours they map to
+        unsigned char* shades;
+        int allocated_shades;
+        unsigned char colour_map[3*VIEW_SHADES];
+        
+        // Channels drawn across, up and into the graph
+        int x_channel;
+        int y_channel;
+        int z_channel;
         
         enum {
             ID_TIMER1 = 1000,
         };
 };
 
-#endif // XYPLOT_H
+#endif // ROTATING_3DPLOT_H
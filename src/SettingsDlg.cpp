@@ -7,6 +7,11 @@
 #include "SettingsDlg.h"
 #include "libchaos.h"
 #include "ChaosSettings.h"
+#include "ChaosRecord.h"
+#include "ChaosSpectrum.h"
+#include "ChaosPlot.h"
+#include "ChaosChannels.h"
+#include "ChaosConnectFrm.h"
 
 using namespace ChaosSettings;
 
@@ -87,6 +92,17 @@ void SettingsDlg::CreateGUIControls() {
                                3,point_size_radio_list);
     panelVertSizer->Add(pointSizeRadio,0,wxALIGN_LEFT | wxALL,5);
 
+    // Spectrum calculation
+    wxString spectrum_radio_list[2] = { 
+        wxT("libchaos (Floating Point)"), 
+        wxT("Fixed Point (Faster)")
+        }; 
+    spectrumRadio = new wxRadioBox(WxPanel1, ID_SPECTRUMRADIO, 
+                               wxT("FFT Calculation"), 
+                               wxDefaultPosition, wxDefaultSize, 
+                               2,spectrum_radio_list);
+    panelVertSizer->Add(spectrumRadio,0,wxALIGN_LEFT | wxALL,5);
+
     // Steps
     stepsSizer = new wxBoxSizer(wxHORIZONTAL);
     panelVertSizer->Add(stepsSizer,0,wxALIGN_LEFT | wxALL,5);
@@ -151,6 +167,22 @@ void SettingsDlg::CreateGUIControls() {
                                   wxSP_ARROW_KEYS, 0, 24, 4);
     transientSizer->Add(transientSpinner,0,wxALIGN_LEFT | wxALL,5);
     
+    // Memory for the long capture record
+    recordSizer = new wxBoxSizer(wxHORIZONTAL);
+    panelVertSizer->Add(recordSizer,0,wxALIGN_LEFT | wxALL,5);
+    
+    recordLabel = new wxStaticText(WxPanel1, ID_RECORDLABEL, 
+                                  wxT("Long Capture Memory (MB)"),
+                                  wxDefaultPosition, wxDefaultSize, 
+                                  0);
+    recordSizer->Add(recordLabel,0,wxALIGN_LEFT | wxALL,5);
+    
+    recordSpinner = new wxSpinCtrl(WxPanel1, ID_RECORDSPINNER, 
+                                  wxT("32"), 
+                                  wxDefaultPosition, wxDefaultSize, 
+                                  wxSP_ARROW_KEYS, 1, 1024, 32);
+    recordSizer->Add(recordSpinner,0,wxALIGN_LEFT | wxALL,5);
+    
     // GUI Refresh Time
     refreshSizer = new wxBoxSizer(wxHORIZONTAL);
     panelVertSizer->Add(refreshSizer,0,wxALIGN_LEFT | wxALL,5);
@@ -167,6 +199,19 @@ void SettingsDlg::CreateGUIControls() {
                                   wxSP_ARROW_KEYS, 100, 2000, 300);
     refreshSizer->Add(refreshSpinner,0,wxALIGN_LEFT | wxALL,5);
     
+    // Derived channels
+    channelsLabel = new wxStaticText(WxPanel1, ID_CHANNELSLABEL, 
+                                  wxT("Derived Channels (name = expression, one per line)"),
+                                  wxDefaultPosition, wxDefaultSize, 
+                                  0);
+    panelVertSizer->Add(channelsLabel,0,wxALIGN_LEFT | wxALL,5);
+    
+    channelsText = new wxTextCtrl(WxPanel1, ID_CHANNELSTEXT, 
+                                  wxEmptyString, 
+                                  wxDefaultPosition, wxSize(360, 110), 
+                                  wxTE_MULTILINE);
+    panelVertSizer->Add(channelsText,0,wxEXPAND | wxALL,5);
+    
     // Buttons (OK|CANCEL|APPLY)
     buttonSizer = new wxBoxSizer(wxHORIZONTAL);
     panelVertSizer->Add(buttonSizer,0,wxALIGN_RIGHT | wxALL,5);
@@ -207,10 +252,12 @@ void SettingsDlg::OnApply(wxCommandEvent& event) {
 void SettingsDlg::OnOk(wxCommandEvent& event) {
     /**
     *   Event handler for the OK button
-    *   Applies the current settings and closes the Dialog
+    *   Applies the current settings and closes the Dialog. The dialog
+    *   stays open if the derived channels could not be parsed.
     */
-    updateSettings();
-    Destroy();
+    if(updateSettings()) {
+        Destroy();
+    }
 }
 
 void SettingsDlg::OnCancel(wxCommandEvent& event) {
@@ -221,10 +268,12 @@ void SettingsDlg::OnCancel(wxCommandEvent& event) {
     Destroy();
 }
 
-void SettingsDlg::updateSettings() {
+bool SettingsDlg::updateSettings() {
     /**
     *   Reads the controls on the dialog and updates the settings in the
-    *   ChaosSettings namespace accordingly.
+    *   ChaosSettings namespace accordingly. Returns false if the derived
+    *   channels were rejected, in which case the other settings are
+    *   still applied.
     */
     BifXAxis = mdacRadio->GetSelection();
     YAxisLabels = adcRadio->GetSelection();
@@ -241,6 +290,11 @@ void SettingsDlg::updateSettings() {
             break;
     }
     
+    if(SpectrumMode != spectrumRadio->GetSelection()) {
+        SpectrumMode = spectrumRadio->GetSelection();
+        ChaosSpectrum::setMode(SpectrumMode);
+    }
+    
     BifStepsPerWindow = stepsSpinner->GetValue();
     
     if(PeaksPerMdac != peaksSpinner->GetValue()) {
@@ -253,9 +307,78 @@ void SettingsDlg::updateSettings() {
 
     TransientPoints = transientSpinner->GetValue();
     libchaos_setTransientData(TransientPoints);
+    
+    if(RecordMemory != recordSpinner->GetValue()) {
+        RecordMemory = recordSpinner->GetValue();
+        ChaosRecord::setMemoryLimit(RecordMemory);
+    }
 
     UpdatePeriod = refreshSpinner->GetValue();
     ChaosSettings::BifRedraw = true;
+    ChaosPlot::invalidateAll();
+    
+    return updateChannels();
+}
+
+bool SettingsDlg::updateChannels() {
+    /**
+    *   Parses the derived channel text, one "name = expression" per line,
+    *   and replaces the derived channels if anything changed. The new
+    *   definitions are saved and the panels showing channel choices are
+    *   rebuilt. On an error the old channels are kept and the problem is
+    *   shown to the user.
+    */
+    wxArrayString names;
+    wxArrayString expressions;
+    wxString text = channelsText->GetValue();
+    int line_number = 0;
+    
+    while(text.IsEmpty() == false) {
+        wxString line = text.BeforeFirst(wxT('\n'));
+        text = text.AfterFirst(wxT('\n'));
+        line_number++;
+        
+        line.Trim(true);
+        line.Trim(false);
+        if(line.IsEmpty()) {
+            continue;
+        }
+        
+        if(line.Find(wxT('=')) == wxNOT_FOUND) {
+            wxMessageBox(wxString::Format(wxT("Line %d should be written as name = expression."), line_number),
+                         wxT("Derived Channels"), wxOK | wxICON_ERROR, this);
+            return false;
+        }
+        
+        wxString name = line.BeforeFirst(wxT('='));
+        wxString expression = line.AfterFirst(wxT('='));
+        names.Add(name.Trim(true));
+        expressions.Add(expression.Trim(false));
+    }
+    
+    // Leave the channels alone if nothing was edited so open plots keep
+    // their selections
+    int num_derived = ChaosChannels::getNumChannels() - ChaosCapture::NUM_CHANNELS;
+    bool changed = (int(names.GetCount()) != num_derived);
+    for(int i = 0; changed == false && i < num_derived; i++) {
+        if(names[i] != ChaosChannels::getName(ChaosCapture::NUM_CHANNELS + i) ||
+           expressions[i] != ChaosChannels::getExpression(ChaosCapture::NUM_CHANNELS + i)) {
+            changed = true;
+        }
+    }
+    if(changed == false) {
+        return true;
+    }
+    
+    wxString error;
+    if(ChaosChannels::setDefinitions(names, expressions, error) == false) {
+        wxMessageBox(error, wxT("Derived Channels"), wxOK | wxICON_ERROR, this);
+        return false;
+    }
+    
+    ChaosChannels::save();
+    ((ChaosConnectFrm*)GetParent())->channelsChanged();
+    return true;
 }
 
 void SettingsDlg::loadSettings() {
@@ -281,9 +404,18 @@ void SettingsDlg::loadSettings() {
             break;
     }
 
+    spectrumRadio->SetSelection(SpectrumMode);
     stepsSpinner->SetValue(BifStepsPerWindow);
     peaksSpinner->SetValue(PeaksPerMdac);
     amountSpinner->SetValue(PointsPerSample/1020);
     transientSpinner->SetValue(TransientPoints);
+    recordSpinner->SetValue(RecordMemory);
     refreshSpinner->SetValue(UpdatePeriod);
+    
+    wxString channels;
+    for(int i = ChaosCapture::NUM_CHANNELS; i < ChaosChannels::getNumChannels(); i++) {
+        channels += ChaosChannels::getName(i) + wxT(" = ") + 
+                    ChaosChannels::getExpression(i) + wxT("\n");
+    }
+    channelsText->SetValue(channels);
 }
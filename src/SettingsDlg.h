@@ -22,6 +22,7 @@
 #include <wx/button.h>
 #include <wx/spinctrl.h>
 #include <wx/stattext.h>
+#include <wx/textctrl.h>
 #include <wx/panel.h>
 #include <wx/sizer.h>
 #include "wx/progdlg.h"
@@ -43,7 +44,8 @@ class SettingsDlg : public wxDialog
         void OnOk(wxCommandEvent& event);
         void OnCancel(wxCommandEvent& event);
         
-        void updateSettings();
+        bool updateSettings();
+        bool updateChannels();
         void loadSettings();
         
         wxBoxSizer *mainVertSizer;
@@ -56,6 +58,8 @@ class SettingsDlg : public wxDialog
         
         wxRadioBox *pointSizeRadio;
         
+        wxRadioBox *spectrumRadio;
+        
         wxBoxSizer *stepsSizer;
         wxStaticText *stepsLabel;
         wxSpinCtrl *stepsSpinner;
@@ -72,10 +76,17 @@ class SettingsDlg : public wxDialog
         wxStaticText *transientLabel;
         wxSpinCtrl *transientSpinner;
 
+        wxBoxSizer *recordSizer;
+        wxStaticText *recordLabel;
+        wxSpinCtrl *recordSpinner;
+
         wxBoxSizer *refreshSizer;
         wxStaticText *refreshLabel;
         wxSpinCtrl *refreshSpinner;
 
+        wxStaticText *channelsLabel;
+        wxTextCtrl *channelsText;
+
         wxBoxSizer *buttonSizer;
         wxButton *buttonOk;
         wxButton *buttonCancel;
@@ -91,6 +102,7 @@ class SettingsDlg : public wxDialog
             ID_MDACRADIO,
             ID_ADCRADIO,
             ID_POINTSIZERADIO,
+            ID_SPECTRUMRADIO,
             ID_STEPSLABEL,
             ID_STEPSSPINNER,
             ID_PEAKSLABEL,
@@ -99,8 +111,12 @@ class SettingsDlg : public wxDialog
             ID_AMOUNTSPINNER,
             ID_TRANSIENTLABEL,
             ID_TRANSIENTSPINNER,
+            ID_RECORDLABEL,
+            ID_RECORDSPINNER,
             ID_REFRESHLABEL,
             ID_REFRESHSPINNER,
+            ID_CHANNELSLABEL,
+            ID_CHANNELSTEXT,
             ID_BUTTONOK,
             ID_BUTTONCANCEL,
             ID_BUTTONAPPLY,
@@ -0,0 +1,98 @@
+/**
+ * \file TraceDecimation.cpp
+ * \brief Reduces traces to the minimum and maximum of each pixel column
+ */
+
+#include "TraceDecimation.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Samples a column must hold before it is reduced.  With fewer there is
+// nothing to gain and the samples are copied as they are.
+#define DECIMATE_MIN_SAMPLES 5
+
+namespace TraceDecimation {
+    void findRange(const short* data, int count, int& minimum, int& maximum) {
+        /**
+        *   Finds the lowest and highest of count samples.  With SSE2 eight
+        *   samples are compared at a time.
+        */
+        int low = data[0];
+        int high = data[0];
+        int i = 0;
+#ifdef __SSE2__
+        if(count >= 8) {
+            __m128i vmin = _mm_loadu_si128((const __m128i*)data);
+            __m128i vmax = vmin;
+            for(i = 8; i + 8 <= count; i += 8) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+                vmin = _mm_min_epi16(vmin, x);
+                vmax = _mm_max_epi16(vmax, x);
+            }
+            short lanes[8];
+            _mm_storeu_si128((__m128i*)lanes, vmin);
+            for(int k = 0; k < 8; k++) {
+                if(lanes[k] < low) low = lanes[k];
+            }
+            _mm_storeu_si128((__m128i*)lanes, vmax);
+            for(int k = 0; k < 8; k++) {
+                if(lanes[k] > high) high = lanes[k];
+            }
+        }
+#endif
+        for(; i < count; i++) {
+            if(data[i] < low) low = data[i];
+            if(data[i] > high) high = data[i];
+        }
+        minimum = low;
+        maximum = high;
+    }
+
+    int decimate(const short* data, int num_points, float x_scale, wxPoint* points) {
+        /**
+        *   Walks the trace a column at a time.  The end of each column is
+        *   estimated from the scale and then settled with the same
+        *   expression the caller uses to place samples, so that no sample
+        *   changes column.
+        */
+        int used = 0;
+        int start = 0;
+        while(start < num_points) {
+            int column = (int)(x_scale*start);
+            int end = x_scale > 0 ? (int)((column + 1)/x_scale) : num_points;
+            if(end <= start) end = start + 1;
+            if(end > num_points) end = num_points;
+            while(end > start + 1 && (int)(x_scale*(end - 1)) != column) {
+                end--;
+            }
+            while(end < num_points && (int)(x_scale*end) == column) {
+                end++;
+            }
+
+            int count = end - start;
+            if(count < DECIMATE_MIN_SAMPLES) {
+                for(int i = start; i < end; i++) {
+                    points[used].x = column;
+                    points[used].y = data[i];
+                    used++;
+                }
+            } else {
+                int minimum, maximum;
+                findRange(data + start, count, minimum, maximum);
+                points[used].x = column;
+                points[used].y = data[start];
+                points[used+1].x = column;
+                points[used+1].y = minimum;
+                points[used+2].x = column;
+                points[used+2].y = maximum;
+                points[used+3].x = column;
+                points[used+3].y = data[end - 1];
+                used += 4;
+            }
+            start = end;
+        }
+        return used;
+    }
+}
@@ -0,0 +1,29 @@
+/**
+ * \file TraceDecimation.h
+ * \brief Headers for TraceDecimation.cpp
+ */
+
+#ifndef TRACEDECIMATION_H
+#define TRACEDECIMATION_H
+
+#include <wx/gdicmn.h>
+
+namespace TraceDecimation {
+    /**
+    *   Namespace for reducing a trace plotted against time to what can be
+    *   seen of it.  When several samples land in one pixel column the
+    *   segments joining them are all vertical, so together they cover the
+    *   column from the lowest sample to the highest.  Keeping only the
+    *   first, lowest, highest and last sample of each column therefore
+    *   draws exactly the same pixels, and the number of points drawn is
+    *   bounded by the width of the plot rather than the number of samples.
+    */
+
+    // Reduces num_points samples, sample i being drawn in column
+    // (int)(x_scale*i), to at most four points per column.  Each point
+    // gets its column in x and its sample value in y.  points must have
+    // room for num_points points; the number used is returned.
+    extern int decimate(const short* data, int num_points, float x_scale, wxPoint* points);
+}
+
+#endif // TRACEDECIMATION_H
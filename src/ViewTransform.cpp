@@ -0,0 +1,202 @@
+/**
+ * \file ViewTransform.cpp
+ * \brief Rotates and projects three channels of points onto a plot
+ */
+
+#include <math.h>
+#include <string.h>
+#include "ViewTransform.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Distance of the eye from the centre for the perspective projection, in
+// data units.  About twice the size of the attractor gives a clear sense
+// of depth without distorting it much.
+#define VIEW_DISTANCE 2000.0f
+
+// Depth either side of the centre over which the shades run
+#define VIEW_DEPTH 600.0f
+
+ViewTransform::ViewTransform() {
+    /**
+    *   Constructor for the ViewTransform class.
+    *
+    *   Each frame the rotation, projection and scaling onto the plot are
+    *   folded into a single 3x4 matrix by update().  transform() then
+    *   takes three arrays of channel values to plot coordinates with one
+    *   pass of multiply-adds per point, four points at a time with SSE2.
+    *   It also gives each point a shade from its depth, so the near side
+    *   of a trajectory can be drawn darker than the far side.
+    */
+    centre[0] = centre[1] = centre[2] = 0;
+    yaw = 0;
+    pitch = 0;
+    perspective = false;
+    viewport_x = 0;
+    viewport_y = 0;
+    scale = 1;
+    update();
+}
+
+void ViewTransform::setCentre(float x, float y, float z) {
+    /**
+    *   Sets the point in the data that the view turns about and that is
+    *   placed at the centre of the viewport
+    */
+    centre[0] = x;
+    centre[1] = y;
+    centre[2] = z;
+}
+
+void ViewTransform::setRotation(float yaw, float pitch) {
+    /**
+    *   Sets the turn about the vertical axis and then the tilt about the
+    *   horizontal axis of the screen, both in radians
+    */
+    this->yaw = yaw;
+    this->pitch = pitch;
+}
+
+void ViewTransform::setProjection(bool perspective) {
+    /**
+    *   Chooses between an orthographic and a perspective projection
+    */
+    this->perspective = perspective;
+}
+
+void ViewTransform::setViewport(float centre_x, float centre_y, float scale) {
+    /**
+    *   Sets where the centre of the view lands on the plot, in pixels, and
+    *   the number of pixels per data unit at the depth of the centre
+    */
+    viewport_x = centre_x;
+    viewport_y = centre_y;
+    this->scale = scale;
+}
+
+void ViewTransform::update() {
+    /**
+    *   Builds the matrix from the settings, call once per frame before
+    *   transforming.  The rotation turns by yaw about the vertical axis
+    *   and then tilts by pitch about the horizontal one.  Screen y runs
+    *   down the plot, so its row is negated.
+    */
+    float cy = cos(yaw), sy = sin(yaw);
+    float cp = cos(pitch), sp = sin(pitch);
+    float rotation[3][3] = {
+        { cy,      0,   sy      },
+        { sp*sy,   cp,  -sp*cy  },
+        { -cp*sy,  sp,  cp*cy   }
+    };
+    float row_scale[3] = { scale, -scale, 1 };
+
+    for(int r = 0; r < 3; r++) {
+        float offset = 0;
+        for(int c = 0; c < 3; c++) {
+            matrix[r][c] = row_scale[r]*rotation[r][c];
+            offset -= matrix[r][c]*centre[c];
+        }
+        matrix[r][3] = offset;
+    }
+}
+
+void ViewTransform::transform(const short* x, const short* y, const short* z, int num_points,
+                              wxPoint* points, unsigned char* shades) {
+    /**
+    *   Takes num_points values of each channel to plot coordinates and
+    *   depth shades.  The perspective divide is skipped for an
+    *   orthographic view.  Points right up against the eye are held at a
+    *   tenth of the eye distance so nothing is divided by zero.
+    */
+    const float* m0 = matrix[0];
+    const float* m1 = matrix[1];
+    const float* m2 = matrix[2];
+    const float shade_scale = (VIEW_SHADES/2 - 1)/VIEW_DEPTH;
+    const float shade_offset = VIEW_SHADES/2;
+    int i = 0;
+
+#ifdef __SSE2__
+    // Relies on wxPoint being an x then a y int, so pairs of points can
+    // be stored with one interleaved write
+    if(sizeof(wxPoint) == 2*sizeof(int)) {
+        __m128 a0 = _mm_set1_ps(m0[0]), a1 = _mm_set1_ps(m0[1]), a2 = _mm_set1_ps(m0[2]), a3 = _mm_set1_ps(m0[3]);
+        __m128 b0 = _mm_set1_ps(m1[0]), b1 = _mm_set1_ps(m1[1]), b2 = _mm_set1_ps(m1[2]), b3 = _mm_set1_ps(m1[3]);
+        __m128 c0 = _mm_set1_ps(m2[0]), c1 = _mm_set1_ps(m2[1]), c2 = _mm_set1_ps(m2[2]), c3 = _mm_set1_ps(m2[3]);
+        __m128 view_x = _mm_set1_ps(viewport_x);
+        __m128 view_y = _mm_set1_ps(viewport_y);
+        __m128 distance = _mm_set1_ps(VIEW_DISTANCE);
+        __m128 nearest = _mm_set1_ps(0.1f*VIEW_DISTANCE);
+        __m128 shade_a = _mm_set1_ps(shade_scale);
+        __m128 shade_b = _mm_set1_ps(shade_offset);
+
+        for(; i + 4 <= num_points; i += 4) {
+            // Sign extend four shorts of each channel and make them floats
+            __m128i xi = _mm_loadl_epi64((const __m128i*)(x + i));
+            __m128i yi = _mm_loadl_epi64((const __m128i*)(y + i));
+            __m128i zi = _mm_loadl_epi64((const __m128i*)(z + i));
+            __m128 xf = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(xi, xi), 16));
+            __m128 yf = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(yi, yi), 16));
+            __m128 zf = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(zi, zi), 16));
+
+            __m128 sx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, xf), _mm_mul_ps(a1, yf)),
+                                   _mm_add_ps(_mm_mul_ps(a2, zf), a3));
+            __m128 sy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, xf), _mm_mul_ps(b1, yf)),
+                                   _mm_add_ps(_mm_mul_ps(b2, zf), b3));
+            __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, xf), _mm_mul_ps(c1, yf)),
+                                      _mm_add_ps(_mm_mul_ps(c2, zf), c3));
+            if(perspective) {
+                __m128 w = _mm_div_ps(distance, _mm_max_ps(_mm_sub_ps(distance, depth), nearest));
+                sx = _mm_mul_ps(sx, w);
+                sy = _mm_mul_ps(sy, w);
+            }
+            __m128i px = _mm_cvtps_epi32(_mm_add_ps(sx, view_x));
+            __m128i py = _mm_cvtps_epi32(_mm_add_ps(sy, view_y));
+            _mm_storeu_si128((__m128i*)(points + i), _mm_unpacklo_epi32(px, py));
+            _mm_storeu_si128((__m128i*)(points + i + 2), _mm_unpackhi_epi32(px, py));
+
+            // Saturating packs clamp the shades to 0..255
+            __m128i shade = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(depth, shade_a), shade_b));
+            shade = _mm_packs_epi32(shade, shade);
+            shade = _mm_packus_epi16(shade, shade);
+            int four_shades = _mm_cvtsi128_si32(shade);
+            memcpy(shades + i, &four_shades, 4);
+        }
+    }
+#endif
+
+    for(; i < num_points; i++) {
+        float sx = m0[0]*x[i] + m0[1]*y[i] + m0[2]*z[i] + m0[3];
+        float sy = m1[0]*x[i] + m1[1]*y[i] + m1[2]*z[i] + m1[3];
+        float depth = m2[0]*x[i] + m2[1]*y[i] + m2[2]*z[i] + m2[3];
+        if(perspective) {
+            float distance = VIEW_DISTANCE - depth;
+            if(distance < 0.1f*VIEW_DISTANCE) {
+                distance = 0.1f*VIEW_DISTANCE;
+            }
+            sx *= VIEW_DISTANCE/distance;
+            sy *= VIEW_DISTANCE/distance;
+        }
+        points[i].x = (int)floor(sx + viewport_x + 0.5f);
+        points[i].y = (int)floor(sy + viewport_y + 0.5f);
+
+        int shade = (int)floor(depth*shade_scale + shade_offset + 0.5f);
+        if(shade < 0) shade = 0;
+        if(shade > VIEW_SHADES - 1) shade = VIEW_SHADES - 1;
+        shades[i] = (unsigned char)shade;
+    }
+}
+
+wxPoint ViewTransform::transformPoint(float x, float y, float z) {
+    /**
+    *   Takes a single point to plot coordinates, for drawing guides
+    */
+    short xs = (short)floor(x + 0.5f);
+    short ys = (short)floor(y + 0.5f);
+    short zs = (short)floor(z + 0.5f);
+    wxPoint point;
+    unsigned char shade;
+    transform(&xs, &ys, &zs, 1, &point, &shade);
+    return point;
+}
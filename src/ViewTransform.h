@@ -0,0 +1,46 @@
+/**
+ * \file ViewTransform.h
+ * \brief Headers for ViewTransform.cpp
+ */
+
+#ifndef VIEWTRANSFORM_H
+#define VIEWTRANSFORM_H
+
+#include <wx/gdicmn.h>
+
+// Shades a transformed point can be given, nearest is the highest
+#define VIEW_SHADES 256
+
+class ViewTransform
+{
+    public:
+        ViewTransform();
+        void setCentre(float x, float y, float z);
+        void setRotation(float yaw, float pitch);
+        void setProjection(bool perspective);
+        void setViewport(float centre_x, float centre_y, float scale);
+        void update();
+        void transform(const short* x, const short* y, const short* z, int num_points,
+                       wxPoint* points, unsigned char* shades);
+        wxPoint transformPoint(float x, float y, float z);
+
+    private:
+        // Point in the data the view turns about
+        float centre[3];
+
+        // Turn about the vertical axis then tilt towards the viewer
+        float yaw;
+        float pitch;
+        bool perspective;
+
+        // Where the centre lands on the plot and pixels per data unit
+        float viewport_x;
+        float viewport_y;
+        float scale;
+
+        // Rows give the screen x and y before projection, already scaled
+        // to pixels, and the depth towards the viewer in data units
+        float matrix[3][4];
+};
+
+#endif // VIEWTRANSFORM_H
@@ -3,8 +3,13 @@
  * \brief Implements class for drawing the XT plots
  */
 
+#include <stdlib.h>
 #include "XTPlot.h"
 #include "ChaosSettings.h"
+#include "ChaosCalibration.h"
+#include "ChaosCapture.h"
+#include "ChaosChannels.h"
+#include "TraceDecimation.h"
 
 XTPlot::XTPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
                        const wxSize& size, long style, const wxString& name) 
@@ -17,6 +22,20 @@ XTPlot::XTPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
     x1Visible = true;
     x2Visible = false;
     x3Visible = false;
+    averaging = false;
+    show_envelope = false;
+    old_mdac = 0;
+    derived_channel = -1;
+    span = AVERAGE_POINTS;
+    decimated_points = NULL;
+    allocated_points = 0;
+    
+    const wxColour* colours[ChaosCapture::NUM_CHANNELS] = { wxRED, wxBLUE, wxGREEN };
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        trace_pens[c] = wxPen(*colours[c], 2);
+        envelope_pens[c] = wxPen(*colours[c], 1, wxDOT);
+    }
+    derived_pen = wxPen(wxColour(160, 0, 160), 2);
     graph_title = wxT("Waveform as a function of time");
     graph_subtitle = wxT("X (V) vs. T(ms)");
 }
@@ -25,6 +44,7 @@ XTPlot::~XTPlot() {
     /**
     *   Deconstructor for the Rotating3dPlot class
     */
+    free(decimated_points);
 }
 
 void XTPlot::drawPlot() {
@@ -36,25 +56,42 @@ void XTPlot::drawPlot() {
     *   the user has selected.
     *
     */
-    const int xt_points = 300;
+    // The average is always AVERAGE_POINTS long, a single capture can
+    // be shown over a longer span
+    int xt_points = averaging ? AVERAGE_POINTS : span;
     
     // max time on the graph in ms
     float max_time = xt_points*(1/72000.0)*1000;
     
-    static int times_called = 0;
-    
-    int x1,x2,x1_old,x2_old, x3, x3_old;
     int start;
     
+    // The titles are settled before startDraw(), which only lays out the
+    // layer again when they differ from the last frame
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        graph_subtitle = wxT("X (ADC) vs. T(ms)");
+    } else {
+        graph_subtitle = wxT("X (V) vs. T(ms)");
+    }
+    if(derived_channel >= 0 && !averaging) {
+        graph_subtitle = graph_subtitle + wxT(", ") + ChaosChannels::getName(derived_channel);
+    }
+    
+    // The number of periods averaged changes with every capture, so it is
+    // drawn over the graph rather than put in the subtitle
+    if(averaging && device_connected) {
+        graph_note = wxString::Format(wxT("%d periods averaged"), average.getNumPeriods());
+    } else {
+        graph_note = wxEmptyString;
+    }
+    
     startDraw();
+    float y_min = ChaosCalibration::toUnits(ChaosCapture::X1, 0);
+    float y_max = ChaosCalibration::toUnits(ChaosCapture::X1, 1024);
     if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-        graph_subtitle = wxT("X (V) vs. T(ms)");
-        drawYAxis(0.0,3.3,1);
+        drawYAxis(y_min,y_max,1);
     } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-        graph_subtitle = wxT("X (V) vs. T(ms)");
-        drawYAxis(-1.2,2.1,.5);
+        drawYAxis(y_min,y_max,.5);
     } else {
-        graph_subtitle = wxT("X (ADC) vs. T(ms)");
         drawYAxis(0,1024,341);
     }
     drawXAxis(0,max_time,max_time/5.0);
@@ -64,6 +101,11 @@ void XTPlot::drawPlot() {
         return;
     }
     
+    if(old_mdac != device_mdac_value) {
+        average.clear();
+        old_mdac = device_mdac_value;
+    }
+    
     int plot_width = width-side_gutter_size-2;
     int plot_points;
     float x_scale;
@@ -72,59 +114,128 @@ void XTPlot::drawPlot() {
     plot_points = xt_points;
     x_scale = float(plot_width)/xt_points;
     
-    start = libchaos_getTriggerIndex();
-
-    // Get first plot point
-    libchaos_getPlotPoint(&x1,&x2,&x3, start);
-    x3 = graph_height + top_gutter_size - int(x3*y_scale);
-    x2 = graph_height + top_gutter_size - int(x2*y_scale);
-    x1 = graph_height + top_gutter_size - int(x1*y_scale);
-    x1_old = x1;
-    x2_old = x2;
-    x3_old = x3;
-        
-    for(int i = 1; i < plot_points; i++) {
-        libchaos_getPlotPoint(&x1,&x2,&x3, i+start);
-        x3 = graph_height + top_gutter_size - int(x3*y_scale);
-        x2 = graph_height + top_gutter_size - int(x2*y_scale);
-        x1 = graph_height + top_gutter_size - int(x1*y_scale);
-        
-        if(x1Visible == true) {
-            //Use red pen
-            wxPen rPen(*wxRED, 2); // red pen of width 2
-            buffer->SetPen(rPen);
-            buffer->DrawLine((int)(x_scale*(i-1)+side_gutter_size+1), x1_old, (int)(x_scale*i+side_gutter_size+1), x1);
-        }
-        
-        if(x2Visible == true) {
-            //Use blue pen
-            wxPen bPen(*wxBLUE, 2); // blue pen of width 2
-            buffer->SetPen(bPen);
-            buffer->DrawLine((int)(x_scale*(i-1)+side_gutter_size+1), x2_old, (int)(x_scale*i+side_gutter_size+1), x2);
+    if(averaging) {
+        drawAverage(x_scale, y_scale);
+        endDraw();
+        return;
+    }
+    
+    // Start at the trigger unless the span would then run off the end
+    start = ChaosCapture::getTriggerIndex();
+    if(start + plot_points > ChaosCapture::getNumPoints()) {
+        start = ChaosCapture::getNumPoints() - plot_points;
+        if(start < 0) {
+            start = 0;
+            plot_points = ChaosCapture::getNumPoints();
         }
-        
-        if(x3Visible == true) {
-            //Use green pen
-            wxPen gPen(*wxGREEN, 2); // blue pen of width 2
-            buffer->SetPen(gPen);
-            buffer->DrawLine((int)(x_scale*(i-1)+side_gutter_size+1), x3_old, (int)(x_scale*i+side_gutter_size+1), x3);
+    }
+
+    // Each channel is one polyline drawn with its own pen
+    bool visible[ChaosCapture::NUM_CHANNELS] = { x1Visible, x2Visible, x3Visible };
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        if(visible[c] == true) {
+            buffer->SetPen(trace_pens[c]);
+            drawChannel(c, start, plot_points, x_scale, y_scale);
         }
-        
-        x1_old = x1;
-        x2_old = x2;
-        x3_old = x3;
     }
-    times_called = 0;
+    
+    if(derived_channel >= 0) {
+        buffer->SetPen(derived_pen);
+        drawChannel(derived_channel, start, plot_points, x_scale, y_scale);
+    }
     
     // Display buffer
     endDraw();
 }
 
+void XTPlot::drawChannel(int channel, int start, int num_points, float x_scale, float y_scale) {
+    /**
+    *   Draws num_points values of a channel from start with the current pen.
+    *   The samples are first reduced to what can be seen in each pixel
+    *   column, so a long span costs no more to draw than a short one.
+    */
+    if(num_points < 2) {
+        return;
+    }
+    if(num_points > allocated_points) {
+        decimated_points = (wxPoint*)realloc(decimated_points, num_points*sizeof(wxPoint));
+        allocated_points = num_points;
+    }
+    
+    const short* data = ChaosChannels::getChannel(channel) + start;
+    int used = TraceDecimation::decimate(data, num_points, x_scale, decimated_points);
+    for(int i = 0; i < used; i++) {
+        decimated_points[i].x += side_gutter_size + 1;
+        decimated_points[i].y = graph_height + top_gutter_size - int(decimated_points[i].y*y_scale);
+    }
+    buffer->DrawLines(used, decimated_points);
+}
+
+void XTPlot::drawAverage(float x_scale, float y_scale) {
+    /**
+    *   Draws the average of the periods seen so far for each visible
+    *   channel.  With the envelope on, the lowest and highest value seen at
+    *   each sample are drawn in a thin line either side of the average.
+    */
+    average.update();
+    
+    int num_periods = average.getNumPeriods();
+    if(num_periods == 0) {
+        return;
+    }
+    
+    bool visible[ChaosCapture::NUM_CHANNELS] = { x1Visible, x2Visible, x3Visible };
+    for(int c = 0; c < ChaosCapture::NUM_CHANNELS; c++) {
+        if(!visible[c]) {
+            continue;
+        }
+        if(show_envelope) {
+            buffer->SetPen(envelope_pens[c]);
+            drawTrace(average.getMinimum(c), x_scale, y_scale);
+            drawTrace(average.getMaximum(c), x_scale, y_scale);
+        }
+        buffer->SetPen(trace_pens[c]);
+        drawTrace(average.getMean(c), x_scale, y_scale);
+    }
+}
+
+void XTPlot::drawTrace(const float* values, float x_scale, float y_scale) {
+    /**
+    *   Draws AVERAGE_POINTS ADC values as one line with the current pen
+    */
+    for(int i = 0; i < AVERAGE_POINTS; i++) {
+        trace_points[i].x = (int)(x_scale*i) + side_gutter_size + 1;
+        trace_points[i].y = graph_height + top_gutter_size - int(values[i]*y_scale);
+    }
+    buffer->DrawLines(AVERAGE_POINTS, trace_points);
+}
+
+void XTPlot::setAveraging(bool averaging) {
+    /**
+    *   Switches between the latest capture and the average of the periods.
+    *   The average starts again every time it is switched on.
+    */
+    if(averaging && !this->averaging) {
+        average.clear();
+    }
+    this->averaging = averaging;
+    invalidate();
+}
+
+void XTPlot::setShowEnvelope(bool show) {
+    /**
+    *   Shows or hides the min/max envelope of the averaged periods
+    */
+    show_envelope = show;
+    invalidate();
+}
+
 void XTPlot::setX1Visibility(bool visible) {
     /**
     *   Enables or disables the visibility of X on the graph
     */
     x1Visible = visible;
+    invalidate();
 }
 
 void XTPlot::setX2Visibility(bool visible) {
@@ -132,6 +243,7 @@ void XTPlot::setX2Visibility(bool visible) {
     *   Enables or disables the visibility of X' on the graph
     */
     x2Visible = visible;
+    invalidate();
 }
 
 void XTPlot::setX3Visibility(bool visible) {
@@ -139,6 +251,32 @@ void XTPlot::setX3Visibility(bool visible) {
     *   Enables or disables the visibility of X'' on the graph
     */
     x3Visible = visible;
+    invalidate();
+}
+
+void XTPlot::setDerivedChannel(int channel) {
+    /**
+    *   Sets the derived channel drawn along with the device channels,
+    *   -1 for none.  It is not part of the average.
+    */
+    derived_channel = channel;
+    invalidate();
+}
+
+void XTPlot::setSpan(int span) {
+    /**
+    *   Sets the number of samples of a capture shown across the plot.
+    *   The average always shows AVERAGE_POINTS samples.
+    */
+    this->span = span;
+    invalidate();
+}
+
+int XTPlot::getSpan() {
+    /**
+    *   Returns the number of samples of a capture shown across the plot
+    */
+    return span;
 }
 
 int XTPlot::yToValue(int y) {
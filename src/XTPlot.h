@@ -8,6 +8,8 @@
 
 #include "ChaosPlot.h"
 #include "libchaos.h"
+#include "CoherentAverage.h"
+#include "ChaosCapture.h"
 
 class XTPlot : public ChaosPlot
 {
@@ -23,11 +25,41 @@ class XTPlot : public ChaosPlot
         void setX1Visibility(bool visible); 
         void setX2Visibility(bool visible);
         void setX3Visibility(bool visible);
+        void setAveraging(bool averaging);
+        void setShowEnvelope(bool show);
+        void setDerivedChannel(int channel);
+        void setSpan(int span);
+        int getSpan();
         int yToValue(int y);
     private:
+        void drawChannel(int channel, int start, int num_points, float x_scale, float y_scale);
+        void drawAverage(float x_scale, float y_scale);
+        void drawTrace(const float* values, float x_scale, float y_scale);
+        
         bool x1Visible;
         bool x2Visible;
         bool x3Visible;
+        
+        // Pens made once for the life of the plot, one per device channel
+        // for the traces and the envelope and one for the derived channel
+        wxPen trace_pens[ChaosCapture::NUM_CHANNELS];
+        wxPen envelope_pens[ChaosCapture::NUM_CHANNELS];
+        wxPen derived_pen;
+        
+        // Derived channel drawn as well, -1 for none
+        int derived_channel;
+        
+        // Samples of a capture shown across the plot
+        int span;
+        wxPoint* decimated_points;
+        int allocated_points;
+        
+        // Coherent averaging of the periods lined up on the trigger
+        bool averaging;
+        bool show_envelope;
+        int old_mdac;
+        CoherentAverage average;
+        wxPoint trace_points[AVERAGE_POINTS];
 };
 
 #endif // XTPLOT_H
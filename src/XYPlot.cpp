@@ -5,6 +5,8 @@
 
 #include "XYPlot.h"
 #include "ChaosSettings.h"
+#include "ChaosCapture.h"
+#include "ChaosChannels.h"
 
 // class constructor
 XYPlot::XYPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
@@ -19,6 +21,13 @@ XYPlot::XYPlot(wxWindow* parent, wxWindowID id, const wxPoint& pos,
     smallest_y_value = 0;
     largest_x_value = 1024;
     largest_y_value = 1024;
+    x_channel = ChaosCapture::X1;
+    y_channel = ChaosCapture::X2;
+    phosphor = false;
+    phosphor_generation = 0;
+    for(int i = 0; i < 6; i++) {
+        phosphor_view[i] = 0;
+    }
     graph_title = wxT("Phase Portrait");
     graph_subtitle = wxT("-X' (V) vs. X (V)");
     zoomable_graph = true;
@@ -35,36 +44,28 @@ void XYPlot::drawPlot() {
     *   Main drawing function for the XYPlot class.
     *
     *   Calculates the units for the axis and then draws them
-    *   Draws an XY phase portrait by graphing -X' vs. X
+    *   Draws an XY phase portrait by graphing -X' vs. X, or any two of
+    *   the channels in ChaosChannels chosen with setChannels().  The trace
+    *   is drawn into the raster rather than a segment at a time.
     *
     *   All size & plotting related functions should be handled using
     *   the 'smallest/largest_x/y_value' variables. These variables control
     *   the zooming on the graph.
     */
-    int x1,x2,x1_old,x2_old,x3;
-    
     startDraw();
     float x_min, x_max;
     float y_min, y_max;
-    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-        graph_subtitle = wxT("-X' (V) vs. X (V)");
-        y_min = smallest_y_value*3.3/1024;
-        y_max = largest_y_value*3.3/1024;
-        x_min = smallest_x_value*3.3/1024;
-        x_max = largest_x_value*3.3/1024;
-    } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-        graph_subtitle = wxT("-X' (V) vs. X (V)");
-        y_min = smallest_y_value*3.3/1024 - 1.2;
-        y_max = largest_y_value*3.3/1024 - 1.2;
-        x_min = smallest_x_value*3.3/1024 - 1.2;
-        x_max = largest_x_value*3.3/1024 - 1.2;
-    } else {
-        graph_subtitle = wxT("-X' (ADC) vs. X (ADC)");
-        y_min = smallest_y_value;
-        y_max = largest_y_value;
-        x_min = smallest_x_value;
-        x_max = largest_x_value;
+    const wxChar* units = wxT("V");
+    if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_ADC) {
+        units = wxT("ADC");
     }
+    graph_subtitle = wxString::Format(wxT("%s (%s) vs. %s (%s)"),
+                                      axisName(y_channel).c_str(), units,
+                                      axisName(x_channel).c_str(), units);
+    y_min = ChaosChannels::toUnits(y_channel, smallest_y_value);
+    y_max = ChaosChannels::toUnits(y_channel, largest_y_value);
+    x_min = ChaosChannels::toUnits(x_channel, smallest_x_value);
+    x_max = ChaosChannels::toUnits(x_channel, largest_x_value);
     
     drawYAxis(y_min, y_max, (y_max-y_min)/6.0);
               
@@ -75,35 +76,113 @@ void XYPlot::drawPlot() {
         return;
     }
     
-    //Use red pen
-    wxPen pen(*wxRED, 1); // red pen of width 1
-    buffer->SetPen(pen);
+    int num_points = ChaosCapture::getNumPoints();
+    const short* x_data = ChaosChannels::getChannel(x_channel);
+    const short* y_data = ChaosChannels::getChannel(y_channel);
     
-    // Get first plot point
-    libchaos_getPlotPoint(&x1,&x2,&x3, 0);
-    x1 = valueToX(x1);
-    x2 = valueToY(x2);
-    x1_old = x1;
-    x2_old = x2;
+    wxPoint* points = raster.getPoints(num_points);
+    for(int i = 0; i < num_points; i++) {
+        points[i].x = valueToX(x_data[i]);
+        points[i].y = valueToY(y_data[i]);
+    }
     
-    for(int i = 1; i < libchaos_getNumPlotPoints(); i++) {
-        libchaos_getPlotPoint(&x1,&x2,&x3, i);
-        x1 = valueToX(x1);
-        x2 = valueToY(x2);
-        if(x1 > side_gutter_size && 
-           x2 < (graph_height+top_gutter_size) && x2 > top_gutter_size &&
-           x1_old > side_gutter_size && 
-           x2_old < (graph_height+top_gutter_size) && x2_old > top_gutter_size) {
-            buffer->DrawLine(x1_old,x2_old,x1,x2);
-        }
-        x1_old = x1;
-        x2_old = x2;
+    startRaster();
+    if(phosphor) {
+        drawPhosphor(points, num_points);
+    } else {
+        raster.setColour(*wxRED);
+        raster.drawLines(points, num_points);
     }
+    endRaster();
     
     // Display buffer
     endDraw();
 }
 
+void XYPlot::drawPhosphor(const wxPoint* points, int num_points) {
+    /**
+    *   Adds each new capture to the phosphor buffer after dimming what is
+    *   already there, then colours the raster from it.  The buffer starts
+    *   again whenever the view changes, as what it holds no longer lines
+    *   up with the axes.
+    */
+    int view[6] = { smallest_x_value, largest_x_value, smallest_y_value, 
+                    largest_y_value, x_channel, y_channel };
+    bool view_changed = false;
+    for(int i = 0; i < 6; i++) {
+        if(view[i] != phosphor_view[i]) {
+            view_changed = true;
+            phosphor_view[i] = view[i];
+        }
+    }
+    
+    phosphor_buffer.resize(graph_width - 1, graph_height - 1);
+    if(view_changed) {
+        phosphor_buffer.clear();
+    }
+    if(phosphor_generation != ChaosCapture::getGeneration()) {
+        phosphor_generation = ChaosCapture::getGeneration();
+        phosphor_buffer.decay();
+        phosphor_buffer.addLines(points, num_points, side_gutter_size + 1, top_gutter_size + 1);
+    }
+    raster.drawLevels(phosphor_buffer.getLevels(), phosphor_buffer.getColourMap());
+}
+
+void XYPlot::setPhosphor(bool enabled) {
+    /**
+    *   Switches between drawing the latest capture and the phosphor,
+    *   which starts dark each time it is switched on
+    */
+    if(enabled && !phosphor) {
+        phosphor_buffer.clear();
+    }
+    phosphor = enabled;
+    invalidate();
+}
+
+void XYPlot::setPersistence(float persistence) {
+    /**
+    *   Sets the fraction of its brightness the phosphor keeps from one
+    *   capture to the next
+    */
+    phosphor_buffer.setPersistence(persistence);
+    invalidate();
+}
+
+wxString XYPlot::axisName(int channel) {
+    /**
+    *   Returns the label for a channel on an axis.  The circuit inverts
+    *   X', which is why it is labelled -X'.
+    */
+    if(channel == ChaosCapture::X2) {
+        return wxT("-X'");
+    }
+    return ChaosChannels::getName(channel);
+}
+
+void XYPlot::setChannels(int x_channel, int y_channel) {
+    /**
+    *   Sets the channels drawn along each axis
+    */
+    this->x_channel = x_channel;
+    this->y_channel = y_channel;
+    invalidate();
+}
+
+int XYPlot::getXChannel() {
+    /**
+    *   Returns the channel drawn along the x axis
+    */
+    return x_channel;
+}
+
+int XYPlot::getYChannel() {
+    /**
+    *   Returns the channel drawn along the y axis
+    */
+    return y_channel;
+}
+
 int XYPlot::xToValue(int x) {
     /**
     *   Converts an x point on the graph to an ADC value.
@@ -161,13 +240,8 @@ void XYPlot::UpdateStatusBar(int m_x, int m_y) {
         x = xToValue(m_x);
         y = yToValue(m_y);
         
-        if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VBIAS) {
-            y = y*3.3/1024 - 1.2;
-            x = x*3.3/1024 - 1.2;
-        } else if(ChaosSettings::YAxisLabels == ChaosSettings::Y_AXIS_VGND) {
-            y = y*3.3/1024;
-            x = x*3.3/1024;
-        }
+        y = ChaosChannels::toUnits(y_channel, y);
+        x = ChaosChannels::toUnits(x_channel, x);
         
         statusBar->SetStatusText(wxString::Format(wxT("(%.3f,%.3f)"),
                                         x,
@@ -8,6 +8,7 @@
 
 #include "ChaosPlot.h"
 #include "libchaos.h"
+#include "PhosphorBuffer.h"
 
 class XYPlot : public ChaosPlot 
 {
@@ -22,14 +23,31 @@ class XYPlot : public ChaosPlot
         // class destructor
         ~XYPlot();
         void drawPlot();
+        void setChannels(int x_channel, int y_channel);
+        int getXChannel();
+        int getYChannel();
+        void setPhosphor(bool enabled);
+        void setPersistence(float persistence);
     
     private:
+        wxString axisName(int channel);
+        void drawPhosphor(const wxPoint* points, int num_points);
         int xToValue(int x);
         int yToValue(int y);
         int valueToX(int value);
         int valueToY(int value);
         void UpdateStatusBar(int m_x, int m_y);
         void zoomDefault();
+        
+        // Channels drawn along each axis
+        int x_channel;
+        int y_channel;
+        
+        // Trajectories glowing and fading over many captures
+        bool phosphor;
+        PhosphorBuffer phosphor_buffer;
+        unsigned int phosphor_generation;
+        int phosphor_view[6];
 };
 
 #endif // XYPLOT_H